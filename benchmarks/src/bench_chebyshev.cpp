@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ephemeris.h"
+
+extern "C"
+{
+#include "eph_manager.h"
+}
+
+#include "bench_harness.h"
+
+namespace {
+
+	const long batch = 64;
+
+	// Interpolates one body's series from a single record held in memory, per epoch through 'interpolate' and in
+	// batches through 'interpolate_epochs', with each kernel. Epochs are spread over the record so that consecutive
+	// calls never share polynomial values.
+	n_json body_kernels (bench_options const& opts, ephemeris_reader& reader, short target)
+	{
+		ephem_reader* r = reader.handle ();
+
+		double* record = r->preload;
+		double* buf = &record[r->ipt[0][target] - 1];
+		long ncf = r->ipt[1][target];
+		long na = r->ipt[2][target];
+		double span = r->ss[2];
+
+		std::vector<double> t (batch);
+		for (long e = 0; e < batch; ++e) {
+			t[e] = std::fmod (0.6180339887 * (double)(e + 1), 1.0);
+		}
+
+		std::vector<double> pos (3 * batch), vel (3 * batch), ref_pos (3 * batch), ref_vel (3 * batch);
+		const long calls = std::max (1L, opts.iterations / batch);
+
+		n_json rv;
+		rv["ncf"] = ncf;
+		rv["na"] = na;
+
+		const short initial = ephem_kernel ();
+
+		for (short kernel : { (short)EPH_KERNEL_SCALAR, (short)EPH_KERNEL_AVX2 }) {
+			if (ephem_select_kernel (kernel) != kernel)
+				continue;
+
+			std::string name = (kernel == EPH_KERNEL_AVX2) ? "avx2" : "scalar";
+
+			rv[name]["ns_per_epoch_interpolate"] = ns_per_call ([&](long) {
+				for (long e = 0; e < batch; ++e) {
+					double tt[2] = { t[e], span };
+					interpolate (buf, tt, ncf, na, &pos[3 * e], &vel[3 * e]);
+				}
+				bench_sink = bench_sink + pos[0];
+			}, calls) / (double)batch;
+
+			if (kernel == EPH_KERNEL_SCALAR) {
+				ref_pos = pos;
+				ref_vel = vel;
+			}
+
+			rv[name]["ns_per_epoch_batch"] = ns_per_call ([&](long) {
+				interpolate_epochs (buf, t.data (), batch, span, ncf, na, pos.data (), vel.data ());
+				bench_sink = bench_sink + pos[0];
+			}, calls) / (double)batch;
+
+			double max_diff = 0;
+			for (long k = 0; k < 3 * batch; ++k) {
+				max_diff = std::max ({ max_diff, std::fabs (pos[k] - ref_pos[k]), std::fabs (vel[k] - ref_vel[k]) });
+			}
+			rv[name]["max_abs_diff_vs_scalar_interpolate"] = max_diff;
+		}
+
+		ephem_select_kernel (initial);
+		return rv;
+	}
+
+	n_json chebyshev_kernels (bench_options const& opts)
+	{
+		ephemeris_reader reader (opts.ephemeris_path, ephemeris_access::buffered);
+		double mid = (reader.eph_begin () + reader.eph_end ()) / 2.0;
+		reader.preload (mid, mid);
+
+		n_json rv;
+		rv["moon"] = body_kernels (opts, reader, 9);
+		rv["mercury"] = body_kernels (opts, reader, 0);
+		rv["sun"] = body_kernels (opts, reader, 10);
+		rv["saturn"] = body_kernels (opts, reader, 5);
+		return rv;
+	}
+}
+
+void register_chebyshev_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "chebyshev.kernels", chebyshev_kernels });
+}
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+#include "ephemeris.h"
+
+extern "C"
+{
+#include "eph_manager.h"
+}
+
+#include "bench_harness.h"
+
+namespace {
+
+	const short moon_target = 9; // eph_manager numbering: geocentric Moon
+
+	// Evaluate the Moon from a fixed set of records, forcing a record switch on every call, and within a single record.
+	n_json record_switch_cost (bench_options const& opts, ephemeris_access access)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, access);
+
+		const double record_span = 32.0; // days per DE430 record
+		const long records = std::min (64L, (long)((em.eph_end () - em.eph_begin ()) / record_span) - 1);
+		const double first_mid = em.eph_begin () + record_span / 2.0;
+
+		double pos[3], vel[3];
+
+		auto switching = [&](long i) {
+			double jed[2] = { first_mid + record_span * (double)(i % records), 0.25 * (double)(i & 1) };
+			state (jed, moon_target, pos, vel);
+			bench_sink = bench_sink + pos[0];
+		};
+
+		auto same_record = [&](long i) {
+			double jed[2] = { first_mid, 0.25 * (double)(i & 1) };
+			state (jed, moon_target, pos, vel);
+			bench_sink = bench_sink + pos[0];
+		};
+
+		// Touch every record once so both modes start from a warm page cache.
+		ns_per_call (switching, records);
+
+		n_json rv;
+		rv["ns_per_state_switching_record"] = ns_per_call (switching, opts.iterations);
+		rv["ns_per_state_same_record"] = ns_per_call (same_record, opts.iterations);
+		rv["ns_per_record_switch"] = rv["ns_per_state_switching_record"].get<double> () - rv["ns_per_state_same_record"].get<double> ();
+		return rv;
+	}
+
+	// Moon, Sun and Mars interleaved over epochs spread across 'span' adjacent records, as a multi-day query or a root
+	// finder iterating across a record boundary does; compares record cache sizes.
+	n_json record_cache (bench_options const& opts)
+	{
+		const short targets[] = { 9, 10, 3 };
+		const double record_span = 32.0;
+
+		n_json rv;
+
+		for (long span : { 2L, 3L, 6L }) {
+			for (long records : { 1L, 2L, 4L, 8L }) {
+				ephemeris_reader reader (opts.ephemeris_path, ephemeris_access::buffered);
+				reader.set_cache_size (records);
+
+				const double first = reader.eph_begin () + record_span * 100.0;
+				double pos[3], vel[3];
+
+				double ns = ns_per_call ([&](long i) {
+					double jed[2] = { first + record_span * (double)(i % span) + 16.0, 0.01 * (double)(i % 97) };
+					state (reader, jed, targets[i % 3], pos, vel);
+					bench_sink = bench_sink + pos[0];
+				}, opts.iterations);
+
+				n_json r;
+				r["ns_per_state"] = ns;
+				r["hits"] = reader.cache_hits ();
+				r["misses"] = reader.cache_misses ();
+				rv[std::to_string (span) + "_records_touched"][std::to_string (records) + "_cached"] = r;
+			}
+		}
+
+		return rv;
+	}
+
+	// Moon and Sun at scattered epochs within a window of 'window_records' records, as a service answering queries over
+	// a fixed date range does; compares buffered, mapped and preloaded readers, and reports the preload time and size.
+	n_json preload_window (bench_options const& opts)
+	{
+		const double record_span = 32.0;
+		const long window_records = 256;
+
+		n_json rv;
+
+		for (int mode = 0; mode < 3; ++mode) {
+			ephemeris_reader reader (opts.ephemeris_path, (mode == 1) ? ephemeris_access::mapped : ephemeris_access::buffered);
+
+			const long records = std::min (window_records, (long)((reader.eph_end () - reader.eph_begin ()) / record_span) - 1);
+			const double first = reader.eph_begin ();
+			const double last = first + record_span * (double)records;
+
+			n_json r;
+
+			if (mode == 2) {
+				auto start = std::chrono::steady_clock::now ();
+				reader.preload (first, last);
+				auto stop = std::chrono::steady_clock::now ();
+				r["preload_ms"] = std::chrono::duration<double, std::milli> (stop - start).count ();
+				r["preloaded_records"] = reader.preloaded_records ();
+				r["preloaded_bytes"] = reader.preloaded_records () * reader.handle ()->record_length;
+			}
+
+			double pos[3], vel[3];
+			unsigned long seed = 12345;
+
+			r["ns_per_state"] = ns_per_call ([&](long i) {
+				seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+				double jed[2] = { first + (last - first - 1.0) * (double)(seed >> 11) / 9007199254740992.0, 0.0 };
+				state (reader, jed, (i & 1) ? 10 : moon_target, pos, vel);
+				bench_sink = bench_sink + pos[0];
+			}, opts.iterations);
+
+			rv[(mode == 0) ? "buffered" : (mode == 1) ? "mapped" : "preloaded"] = r;
+		}
+
+		return rv;
+	}
+
+	// A month of Moon epochs on a ten minute grid, as a rise/set or phase search samples it, through one state() call
+	// per epoch and through one state_batch() call, in time order and shuffled. The reader keeps a single record, so
+	// 'records_read' counts every record switch.
+	n_json state_batch_grid (bench_options const& opts)
+	{
+		const std::size_t n = 30 * 144;
+
+		n_json rv;
+
+		for (bool shuffled : { false, true }) {
+			ephemeris_reader reader (opts.ephemeris_path, ephemeris_access::buffered);
+			reader.set_cache_size (1);
+
+			std::vector<double> jd (n);
+			for (std::size_t i = 0; i < n; ++i) {
+				jd[i] = reader.eph_begin () + 1000.0 + (double)i / 144.0;
+			}
+			if (shuffled) {
+				for (std::size_t i = n - 1; i > 0; --i) {
+					std::swap (jd[i], jd[(i * 7919) % (i + 1)]);
+				}
+			}
+
+			std::vector<double> pos (3 * n), vel (3 * n), batch_pos (3 * n), batch_vel (3 * n);
+			const long calls = std::max (1L, opts.iterations / (long)n);
+
+			n_json r;
+
+			reader.reset_cache_stats ();
+			r["ns_per_epoch_state"] = ns_per_call ([&](long) {
+				for (std::size_t i = 0; i < n; ++i) {
+					double jed[2] = { jd[i], 0.0 };
+					state (reader, jed, moon_target, &pos[3 * i], &vel[3 * i]);
+				}
+				bench_sink = bench_sink + pos[0];
+			}, calls) / (double)n;
+			r["records_read_per_grid_state"] = reader.cache_misses () / calls;
+
+			reader.reset_cache_stats ();
+			r["ns_per_epoch_state_batch"] = ns_per_call ([&](long) {
+				reader.state_batch (moon_target, jd.data (), n, batch_pos.data (), batch_vel.data ());
+				bench_sink = bench_sink + batch_pos[0];
+			}, calls) / (double)n;
+			r["records_read_per_grid_state_batch"] = reader.cache_misses () / calls;
+
+			double max_diff = 0;
+			for (std::size_t k = 0; k < 3 * n; ++k) {
+				max_diff = std::max ({ max_diff, std::fabs (pos[k] - batch_pos[k]), std::fabs (vel[k] - batch_vel[k]) });
+			}
+			r["max_abs_diff"] = max_diff;
+
+			rv[shuffled ? "shuffled" : "time_order"] = r;
+		}
+
+		return rv;
+	}
+
+	// Bodies evaluated over an eight-record window held in memory at full precision (preload) and as a single-precision
+	// copy (load_single). Reports the time per state() and the largest position difference, in km and relative to the
+	// body's distance from the origin of its series, against the 2^-24 (6.0e-8) coefficient rounding bound. The reader
+	// is not bound to the thread, so the precision is selected through the C interface.
+	n_json single_precision (bench_options const& opts)
+	{
+		const short targets[] = { 2, 3, 4, 9, 10 };
+		const char* names[] = { "earth_moon_barycenter", "mars", "jupiter", "moon", "sun" };
+		const double record_span = 32.0;
+		const double km_per_au = 149597870.7;
+
+		ephemeris_reader reader (opts.ephemeris_path, ephemeris_access::buffered);
+		const double first = reader.eph_begin () + record_span * 100.0;
+		const double span = 8.0 * record_span;
+		reader.preload (first, first + span);
+		reader.load_single (first, first + span);
+
+		n_json rv;
+		rv["records"] = reader.single_records ();
+
+		auto epoch = [&](long i) {
+			return first + std::fmod (0.6180339887 * (double)i, 1.0) * (span - 1.0);
+		};
+
+		for (std::size_t b = 0; b < sizeof (targets) / sizeof (targets[0]); ++b) {
+			double pos[3], vel[3];
+
+			auto timed = [&](short precision) {
+				ephem_set_precision (precision);
+				double ns = ns_per_call ([&](long i) {
+					double jed[2] = { epoch (i), 0.0 };
+					state (reader, jed, targets[b], pos, vel);
+					bench_sink = bench_sink + pos[0];
+				}, opts.iterations);
+				ephem_set_precision (EPH_PRECISION_DOUBLE);
+				return ns;
+			};
+
+			double max_diff = 0, max_r = 0;
+			for (long i = 0; i < 4096; ++i) {
+				double jed[2] = { epoch (i), 0.0 }, full[3], single[3];
+				ephem_set_precision (EPH_PRECISION_DOUBLE);
+				state (reader, jed, targets[b], full, vel);
+				ephem_set_precision (EPH_PRECISION_SINGLE);
+				state (reader, jed, targets[b], single, vel);
+				ephem_set_precision (EPH_PRECISION_DOUBLE);
+				for (int k = 0; k < 3; ++k) {
+					max_diff = std::max (max_diff, std::fabs (full[k] - single[k]));
+				}
+				max_r = std::max (max_r, std::sqrt (full[0] * full[0] + full[1] * full[1] + full[2] * full[2]));
+			}
+
+			n_json r;
+			r["ns_per_state_full"] = timed (EPH_PRECISION_DOUBLE);
+			r["ns_per_state_single"] = timed (EPH_PRECISION_SINGLE);
+			r["max_diff_km"] = max_diff * km_per_au;
+			r["max_diff_relative"] = max_diff / max_r;
+			r["bound_relative"] = std::ldexp (1.0, -24);
+			rv[names[b]] = r;
+		}
+
+		// The Moon at epochs spread over the whole file, which at full precision may not fit in the processor's caches.
+		ephemeris_reader whole (opts.ephemeris_path, ephemeris_access::buffered);
+		whole.preload (whole.eph_begin (), whole.eph_end ());
+		whole.load_single (whole.eph_begin (), whole.eph_end ());
+
+		const double whole_span = whole.eph_end () - whole.eph_begin () - 1.0;
+		double pos[3], vel[3];
+
+		for (short precision : { EPH_PRECISION_DOUBLE, EPH_PRECISION_SINGLE }) {
+			ephem_set_precision (precision);
+			double ns = ns_per_call ([&](long i) {
+				double jed[2] = { whole.eph_begin () + std::fmod (0.6180339887 * (double)i, 1.0) * whole_span, 0.0 };
+				state (whole, jed, moon_target, pos, vel);
+				bench_sink = bench_sink + pos[0];
+			}, opts.iterations);
+			ephem_set_precision (EPH_PRECISION_DOUBLE);
+			rv["whole_file"][(precision == EPH_PRECISION_SINGLE) ? "ns_per_state_single" : "ns_per_state_full"] = ns;
+		}
+		rv["whole_file"]["records"] = whole.single_records ();
+
+		return rv;
+	}
+
+	// Each thread evaluates the Moon through its own ephemeris_reader; reports aggregate throughput per thread count.
+	n_json reader_thread_scaling (bench_options const& opts)
+	{
+		n_json rv;
+
+		const unsigned max_threads = std::max (1u, std::thread::hardware_concurrency ());
+
+		for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+
+			std::vector<std::unique_ptr<ephemeris_reader>> readers;
+			for (unsigned t = 0; t < threads; ++t) {
+				readers.emplace_back (new ephemeris_reader (opts.ephemeris_path));
+			}
+
+			auto start = std::chrono::steady_clock::now ();
+
+			std::vector<std::thread> workers;
+			for (unsigned t = 0; t < threads; ++t) {
+				workers.emplace_back ([&, t]() {
+					ephemeris_reader& reader = *readers[t];
+					double pos[3], vel[3], sum = 0;
+					for (long i = 0; i < opts.iterations; ++i) {
+						double jed[2] = { reader.eph_begin () + 16.0 + 32.0 * (double)(i % 64), 0.001 * (double)(i % 1000) };
+						state (reader, jed, moon_target, pos, vel);
+						sum += pos[0];
+					}
+					bench_sink = bench_sink + sum;
+				});
+			}
+			for (auto& w : workers) {
+				w.join ();
+			}
+
+			auto stop = std::chrono::steady_clock::now ();
+			double secs = std::chrono::duration<double> (stop - start).count ();
+
+			rv[std::to_string (threads) + "_threads"]["states_per_sec"] = (double)threads * (double)opts.iterations / secs;
+		}
+
+		return rv;
+	}
+}
+
+void register_ephemeris_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "ephemeris.record_switch", [](bench_options const& opts) {
+		n_json rv;
+		rv["buffered"] = record_switch_cost (opts, ephemeris_access::buffered);
+		rv["mapped"] = record_switch_cost (opts, ephemeris_access::mapped);
+		return rv;
+	} });
+
+	benchmarks.push_back ({ "ephemeris.record_cache", record_cache });
+	benchmarks.push_back ({ "ephemeris.preload_window", preload_window });
+	benchmarks.push_back ({ "ephemeris.state_batch", state_batch_grid });
+	benchmarks.push_back ({ "ephemeris.single_precision", single_precision });
+	benchmarks.push_back ({ "ephemeris.reader_threads", reader_thread_scaling });
+}
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "astro_calc.h"
+#include "ephemeris.h"
+#include "novas_utils.h"
+#include "zbrent.h"
+
+#include "bench_harness.h"
+
+namespace {
+
+	double seconds_since (std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+	}
+
+	// Rise, set and culminations of the Moon over thirty days for many sites, one find_planetary_events call per site
+	// against a single call for all of them. Sites are spread over latitudes -60 to 60 and all longitudes; their number
+	// is iterations / 5000 (between 4 and 256). max_dt_s is the largest difference between the event times of the two.
+	n_json rise_set_sites (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double first = std::max (em.eph_begin () + 1.0, 2458849.5); // 2020-01-01, where finals data exist
+		const double last = first + 30.0;
+		const long sites = std::clamp (opts.iterations / 5000, 4L, 256L);
+
+		std::vector<on_surface> locs;
+		for (long i = 0; i < sites; ++i) {
+			on_surface loc;
+			make_on_surface (-60.0 + 120.0 * (double)i / (double)sites, -180.0 + 360.0 * std::fmod (0.618034 * (double)i, 1.0), 0.0, 10.0, 1010.0, &loc);
+			locs.push_back (loc);
+		}
+
+		auto start = std::chrono::steady_clock::now ();
+		std::vector<std::vector<planetary_event>> per_site;
+		for (auto& loc : locs)
+			per_site.push_back (novas_utils::find_planetary_events (first, last, novas_constants::MOON, loc));
+		const double per_site_s = seconds_since (start);
+
+		start = std::chrono::steady_clock::now ();
+		std::vector<std::vector<planetary_event>> batch = novas_utils::find_planetary_events (first, last, novas_constants::MOON, locs);
+		const double batch_s = seconds_since (start);
+
+		double max_dt = 0.0;
+		long events = 0, mismatched_sites = 0;
+		for (std::size_t s = 0; s < locs.size (); ++s) {
+			if (per_site[s].size () != batch[s].size ()) {
+				++mismatched_sites;
+				continue;
+			}
+			for (std::size_t e = 0; e < batch[s].size (); ++e)
+				max_dt = std::max (max_dt, std::fabs (per_site[s][e].event_time - batch[s][e].event_time) * 86400.0);
+			events += (long)batch[s].size ();
+		}
+
+		n_json rv;
+		rv["sites"] = sites;
+		rv["events"] = events;
+		rv["ms_per_site_separately"] = per_site_s * 1000.0 / (double)sites;
+		rv["ms_per_site_batch"] = batch_s * 1000.0 / (double)sites;
+		rv["speedup"] = per_site_s / batch_s;
+		rv["mismatched_sites"] = mismatched_sites;
+		rv["max_dt_s"] = max_dt;
+		return rv;
+	}
+
+	// The elevation and azimuth find_planetary_events brackets, and the phase longitude find_new_and_full_moons brackets,
+	// counting the evaluations.
+	struct counted_event_functions {
+		novas_planet planet;
+		on_surface loc;
+		object obj;
+		observer surface;
+		long evaluations = 0;
+
+		counted_event_functions (novas_planet planet, on_surface loc) : planet (planet), loc (loc), obj (novas_utils::build_planet_object (planet))
+		{
+			make_observer_on_surface (loc.latitude, loc.longitude, loc.height, loc.temperature, loc.pressure, &surface);
+		}
+
+		novas_wrapper::horizon_coords hc_at_time (double jd_utc, sky_pos& place)
+		{
+			++evaluations;
+			astro_time at = astro_time::from_utc (jd_utc);
+			place = novas_wrapper::w_place (at, obj, surface, novas_constants::coord_equ, novas_constants::accuracy);
+			auto [pm_x, pm_y] = at.polar_motion ();
+			return novas_wrapper::w_equ2hor (at, place, novas_constants::accuracy, pm_x, pm_y, loc, novas_constants::refraction);
+		}
+
+		double el (double jd_utc)
+		{
+			sky_pos place;
+			novas_wrapper::horizon_coords hc = hc_at_time (jd_utc, place);
+			return hc.zd + to_degrees (2 * std::atan (planet.diameter_km / (2 * au_to_km (place.dis)))) / 2.0;
+		}
+
+		double az (double jd_utc)
+		{
+			sky_pos place;
+			return hc_at_time (jd_utc, place).az - 180;
+		}
+
+		double phase_lon (double jd_utc)
+		{
+			++evaluations;
+			astro_time at = astro_time::from_utc (jd_utc);
+			return novas_utils::get_moon_phase (at).sun_earth_angle_long;
+		}
+	};
+
+	// Brackets and refines the roots of 'fx' over [first, last] on the fixed grid of 'slices' (zbrak) or, if slices is 0,
+	// with zbrak_adaptive and 'rate'; returns the roots.
+	template <typename F>
+	std::vector<double> find_roots (F& fx, double first, double last, int slices, bracket_rate const& rate)
+	{
+		std::vector<double> xb1, xb2, roots;
+		int nroot = 0;
+		if (slices > 0)
+			zbrak (fx, first, last, slices, xb1, xb2, nroot);
+		else
+			zbrak_adaptive (fx, first, last, rate, xb1, xb2, nroot);
+		for (int i = 0; i < nroot; ++i)
+			roots.push_back (zbrent (fx, xb1[i], xb2[i], std::numeric_limits<double>::epsilon () * 100));
+		return roots;
+	}
+
+	// Function evaluations per event found by the rise/set and moon phase searches: the fixed grids they used (floor
+	// (8 * days) elevation slices, 124 azimuth slices, 120 moon phase slices) against zbrak_adaptive with the bracket
+	// rates of novas_utils, over a range of bodies, sites and spans, evaluations counted through bracketing and
+	// refinement. missed_* count events one search finds that the other does not (times within a minute match).
+	n_json bracketing (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double start = 2458484.5; // 2019-01-01, where finals data exist
+		const novas_planet bodies[] = { novas_constants::MOON, novas_constants::SUN, novas_constants::MARS, novas_constants::PLUTO };
+		const double latitudes[] = { 0.0, 41.25, 65.0 };
+		const double spans[] = { 0.5, 3.0, 30.0 };
+
+		auto count_missed = [](std::vector<double> const& found, std::vector<double> const& reference) {
+			long missed = 0;
+			for (double t : reference) {
+				if (std::none_of (found.begin (), found.end (), [t](double u) { return std::fabs (u - t) < 1.0 / 1440.0; }))
+					++missed;
+			}
+			return missed;
+		};
+
+		n_json rv;
+		for (double span : spans) {
+			long evals_fixed = 0, evals_adaptive = 0, events_fixed = 0, events_adaptive = 0, missed_fixed = 0, missed_adaptive = 0;
+
+			for (auto const& body : bodies) {
+				for (double lat : latitudes) {
+					on_surface loc;
+					make_on_surface (lat, -122.95, 0.0, 10.0, 1010.0, &loc);
+
+					counted_event_functions fixed (body, loc), adaptive (body, loc);
+					auto fixed_el = [&](double t) { return fixed.el (t); };
+					auto fixed_az = [&](double t) { return fixed.az (t); };
+					auto adaptive_el = [&](double t) { return adaptive.el (t); };
+					auto adaptive_az = [&](double t) { return adaptive.az (t); };
+
+					std::vector<double> a = find_roots (fixed_el, start, start + span, (int)std::floor (8 * span), bracket_rate ());
+					std::vector<double> az = find_roots (fixed_az, start, start + span, 31 * 4, bracket_rate ());
+					a.insert (a.end (), az.begin (), az.end ());
+
+					std::vector<double> b;
+					for (double d = start; d < start + span; d += 1.0) {
+						std::vector<double> el = find_roots (adaptive_el, d, std::min (d + 1.0, start + span), 0, novas_utils::elevation_bracket_rate (body, loc));
+						az = find_roots (adaptive_az, d, std::min (d + 1.0, start + span), 0, novas_utils::azimuth_bracket_rate (body));
+						b.insert (b.end (), el.begin (), el.end ());
+						b.insert (b.end (), az.begin (), az.end ());
+					}
+
+					evals_fixed += fixed.evaluations;
+					evals_adaptive += adaptive.evaluations;
+					events_fixed += (long)a.size ();
+					events_adaptive += (long)b.size ();
+					missed_fixed += count_missed (a, b);
+					missed_adaptive += count_missed (b, a);
+				}
+			}
+
+			n_json r;
+			r["events_fixed"] = events_fixed;
+			r["events_adaptive"] = events_adaptive;
+			r["evals_per_event_fixed"] = (double)evals_fixed / (double)std::max (1L, events_fixed);
+			r["evals_per_event_adaptive"] = (double)evals_adaptive / (double)std::max (1L, events_adaptive);
+			r["missed_fixed"] = missed_fixed;
+			r["missed_adaptive"] = missed_adaptive;
+			rv["rise_set_" + std::to_string ((int)(span * 24)) + "h"] = r;
+		}
+
+		for (double span : { 30.0, 365.0, 3650.0 }) {
+			counted_event_functions fixed (novas_constants::MOON, on_surface ()), adaptive (novas_constants::MOON, on_surface ());
+			auto fixed_pl = [&](double t) { return fixed.phase_lon (t); };
+			auto adaptive_pl = [&](double t) { return adaptive.phase_lon (t); };
+
+			std::vector<double> a = find_roots (fixed_pl, start, start + span, 120, bracket_rate ());
+			std::vector<double> b = find_roots (adaptive_pl, start, start + span, 0, novas_utils::moon_phase_bracket_rate ());
+
+			n_json r;
+			r["events_fixed"] = a.size ();
+			r["events_adaptive"] = b.size ();
+			r["evals_per_event_fixed"] = (double)fixed.evaluations / (double)std::max<std::size_t> (1, a.size ());
+			r["evals_per_event_adaptive"] = (double)adaptive.evaluations / (double)std::max<std::size_t> (1, b.size ());
+			r["missed_fixed"] = count_missed (a, b);
+			r["missed_adaptive"] = count_missed (b, a);
+			rv["moon_phases_" + std::to_string ((int)span) + "d"] = r;
+		}
+		return rv;
+	}
+
+	// Refinement of the brackets the rise/set and moon phase searches find: zbrent on the function values against
+	// zbrent_newton on the values and rates of the batch functions of novas_utils, one query at a time, counting the
+	// evaluations each makes and timing them. The brackets are those of zbrak_adaptive over 30 days (rise/set, for
+	// several bodies and sites) and a year (moon phases). max_dt_ms is the largest difference between the roots of
+	// the two.
+	n_json refinement (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double start = 2458484.5; // 2019-01-01, where finals data exist
+		const double tol = std::numeric_limits<double>::epsilon () * 100;
+
+		novas_wrapper::context ctx;
+		novas_wrapper::context_binding binding (ctx);
+
+		struct tally {
+			long events = 0, evals_brent = 0, evals_newton = 0;
+			double brent_s = 0.0, newton_s = 0.0, max_dt = 0.0;
+		};
+
+		// Refines each bracket of 'fx' in [first, last] with both, 'fx' and 'fdx' counting into 'evals'.
+		auto refine = [&](tally& t, long& evals, auto& fx, auto& fdx, double first, double last, bracket_rate const& rate) {
+			std::vector<double> xb1, xb2;
+			int nroot = 0;
+			zbrak_adaptive (fx, first, last, rate, xb1, xb2, nroot);
+			for (int i = 0; i < nroot; ++i) {
+				evals = 0;
+				auto t0 = std::chrono::steady_clock::now ();
+				double a = zbrent (fx, xb1[i], xb2[i], tol);
+				t.brent_s += seconds_since (t0);
+				t.evals_brent += evals;
+
+				evals = 0;
+				t0 = std::chrono::steady_clock::now ();
+				double b = zbrent_newton (fdx, xb1[i], xb2[i], tol, rate.wrap);
+				t.newton_s += seconds_since (t0);
+				t.evals_newton += evals;
+
+				t.max_dt = std::max (t.max_dt, std::fabs (a - b) * 86400.0e3);
+				++t.events;
+			}
+		};
+
+		auto report = [](tally const& t) {
+			n_json r;
+			r["events"] = t.events;
+			r["evals_per_event_brent"] = (double)t.evals_brent / (double)std::max (1L, t.events);
+			r["evals_per_event_newton"] = (double)t.evals_newton / (double)std::max (1L, t.events);
+			r["us_per_event_brent"] = t.brent_s * 1.0e6 / (double)std::max (1L, t.events);
+			r["us_per_event_newton"] = t.newton_s * 1.0e6 / (double)std::max (1L, t.events);
+			r["max_dt_ms"] = t.max_dt;
+			return r;
+		};
+
+		const novas_planet bodies[] = { novas_constants::MOON, novas_constants::SUN, novas_constants::MARS, novas_constants::PLUTO };
+		const double latitudes[] = { 0.0, 41.25, 65.0 };
+
+		n_json rv;
+		tally rise_set;
+		for (auto const& body : bodies) {
+			for (double lat : latitudes) {
+				on_surface loc;
+				make_on_surface (lat, -122.95, 0.0, 10.0, 1010.0, &loc);
+
+				novas_utils::planetary_event_functions fns (body, loc);
+				novas_utils::planetary_event_batch fxs (body, fns, ctx);
+				long evals = 0;
+				auto el = [&](double t) { ++evals; return fns.el_at_time (t); };
+				auto az = [&](double t) { ++evals; return fns.az_at_time (t); };
+				auto el_rate = [&](double t) { ++evals; return batch_funcd (fxs, novas_utils::planetary_event_batch::elevation, t); };
+				auto az_rate = [&](double t) { ++evals; return batch_funcd (fxs, novas_utils::planetary_event_batch::azimuth, t); };
+
+				for (double d = start; d < start + 30.0; d += 1.0) {
+					refine (rise_set, evals, el, el_rate, d, d + 1.0, novas_utils::elevation_bracket_rate (body, loc));
+					refine (rise_set, evals, az, az_rate, d, d + 1.0, novas_utils::azimuth_bracket_rate (body));
+				}
+			}
+		}
+		rv["rise_set_30d"] = report (rise_set);
+
+		tally moon_phases;
+		long evals = 0;
+		auto pl = [&](double t) { ++evals; astro_time at = astro_time::from_utc (t); return novas_utils::get_moon_phase (at).sun_earth_angle_long; };
+		novas_utils::moon_phase_batch pl_fxs (ctx);
+		auto pl_rate = [&](double t) { ++evals; return batch_funcd (pl_fxs, novas_utils::moon_phase_batch::phase_lon, t); };
+		refine (moon_phases, evals, pl, pl_rate, start, start + 365.0, novas_utils::moon_phase_bracket_rate ());
+		rv["moon_phases_365d"] = report (moon_phases);
+
+		return rv;
+	}
+
+}
+
+void register_events_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "events.rise_set_sites", rise_set_sites });
+	benchmarks.push_back ({ "events.bracketing", bracketing });
+	benchmarks.push_back ({ "events.refinement", refinement });
+}
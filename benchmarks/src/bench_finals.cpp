@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "finals_data_handler.h"
+#include "slurp_file.h"
+
+#include "bench_harness.h"
+
+namespace {
+
+	// The lookup finals_data_for_time made before the day index: a scan from the start of the table for the row of the
+	// day, then linear interpolation to the next row.
+	finals_data scan_for_time (finals_view const& values, double jd_utc)
+	{
+		finals_data rv;
+		rv.julian_utc = jd_utc;
+
+		double base_val = std::floor (jd_utc) + 0.5;
+		double key0 = jd_utc < base_val ? base_val - 1.0 : base_val;
+
+		auto it = std::find_if (values.begin (), values.end (), [key0](finals_data const& fd)->bool {
+			return std::abs (fd.julian_utc - key0) < 0.001;
+		});
+
+		if (it == values.end () || (it + 1) == values.end ())
+			return rv;
+
+		const double f = (jd_utc - it->julian_utc) / ((it + 1)->julian_utc - it->julian_utc);
+		rv.ut1_utc = it->ut1_utc + f * ((it + 1)->ut1_utc - it->ut1_utc);
+		rv.pm_x = it->pm_x + f * ((it + 1)->pm_x - it->pm_x);
+		rv.pm_y = it->pm_y + f * ((it + 1)->pm_y - it->pm_y);
+		return rv;
+	}
+
+	// finals_data_for_time at dates spread over the whole table, against the scan it replaced. The dates are drawn
+	// before timing; mismatches counts the dates whose UT1-UTC or polar motion differ between the two.
+	n_json lookup (bench_options const& opts)
+	{
+		auto& handler = finals_data_handler::instance ();
+		const finals_view values = handler.values ();
+
+		if (values.size () < 2)
+			return { { "error", "no finals data" } };
+
+		const double first = values.front ().julian_utc;
+		const double span = values.back ().julian_utc - first;
+
+		std::vector<double> dates (4096);
+		for (std::size_t i = 0; i < dates.size (); ++i)
+			dates[i] = first + span * std::fmod (0.618034 * (double)i, 1.0);
+
+		long mismatches = 0;
+		for (double jd : dates) {
+			finals_data a = handler.finals_data_for_time (jd);
+			finals_data b = scan_for_time (values, jd);
+			if (a.ut1_utc != b.ut1_utc || a.pm_x != b.pm_x || a.pm_y != b.pm_y)
+				++mismatches;
+		}
+
+		const long scans = std::max (1L, opts.iterations / 100);
+
+		n_json rv;
+		rv["rows"] = values.size ();
+		rv["ns_per_lookup_scan"] = ns_per_call ([&](long i) {
+			bench_sink = bench_sink + scan_for_time (values, dates[i % dates.size ()]).ut1_utc;
+		}, scans);
+		rv["ns_per_lookup_indexed"] = ns_per_call ([&](long i) {
+			bench_sink = bench_sink + handler.finals_data_for_time (dates[i % dates.size ()]).ut1_utc;
+		}, opts.iterations);
+		rv["speedup"] = rv["ns_per_lookup_scan"].get<double> () / rv["ns_per_lookup_indexed"].get<double> ();
+		rv["mismatches"] = mismatches;
+		return rv;
+	}
+
+	// The parser parse_finals_data used before it read fields in place: each field copied into a string and read with
+	// std::stod, the end of the data found by the exception of the first field that does not parse.
+	std::vector<finals_data> stod_parse (std::string const& str)
+	{
+		std::vector<finals_data> values;
+		std::string holder;
+
+		auto field = [&](std::size_t offset, int length) {
+			holder.replace (0, length, str, offset, length);
+			holder.resize (length);
+			return std::stod (holder);
+		};
+
+		auto flag = [&](std::size_t offset) {
+			if (str[offset] == 'I')
+				return false;
+			if (str[offset] == 'P')
+				return true;
+			throw std::runtime_error ("flag");
+		};
+
+		std::size_t line = 0;
+		try {
+			for (std::size_t end = str.find ('\n'); end != std::string::npos; line = end + 1, end = str.find ('\n', line)) {
+				finals_data fd;
+				fd.julian_utc = 2400000.50 + field (line + 7, 8);
+				fd.pm_is_prediction = flag (line + 16);
+				fd.pm_x = field (line + 18, 9);
+				fd.pm_x_err = field (line + 27, 9);
+				fd.pm_y = field (line + 37, 9);
+				fd.pm_y_err = field (line + 46, 9);
+				fd.ut1_utc_is_prediction = flag (line + 57);
+				fd.ut1_utc = field (line + 58, 10);
+				fd.ut1_utc_err = field (line + 68, 10);
+				try {
+					fd.epsilon = field (line + 116, 9);
+					fd.epsilon_err = field (line + 125, 9);
+				}
+				catch (std::exception&) {
+				}
+				values.push_back (fd);
+			}
+		}
+		catch (std::exception&) {
+		}
+		return values;
+	}
+
+	// parse_finals_data on the finals file given with -f, against the stod parser it replaced; rows_differing counts
+	// rows that are not bitwise identical. Leaves the handler holding the file, as main loaded it.
+	n_json parse (bench_options const& opts)
+	{
+		auto& handler = finals_data_handler::instance ();
+		const std::string str = slurpfile (opts.finals_path);
+		const long parses = std::max (1L, opts.iterations / 10000);
+
+		handler.parse_finals_data (str);
+		const finals_view parsed = handler.values ();
+		const std::vector<finals_data> reference = stod_parse (str);
+
+		long rows_differing = (long)std::max (parsed.size (), reference.size ()) - (long)std::min (parsed.size (), reference.size ());
+		for (std::size_t i = 0; i < std::min (parsed.size (), reference.size ()); ++i) {
+			finals_data const& a = parsed[i];
+			finals_data const& b = reference[i];
+			const double af[] = { a.julian_utc, a.pm_x, a.pm_x_err, a.pm_y, a.pm_y_err, a.ut1_utc, a.ut1_utc_err, a.epsilon, a.epsilon_err };
+			const double bf[] = { b.julian_utc, b.pm_x, b.pm_x_err, b.pm_y, b.pm_y_err, b.ut1_utc, b.ut1_utc_err, b.epsilon, b.epsilon_err };
+			if (std::memcmp (af, bf, sizeof (af)) != 0 || a.pm_is_prediction != b.pm_is_prediction || a.ut1_utc_is_prediction != b.ut1_utc_is_prediction)
+				++rows_differing;
+		}
+
+		const double mb = (double)str.size () / 1.0e6;
+
+		n_json rv;
+		rv["bytes"] = str.size ();
+		rv["rows"] = parsed.size ();
+		rv["ms_per_parse_stod"] = ns_per_call ([&](long) {
+			bench_sink = bench_sink + (double)stod_parse (str).size ();
+		}, parses) / 1.0e6;
+		rv["ms_per_parse"] = ns_per_call ([&](long) {
+			handler.parse_finals_data (str);
+		}, parses) / 1.0e6;
+		rv["mb_per_s_stod"] = mb / (rv["ms_per_parse_stod"].get<double> () / 1000.0);
+		rv["mb_per_s"] = mb / (rv["ms_per_parse"].get<double> () / 1000.0);
+		rv["speedup"] = rv["ms_per_parse_stod"].get<double> () / rv["ms_per_parse"].get<double> ();
+		rv["rows_differing"] = rows_differing;
+		return rv;
+	}
+
+
+	// load_finals_data_from_file once its cache exists, against slurping and parsing the text. rows_differing counts
+	// rows of the cached load that are not bitwise identical to those parsed.
+	n_json load (bench_options const& opts)
+	{
+		auto& handler = finals_data_handler::instance ();
+		const long loads = std::max (1L, opts.iterations / 10000);
+
+		handler.load_finals_data_from_file (opts.finals_path); // writes the cache if it is missing or stale
+		handler.load_finals_data_from_file (opts.finals_path);
+		const finals_view cached = handler.values ();
+
+		handler.parse_finals_data (slurpfile (opts.finals_path));
+		const finals_view parsed = handler.values ();
+
+		long rows_differing = (long)std::max (parsed.size (), cached.size ()) - (long)std::min (parsed.size (), cached.size ());
+		for (std::size_t i = 0; i < std::min (parsed.size (), cached.size ()); ++i) {
+			if (std::memcmp (&parsed[i].julian_utc, &cached[i].julian_utc, sizeof (double)) != 0 || parsed[i].ut1_utc != cached[i].ut1_utc ||
+				parsed[i].pm_x != cached[i].pm_x || parsed[i].pm_y != cached[i].pm_y || parsed[i].epsilon != cached[i].epsilon ||
+				parsed[i].pm_is_prediction != cached[i].pm_is_prediction || parsed[i].ut1_utc_is_prediction != cached[i].ut1_utc_is_prediction)
+				++rows_differing;
+		}
+
+		n_json rv;
+		rv["rows"] = cached.size ();
+		rv["ms_per_load_text"] = ns_per_call ([&](long) {
+			handler.parse_finals_data (slurpfile (opts.finals_path));
+		}, loads) / 1.0e6;
+		rv["ms_per_load_cached"] = ns_per_call ([&](long) {
+			handler.load_finals_data_from_file (opts.finals_path);
+		}, loads) / 1.0e6;
+		rv["speedup"] = rv["ms_per_load_text"].get<double> () / rv["ms_per_load_cached"].get<double> ();
+		rv["rows_differing"] = rows_differing;
+		return rv;
+	}
+
+	// finals_data_for_time on a reader thread while the main thread reloads the table, alternating between the file and
+	// the file less its first thousand rows. Each lookup must match the lookup in one of the two tables (torn counts
+	// those that match neither); ns_per_lookup is timed on a quiet table, ms_per_reload is a parse and publish.
+	n_json reload (bench_options const& opts)
+	{
+		auto& handler = finals_data_handler::instance ();
+		const std::string full = slurpfile (opts.finals_path);
+
+		std::size_t cut = 0;
+		for (int i = 0; i < 1000 && cut != std::string::npos; ++i)
+			cut = full.find ('\n', cut + 1);
+		if (cut == std::string::npos)
+			return { { "error", "finals file too short" } };
+		const std::string trimmed = full.substr (cut + 1);
+
+		handler.parse_finals_data (full);
+		const std::shared_ptr<const finals_table> a = handler.snapshot ();
+		handler.parse_finals_data (trimmed);
+		const std::shared_ptr<const finals_table> b = handler.snapshot ();
+
+		const finals_view rows = a->view ();
+		const double first = rows.front ().julian_utc;
+		const double span = rows.back ().julian_utc - first;
+
+		std::vector<double> dates (4096);
+		for (std::size_t i = 0; i < dates.size (); ++i)
+			dates[i] = first + span * std::fmod (0.618034 * (double)i, 1.0);
+
+		const long reloads = std::max (2L, opts.iterations / 10000);
+
+		std::atomic<bool> done (false);
+		long lookups = 0, torn = 0;
+		std::thread reader ([&]() {
+			for (std::size_t i = 0; !done.load (); ++i) {
+				const double jd = dates[i % dates.size ()];
+				const finals_data fd = handler.finals_data_for_time (jd);
+				const finals_data fa = a->finals_data_for_time (jd);
+				const finals_data fb = b->finals_data_for_time (jd);
+				if ((fd.ut1_utc != fa.ut1_utc || fd.pm_x != fa.pm_x) && (fd.ut1_utc != fb.ut1_utc || fd.pm_x != fb.pm_x))
+					++torn;
+				++lookups;
+			}
+		});
+
+		n_json rv;
+		rv["ms_per_reload"] = ns_per_call ([&](long i) {
+			handler.parse_finals_data (i % 2 == 0 ? full : trimmed);
+		}, reloads) / 1.0e6;
+		done = true;
+		reader.join ();
+
+		handler.parse_finals_data (full);
+		rv["ns_per_lookup"] = ns_per_call ([&](long i) {
+			bench_sink = bench_sink + handler.finals_data_for_time (dates[i % dates.size ()]).ut1_utc;
+		}, opts.iterations);
+		rv["reloads"] = reloads;
+		rv["lookups_during_reloads"] = lookups;
+		rv["torn"] = torn;
+		return rv;
+	}
+
+	// The rows read through values (), a view of the current table, against the copy of the table values () used to
+	// return; then the two range queries: the prediction rows, and the rows of the last year of the table. Their counts
+	// are checked against plain loops over the view.
+	n_json view (bench_options const& opts)
+	{
+		auto& handler = finals_data_handler::instance ();
+		const finals_view rows = handler.values ();
+
+		if (rows.size () < 2)
+			return { { "error", "no finals data" } };
+
+		const double year_end = rows.back ().julian_utc + 1.0, year_begin = year_end - 365.0;
+
+		long prediction_rows = 0, last_year_rows = 0, expected_predictions = 0, expected_last_year = 0;
+		for (finals_data const& fd : rows.predictions ())
+			prediction_rows += fd.ut1_utc_is_prediction || fd.pm_is_prediction ? 1 : 0;
+		last_year_rows = (long)rows.between (year_begin, year_end).size ();
+		for (finals_data const& fd : rows) {
+			expected_predictions += fd.ut1_utc_is_prediction || fd.pm_is_prediction ? 1 : 0;
+			expected_last_year += fd.julian_utc >= year_begin && fd.julian_utc < year_end ? 1 : 0;
+		}
+
+		const long copies = std::max (1L, opts.iterations / 100);
+
+		n_json rv;
+		rv["rows"] = rows.size ();
+		rv["ns_per_values_copy"] = ns_per_call ([&](long) {
+			const std::vector<finals_data> copy (handler.values ().begin (), handler.values ().end ());
+			bench_sink = bench_sink + copy.back ().ut1_utc;
+		}, copies);
+		rv["ns_per_values_view"] = ns_per_call ([&](long) {
+			bench_sink = bench_sink + handler.values ().back ().ut1_utc;
+		}, opts.iterations);
+		rv["ns_per_predictions_scan"] = ns_per_call ([&](long) {
+			double sum = 0;
+			for (finals_data const& fd : rows.predictions ())
+				sum += fd.ut1_utc;
+			bench_sink = bench_sink + sum;
+		}, copies);
+		rv["ns_per_between_last_year"] = ns_per_call ([&](long) {
+			bench_sink = bench_sink + (double)rows.between (year_begin, year_end).size ();
+		}, opts.iterations);
+		rv["prediction_rows"] = prediction_rows;
+		rv["last_year_rows"] = last_year_rows;
+		rv["query_mismatches"] = std::abs (prediction_rows - expected_predictions) + std::abs (last_year_rows - expected_last_year);
+		return rv;
+	}
+
+}
+
+void register_finals_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "finals.lookup", lookup });
+	benchmarks.push_back ({ "finals.parse", parse });
+	benchmarks.push_back ({ "finals.load", load });
+	benchmarks.push_back ({ "finals.reload", reload });
+	benchmarks.push_back ({ "finals.view", view });
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <json.hpp>
+using n_json = nlohmann::json;
+
+struct bench_options {
+	std::string ephemeris_path;
+	std::string finals_path;
+	long iterations;
+};
+
+struct benchmark {
+	std::string name;
+	std::function<n_json (bench_options const &)> run;
+};
+
+// Results of timed calls are folded into this value so the optimizer cannot drop them.
+extern volatile double bench_sink;
+
+// ns_per_call: runs 'fn' 'iterations' times and returns the mean wall-clock time of one call, in nanoseconds.
+
+template <typename F>
+double ns_per_call (F && fn, long iterations)
+{
+	auto start = std::chrono::steady_clock::now ();
+	for (long i = 0; i < iterations; ++i) {
+		fn (i);
+	}
+	auto stop = std::chrono::steady_clock::now ();
+	return std::chrono::duration<double, std::nano> (stop - start).count () / (double)iterations;
+}
+
+void register_ephemeris_benchmarks (std::vector<benchmark> & benchmarks);
+void register_chebyshev_benchmarks (std::vector<benchmark> & benchmarks);
+void register_places_benchmarks (std::vector<benchmark> & benchmarks);
+void register_events_benchmarks (std::vector<benchmark> & benchmarks);
+void register_finals_benchmarks (std::vector<benchmark> & benchmarks);
+void register_time_benchmarks (std::vector<benchmark> & benchmarks);
+void register_search_benchmarks (std::vector<benchmark> & benchmarks);
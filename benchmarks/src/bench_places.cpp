@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ephemeris.h"
+#include "novas_utils.h"
+
+#include "bench_harness.h"
+
+namespace {
+
+	// The '-c planets -all' path: apparent geocentric places of every planet at one epoch, then ecliptic coordinates.
+	// Compares one place() per planet against the place_bodies snapshot. A new epoch is taken on every iteration so
+	// that nothing carries over from the previous call; the epochs cycle over about a year of finals data, and the
+	// cost of the astro_time alone is reported for reference.
+	n_json planets_all (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		auto const& planets = novas_constants::all_planets;
+		const double first = std::max (em.eph_begin () + 1.0, 2458849.5); // 2020-01-01, where finals data exist
+		const long calls = std::max (1L, opts.iterations / 100);
+
+		auto epoch = [&](long i) {
+			return astro_time::from_utc (first + 0.37 * (double)(i % 1000));
+		};
+
+		auto per_planet = [&](long i) {
+			astro_time t = epoch (i);
+			for (auto const& planet : planets) {
+				sky_pos sp = novas_utils::load_planet_geocentric_equatorial (t, planet);
+				auto [elon, elat] = novas_wrapper::w_equ2ecl (t, novas_constants::coord_equ, novas_constants::accuracy, sp.ra, sp.dec);
+				bench_sink = bench_sink + elon + elat;
+			}
+		};
+
+		auto snapshot = [&](long i) {
+			astro_time t = epoch (i);
+			std::vector<sky_pos> places = novas_utils::load_planets_geocentric_equatorial (t, planets);
+			for (auto const& sp : places) {
+				auto [elon, elat] = novas_wrapper::w_equ2ecl (t, novas_constants::coord_equ, novas_constants::accuracy, sp.ra, sp.dec);
+				bench_sink = bench_sink + elon + elat;
+			}
+		};
+
+		double max_diff = 0.0;
+		for (long i = 0; i < std::min (calls, 100L); ++i) {
+			astro_time t = epoch (i);
+			std::vector<sky_pos> places = novas_utils::load_planets_geocentric_equatorial (t, planets);
+			for (std::size_t p = 0; p < planets.size (); ++p) {
+				sky_pos sp = novas_utils::load_planet_geocentric_equatorial (t, planets[p]);
+				max_diff = std::max ({ max_diff, std::fabs (sp.ra - places[p].ra), std::fabs (sp.dec - places[p].dec), std::fabs (sp.dis - places[p].dis) });
+			}
+		}
+
+		n_json rv;
+		rv["planets"] = planets.size ();
+		rv["us_per_epoch_astro_time"] = ns_per_call ([&](long i) {
+			astro_time t = epoch (i);
+			bench_sink = bench_sink + t.as_tt () + t.delta_t ();
+		}, calls) / 1000.0;
+		rv["us_per_epoch_per_planet"] = ns_per_call (per_planet, calls) / 1000.0;
+		rv["us_per_epoch_snapshot"] = ns_per_call (snapshot, calls) / 1000.0;
+		rv["speedup"] = rv["us_per_epoch_per_planet"].get<double> () / rv["us_per_epoch_snapshot"].get<double> ();
+		rv["max_diff"] = max_diff;
+		return rv;
+	}
+
+	// Two streams of queries, each placing the Sun and then the Moon at its own epochs, with the calls of the two
+	// streams interleaved. With one NOVAS context every call meets the other stream's epoch and recomputes the terms of
+	// its own; with a context per stream the Moon reuses the terms computed for the Sun at the same epoch.
+	n_json interleaved_epochs (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double first = std::max (em.eph_begin () + 1.0, 2458849.5);
+		const long calls = std::max (1L, opts.iterations / 100);
+
+		std::vector<astro_time> epochs_a, epochs_b;
+		for (long i = 0; i < 1000; ++i) {
+			epochs_a.push_back (astro_time::from_utc (first + 0.37 * (double)i));
+			epochs_b.push_back (astro_time::from_utc (first + 180.0 + 0.37 * (double)i));
+		}
+
+		object sun = novas_utils::build_planet_object (novas_constants::SUN);
+		object moon = novas_utils::build_planet_object (novas_constants::MOON);
+		observer geocenter;
+		make_observer_at_geocenter (&geocenter);
+
+		novas_wrapper::context context_a, context_b;
+
+		auto place = [&](novas_wrapper::context* ctx, astro_time& t, object& body) {
+			return ctx ? novas_wrapper::w_place (*ctx, t, body, geocenter, novas_constants::coord_equ, novas_constants::accuracy)
+				: novas_wrapper::w_place (t, body, geocenter, novas_constants::coord_equ, novas_constants::accuracy);
+		};
+
+		auto streams = [&](novas_wrapper::context* a, novas_wrapper::context* b) {
+			return [&, a, b](long i) {
+				astro_time& ta = epochs_a[i % 1000];
+				astro_time& tb = epochs_b[i % 1000];
+				sky_pos sun_a = place (a, ta, sun);
+				sky_pos sun_b = place (b, tb, sun);
+				sky_pos moon_a = place (a, ta, moon);
+				sky_pos moon_b = place (b, tb, moon);
+				bench_sink = bench_sink + sun_a.ra + sun_b.ra + moon_a.ra + moon_b.ra;
+			};
+		};
+
+		double max_diff = 0.0;
+		for (long i = 0; i < std::min (calls, 100L); ++i) {
+			sky_pos shared = place (nullptr, epochs_b[i], moon);
+			sky_pos own = place (&context_b, epochs_b[i], moon);
+			max_diff = std::max ({ max_diff, std::fabs (shared.ra - own.ra), std::fabs (shared.dec - own.dec), std::fabs (shared.dis - own.dis) });
+		}
+
+		n_json rv;
+		rv["us_per_round_one_context"] = ns_per_call (streams (nullptr, nullptr), calls) / 1000.0;
+		rv["us_per_round_context_per_stream"] = ns_per_call (streams (&context_a, &context_b), calls) / 1000.0;
+		rv["speedup"] = rv["us_per_round_one_context"].get<double> () / rv["us_per_round_context_per_stream"].get<double> ();
+		rv["max_diff"] = max_diff;
+		return rv;
+	}
+
+}
+
+void register_places_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "places.planets_all", planets_all });
+	benchmarks.push_back ({ "places.interleaved_epochs", interleaved_epochs });
+}
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "chebyshev_proxy.h"
+#include "ephemeris.h"
+#include "event_search.h"
+#include "novas_utils.h"
+#include "zbrent.h"
+
+#include "bench_harness.h"
+
+namespace {
+
+	double seconds_since (std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+	}
+
+	const double search_tolerance = std::numeric_limits<double>::epsilon () * 100;
+
+	struct search_tally {
+		long events = 0;
+		long mismatched_lanes = 0;
+		long evals_engine = 0;
+		long evals_scalar = 0;
+		long rounds = 0;
+		double engine_s = 0.0;
+		double scalar_s = 0.0;
+		double max_dt_ms = 0.0;
+	};
+
+	// Searches each group of 'searches' with an event_search over the batch function 'fxs', and every lane of them on
+	// its own with zbrak_adaptive and zbrent_newton over 'fx' and 'fdx' (the value, and the value with its rate, of
+	// function number 'function' at a time; 'fdx' is a single query of 'fxs'), adding the evaluations, times and root
+	// differences of both to 't'. 'fx' resets the context before each evaluation as the batch functions do; otherwise
+	// NOVAS reuses the values of an epoch within 1e-8 day, and zbrent can see the sign of f at a bracket end change
+	// when it evaluates the end again. The ephemeris pages both read are touched by an untimed pass first.
+	template <typename B, typename FX, typename FDX>
+	void compare (search_tally& t, std::vector<std::vector<event_lane>> const& searches, B& fxs, FX& fx, FDX& fdx)
+	{
+		std::vector<event_lane> lanes;
+		for (auto const& group : searches) {
+			event_search warm (group);
+			warm.bracket (fxs);
+			lanes.insert (lanes.end (), group.begin (), group.end ());
+		}
+
+		std::vector<std::vector<double>> engine_roots;
+		auto start = std::chrono::steady_clock::now ();
+		for (auto const& group : searches) {
+			event_search search (group);
+			search.bracket (fxs);
+			search.refine (fxs, search_tolerance);
+			t.evals_engine += search.evaluations;
+			t.rounds += search.rounds;
+			for (std::size_t l = 0; l < search.size (); ++l)
+				engine_roots.push_back (search.roots (l));
+		}
+		t.engine_s += seconds_since (start);
+
+		std::vector<std::vector<double>> scalar_roots (lanes.size ());
+		long evals = 0;
+		start = std::chrono::steady_clock::now ();
+		for (std::size_t l = 0; l < lanes.size (); ++l) {
+			event_lane const& lane = lanes[l];
+			auto f = [&](double x) { ++evals; return fx (lane.function, x); };
+			auto fd = [&](double x) { ++evals; return fdx (lane.function, x); };
+			std::vector<double> xb1, xb2;
+			int nroot = 0;
+			zbrak_adaptive (f, lane.x1, lane.x2, lane.rate, xb1, xb2, nroot);
+			for (int i = 0; i < nroot; ++i)
+				scalar_roots[l].push_back (zbrent_newton (fd, xb1[i], xb2[i], search_tolerance, lane.rate.wrap));
+		}
+		t.scalar_s += seconds_since (start);
+		t.evals_scalar += evals;
+
+		for (std::size_t l = 0; l < lanes.size (); ++l) {
+			std::vector<double> const& roots = engine_roots[l];
+			std::sort (scalar_roots[l].begin (), scalar_roots[l].end ());
+			t.events += (long)roots.size ();
+			if (roots.size () != scalar_roots[l].size ()) {
+				++t.mismatched_lanes;
+				continue;
+			}
+			for (std::size_t i = 0; i < roots.size (); ++i)
+				t.max_dt_ms = std::max (t.max_dt_ms, std::fabs (roots[i] - scalar_roots[l][i]) * 86400.0e3);
+		}
+	}
+
+	n_json report (search_tally const& t)
+	{
+		const double events = (double)std::max (1L, t.events);
+		n_json r;
+		r["events"] = t.events;
+		r["mismatched_lanes"] = t.mismatched_lanes;
+		r["evals_per_event_engine"] = (double)t.evals_engine / events;
+		r["evals_per_event_scalar"] = (double)t.evals_scalar / events;
+		r["evals_per_round_engine"] = (double)t.evals_engine / (double)std::max (1L, t.rounds);
+		r["us_per_event_engine"] = t.engine_s * 1.0e6 / events;
+		r["us_per_event_scalar"] = t.scalar_s * 1.0e6 / events;
+		r["max_dt_ms"] = t.max_dt_ms;
+		return r;
+	}
+
+	// Runs compare over the elevation (if 'elevation') and azimuth lanes of 30 days from 2019-01-01, a search per day,
+	// for the Moon, Sun, Mars and Pluto seen from latitudes 0, 41.25 and 65.
+	n_json planetary_search (bench_options const& opts, bool elevation)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double start = 2458484.5; // 2019-01-01, where finals data exist
+		const novas_planet bodies[] = { novas_constants::MOON, novas_constants::SUN, novas_constants::MARS, novas_constants::PLUTO };
+		const double latitudes[] = { 0.0, 41.25, 65.0 };
+
+		novas_wrapper::context ctx;
+		novas_wrapper::context_binding binding (ctx);
+
+		search_tally t;
+		for (auto const& body : bodies) {
+			for (double lat : latitudes) {
+				on_surface loc;
+				make_on_surface (lat, -122.95, 0.0, 10.0, 1010.0, &loc);
+
+				novas_utils::planetary_event_functions fns (body, loc);
+				novas_utils::planetary_event_batch fxs (body, fns, ctx);
+
+				std::vector<std::vector<event_lane>> searches;
+				for (double d = start; d < start + 30.0; d += 1.0) {
+					std::vector<event_lane> day;
+					if (elevation)
+						day.push_back ({ novas_utils::planetary_event_batch::elevation, d, d + 1.0, novas_utils::elevation_bracket_rate (body, loc) });
+					day.push_back ({ novas_utils::planetary_event_batch::azimuth, d, d + 1.0, novas_utils::azimuth_bracket_rate (body) });
+					searches.push_back (day);
+				}
+
+				auto fx = [&](int function, double t) {
+					ctx.reset ();
+					return function == novas_utils::planetary_event_batch::elevation ? fns.el_at_time (t) : fns.az_at_time (t);
+				};
+				auto fdx = [&](int function, double t) { return batch_funcd (fxs, function, t); };
+
+				compare (t, searches, fxs, fx, fdx);
+			}
+		}
+		return report (t);
+	}
+
+	// Rise, set and culminations: event_search with planetary_event_batch over the two lanes of each day, as
+	// find_planetary_events searches, against the same steps taken one lane and one evaluation at a time.
+	n_json rise_set (bench_options const& opts)
+	{
+		return planetary_search (opts, true);
+	}
+
+	// Culminations alone: the azimuth lanes of the searches above.
+	n_json culmination (bench_options const& opts)
+	{
+		return planetary_search (opts, false);
+	}
+
+	// New and full moons: event_search with moon_phase_batch over a single lane of a year and of ten years, against
+	// zbrak_adaptive and zbrent_newton on get_moon_phase and single queries of moon_phase_batch.
+	n_json moon_phases (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double start = 2458484.5; // 2019-01-01, where finals data exist
+
+		novas_wrapper::context ctx;
+		novas_wrapper::context_binding binding (ctx);
+		novas_utils::moon_phase_batch fxs (ctx);
+
+		auto fx = [&](int, double t) {
+			ctx.reset ();
+			astro_time at = astro_time::from_utc (t);
+			return novas_utils::get_moon_phase (at).sun_earth_angle_long;
+		};
+		auto fdx = [&](int function, double t) { return batch_funcd (fxs, function, t); };
+
+		n_json rv;
+		for (double span : { 365.0, 3650.0 }) {
+			search_tally t;
+			std::vector<std::vector<event_lane>> searches { { { novas_utils::moon_phase_batch::phase_lon, start, start + span, novas_utils::moon_phase_bracket_rate () } } };
+			compare (t, searches, fxs, fx, fdx);
+			rv[std::to_string ((int)span) + "d"] = report (t);
+		}
+		return rv;
+	}
+
+
+	// A batch function counting the distinct epochs of each call to 'fxs', which the batch functions evaluate once.
+	template <typename B>
+	struct epoch_counter {
+		B& fxs;
+		long epochs = 0;
+
+		void operator() (const event_query* queries, std::size_t n, double* f, double* df)
+		{
+			std::vector<double> x;
+			for (std::size_t i = 0; i < n; ++i)
+				x.push_back (queries[i].x);
+			std::sort (x.begin (), x.end ());
+			epochs += (long)(std::unique (x.begin (), x.end ()) - x.begin ());
+			fxs (queries, n, f, df);
+		}
+	};
+
+	// The roots of every lane of a run of searches, with the evaluations, distinct epochs, fallbacks and time they took.
+	struct root_run {
+		std::vector<std::vector<double>> roots;
+		long evaluations = 0;
+		long epochs = 0;
+		long fallbacks = 0;
+		double seconds = 0.0;
+	};
+
+	// Searches each group of 'searches' with an event_search over 'fxs', adding to 'run'.
+	template <typename B>
+	void run_bracketing (root_run& run, std::vector<std::vector<event_lane>> const& searches, B& fxs)
+	{
+		epoch_counter<B> counted { fxs };
+		auto start = std::chrono::steady_clock::now ();
+		for (auto const& group : searches) {
+			event_search search (group);
+			search.bracket (counted);
+			search.refine (counted, search_tolerance);
+			run.evaluations += search.evaluations;
+			for (std::size_t l = 0; l < search.size (); ++l)
+				run.roots.push_back (search.roots (l));
+		}
+		run.seconds += seconds_since (start);
+		run.epochs += counted.epochs;
+	}
+
+	// Searches each group of 'searches' with a proxy_search of 'nodes' nodes on pieces of 'piece' over 'fxs', adding to
+	// 'run'.
+	template <typename B>
+	void run_proxy (root_run& run, std::vector<std::vector<event_lane>> const& searches, B& fxs, double piece, int nodes)
+	{
+		epoch_counter<B> counted { fxs };
+		auto start = std::chrono::steady_clock::now ();
+		for (auto const& group : searches) {
+			proxy_search search (group, piece, nodes);
+			search.fit (counted);
+			search.polish (counted, search_tolerance);
+			run.evaluations += search.evaluations;
+			run.fallbacks += search.fallbacks;
+			for (std::size_t l = 0; l < search.size (); ++l)
+				run.roots.push_back (search.roots (l));
+		}
+		run.seconds += seconds_since (start);
+		run.epochs += counted.epochs;
+	}
+
+	// The cost per event of 'run', and for a proxy run its agreement with the bracketing run 'reference': the events
+	// bracketing found and the proxy did not, those the proxy alone found, and the largest difference of the others.
+	n_json report_run (root_run const& run, root_run const* reference)
+	{
+		long events = 0;
+		for (auto const& roots : (reference ? reference->roots : run.roots))
+			events += (long)roots.size ();
+		const double per = (double)std::max (1L, events);
+
+		n_json r;
+		r["evals_per_event"] = (double)run.evaluations / per;
+		r["epochs_per_event"] = (double)run.epochs / per;
+		r["us_per_event"] = run.seconds * 1.0e6 / per;
+		if (!reference) {
+			r["events"] = events;
+			return r;
+		}
+
+		long missed = 0, extra = 0;
+		double max_dt_ms = 0.0;
+		for (std::size_t l = 0; l < run.roots.size (); ++l) {
+			std::vector<double> const& want = reference->roots[l];
+			std::vector<double> const& got = run.roots[l];
+			long matched = 0;
+			for (double x : want) {
+				auto near = std::min_element (got.begin (), got.end (), [&](double a, double b) { return std::fabs (a - x) < std::fabs (b - x); });
+				if (near != got.end () && std::fabs (*near - x) < 1.0e-3) {
+					++matched;
+					max_dt_ms = std::max (max_dt_ms, std::fabs (*near - x) * 86400.0e3);
+				}
+				else {
+					++missed;
+				}
+			}
+			extra += (long)got.size () - matched;
+		}
+		r["missed"] = missed;
+		r["extra"] = extra;
+		r["fallbacks"] = run.fallbacks;
+		r["max_dt_ms"] = max_dt_ms;
+		return r;
+	}
+
+	// Rise, set and culminations by proxy: event_search against proxy_search on 16, 24 and 32 nodes a day, over the
+	// searches of search.rise_set. 16 nodes begin to miss events.
+	n_json proxy_rise_set (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double start = 2458484.5; // 2019-01-01, where finals data exist
+		const novas_planet bodies[] = { novas_constants::MOON, novas_constants::SUN, novas_constants::MARS, novas_constants::PLUTO };
+		const double latitudes[] = { 0.0, 41.25, 65.0 };
+		const int node_counts[] = { 16, 24, 32 };
+
+		novas_wrapper::context ctx;
+		novas_wrapper::context_binding binding (ctx);
+
+		root_run bracketing;
+		std::vector<root_run> proxies (std::size (node_counts));
+		for (auto const& body : bodies) {
+			for (double lat : latitudes) {
+				on_surface loc;
+				make_on_surface (lat, -122.95, 0.0, 10.0, 1010.0, &loc);
+
+				novas_utils::planetary_event_functions fns (body, loc);
+				novas_utils::planetary_event_batch fxs (body, fns, ctx);
+
+				std::vector<std::vector<event_lane>> searches;
+				for (double d = start; d < start + 30.0; d += 1.0) {
+					searches.push_back ({ { novas_utils::planetary_event_batch::elevation, d, d + 1.0, novas_utils::elevation_bracket_rate (body, loc) },
+					                      { novas_utils::planetary_event_batch::azimuth, d, d + 1.0, novas_utils::azimuth_bracket_rate (body) } });
+				}
+
+				run_bracketing (bracketing, searches, fxs);
+				for (std::size_t i = 0; i < std::size (node_counts); ++i)
+					run_proxy (proxies[i], searches, fxs, 1.0, node_counts[i]);
+			}
+		}
+
+		n_json rv;
+		rv["bracketing"] = report_run (bracketing, nullptr);
+		for (std::size_t i = 0; i < std::size (node_counts); ++i)
+			rv["proxy_" + std::to_string (node_counts[i]) + "_nodes"] = report_run (proxies[i], &bracketing);
+		return rv;
+	}
+
+	// New and full moons by proxy: event_search against proxy_search on pieces of 15, 30 and 45 days of 8 and 12 nodes,
+	// over ten years. Nodes more than about five days apart begin to miss events.
+	n_json proxy_moon_phases (bench_options const& opts)
+	{
+		auto& em = ephemeris::instance ();
+		em.open (opts.ephemeris_path, ephemeris_access::mapped);
+
+		const double start = 2458484.5; // 2019-01-01, where finals data exist
+		const int node_counts[] = { 8, 12 };
+
+		novas_wrapper::context ctx;
+		novas_wrapper::context_binding binding (ctx);
+		novas_utils::moon_phase_batch fxs (ctx);
+
+		std::vector<std::vector<event_lane>> searches { { { novas_utils::moon_phase_batch::phase_lon, start, start + 3650.0, novas_utils::moon_phase_bracket_rate () } } };
+
+		root_run bracketing;
+		run_bracketing (bracketing, searches, fxs);
+
+		n_json rv;
+		rv["bracketing"] = report_run (bracketing, nullptr);
+		for (double piece : { 15.0, 30.0, 45.0 }) {
+			for (int nodes : node_counts) {
+				root_run proxy;
+				run_proxy (proxy, searches, fxs, piece, nodes);
+				rv["proxy_" + std::to_string ((int)piece) + "d_" + std::to_string (nodes) + "_nodes"] = report_run (proxy, &bracketing);
+			}
+		}
+		return rv;
+	}
+
+}
+
+void register_search_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "search.rise_set", rise_set });
+	benchmarks.push_back ({ "search.culmination", culmination });
+	benchmarks.push_back ({ "search.moon_phases", moon_phases });
+	benchmarks.push_back ({ "search.proxy_rise_set", proxy_rise_set });
+	benchmarks.push_back ({ "search.proxy_moon_phases", proxy_moon_phases });
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "astro_time.h"
+#include "finals_data_handler.h"
+
+#include "bench_harness.h"
+
+// The scale conversions of astro_time.cpp.
+double leapsec_tai_utc (double jd_utc);
+double julian_utc_to_tt (double julian_utc);
+double julian_tt_to_tdb (double julian_tt);
+
+namespace {
+
+	// The astro_time before it computed scales on demand: every scale and a copy of the whole finals row, all
+	// computed when the time is made.
+	struct eager_time {
+		double julian_tt;
+		double julian_utc;
+		double julian_ut1;
+		double julian_tdb;
+		finals_data cached_finals_data;
+
+		explicit eager_time (double jd_utc)
+		{
+			julian_tt = julian_utc_to_tt (jd_utc);
+			julian_utc = jd_utc;
+			julian_tdb = julian_tt_to_tdb (julian_tt);
+			julian_ut1 = finals::DNAN;
+		}
+
+		double delta_t ()
+		{
+			if (std::isnan (cached_finals_data.julian_utc)) {
+				cached_finals_data = finals_data_handler::instance ().finals_data_for_time (julian_utc);
+				julian_ut1 = julian_utc + (cached_finals_data.ut1_utc / 86400.0);
+			}
+			return 32.184 + leapsec_tai_utc (julian_utc) - cached_finals_data.ut1_utc;
+		}
+
+		double as_ut1 ()
+		{
+			delta_t ();
+			return julian_ut1;
+		}
+	};
+
+	// from_utc, then as_ut1 and delta_t, as a sidereal time takes them, on dates spread over the finals table; against
+	// the eager astro_time it replaced. mismatches counts dates whose UT1 or delta T differ between the two.
+	n_json utc_to_ut1 (bench_options const& opts)
+	{
+		const finals_view rows = finals_data_handler::instance ().values ();
+
+		if (rows.size () < 2)
+			return { { "error", "no finals data" } };
+
+		const double first = rows.front ().julian_utc;
+		const double span = rows.back ().julian_utc - first;
+
+		std::vector<double> dates (4096);
+		for (std::size_t i = 0; i < dates.size (); ++i)
+			dates[i] = first + span * std::fmod (0.618034 * (double)i, 1.0);
+
+		long mismatches = 0;
+		for (double jd : dates) {
+			astro_time a = astro_time::from_utc (jd);
+			eager_time b (jd);
+			if (a.as_ut1 () != b.as_ut1 () || a.delta_t () != b.delta_t ())
+				++mismatches;
+		}
+
+		n_json rv;
+		rv["bytes_eager"] = sizeof (eager_time);
+		rv["bytes"] = sizeof (astro_time);
+		rv["ns_per_time_eager"] = ns_per_call ([&](long i) {
+			eager_time t (dates[i % dates.size ()]);
+			bench_sink = bench_sink + t.as_ut1 () + t.delta_t ();
+		}, opts.iterations);
+		rv["ns_per_time"] = ns_per_call ([&](long i) {
+			astro_time t = astro_time::from_utc (dates[i % dates.size ()]);
+			bench_sink = bench_sink + t.as_ut1 () + t.delta_t ();
+		}, opts.iterations);
+		rv["speedup"] = rv["ns_per_time_eager"].get<double> () / rv["ns_per_time"].get<double> ();
+		rv["mismatches"] = mismatches;
+		return rv;
+	}
+
+	// convert_utc_to_tt_tdb_ut1 on iterations timestamps a second apart (sorted) and on the same timestamps in a
+	// scattered order, against from_utc and as_tt, as_tdb and as_ut1 for each. The max_dt_* are the largest
+	// differences from the single conversions, in seconds (for TDB, at most a unit of the last place of the date).
+	n_json batch (bench_options const& opts)
+	{
+		const finals_view rows = finals_data_handler::instance ().values ();
+
+		if (rows.size () < 2)
+			return { { "error", "no finals data" } };
+
+		const std::size_t count = (std::size_t)std::max (1000L, opts.iterations);
+		const double start = rows.back ().julian_utc - 30.0;
+
+		std::vector<double> sorted (count), scattered (count);
+		for (std::size_t i = 0; i < count; ++i)
+			sorted[i] = start + (double)i / 86400.0;
+		for (std::size_t i = 0; i < count; ++i)
+			scattered[i] = sorted[(i * 7919) % count];
+
+		std::vector<double> tt (count), tdb (count), ut1 (count);
+
+		auto single = [&](std::vector<double> const& in) {
+			for (std::size_t i = 0; i < count; ++i) {
+				astro_time t = astro_time::from_utc (in[i]);
+				tt[i] = t.as_tt ();
+				tdb[i] = t.as_tdb ();
+				ut1[i] = t.as_ut1 ();
+			}
+		};
+
+		single (sorted);
+		const std::vector<double> tt_ref = tt, tdb_ref = tdb, ut1_ref = ut1;
+		astro_time::convert_utc_to_tt_tdb_ut1 (sorted.data (), count, tt.data (), tdb.data (), ut1.data ());
+
+		double max_dt_tt = 0, max_dt_tdb = 0, max_dt_ut1 = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			max_dt_tt = std::max (max_dt_tt, std::fabs (tt[i] - tt_ref[i]) * 86400.0);
+			max_dt_tdb = std::max (max_dt_tdb, std::fabs (tdb[i] - tdb_ref[i]) * 86400.0);
+			max_dt_ut1 = std::max (max_dt_ut1, std::fabs (ut1[i] - ut1_ref[i]) * 86400.0);
+		}
+
+		const long passes = 5;
+
+		n_json rv;
+		rv["dates"] = count;
+		rv["ns_per_date_single"] = ns_per_call ([&](long) { single (sorted); }, passes) / (double)count;
+		rv["ns_per_date_batch_sorted"] = ns_per_call ([&](long) {
+			astro_time::convert_utc_to_tt_tdb_ut1 (sorted.data (), count, tt.data (), tdb.data (), ut1.data ());
+		}, passes) / (double)count;
+		rv["ns_per_date_batch_scattered"] = ns_per_call ([&](long) {
+			astro_time::convert_utc_to_tt_tdb_ut1 (scattered.data (), count, tt.data (), tdb.data (), ut1.data ());
+		}, passes) / (double)count;
+		rv["speedup"] = rv["ns_per_date_single"].get<double> () / rv["ns_per_date_batch_sorted"].get<double> ();
+		rv["max_dt_tt_s"] = max_dt_tt;
+		rv["max_dt_tdb_s"] = max_dt_tdb;
+		rv["max_dt_ut1_s"] = max_dt_ut1;
+		return rv;
+	}
+
+}
+
+void register_time_benchmarks (std::vector<benchmark>& benchmarks)
+{
+	benchmarks.push_back ({ "time.utc_to_ut1", utc_to_ut1 });
+	benchmarks.push_back ({ "time.batch", batch });
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "finals_data_handler.h"
+
+#include "bench_harness.h"
+
+volatile double bench_sink = 0;
+
+int main (int argc, char* argv[])
+{
+	std::vector<std::string> tokens (argv + 1, argv + argc);
+
+	auto option = [&](std::string const& name, std::string const& fallback) -> std::string {
+		auto it = std::find (tokens.begin (), tokens.end (), name);
+		if (it != tokens.end () && ++it != tokens.end ())
+			return *it;
+		return fallback;
+	};
+
+	bench_options opts;
+	opts.ephemeris_path = option ("-e", "./data/jpleph.430");
+	opts.finals_path = option ("-f", "./data/finals.data.txt");
+	opts.iterations = std::stol (option ("-n", "200000"));
+
+	std::string filter = option ("-b", "");
+
+	if (std::find (tokens.begin (), tokens.end (), "-h") != tokens.end ()) {
+		std::cout << argv[0] << " [-e ephemeris-location] [-f finals-data-location] [-n iterations] [-b benchmark-name-filter]" << std::endl;
+		return 0;
+	}
+
+	std::vector<benchmark> benchmarks;
+	register_ephemeris_benchmarks (benchmarks);
+	register_chebyshev_benchmarks (benchmarks);
+	register_places_benchmarks (benchmarks);
+	register_events_benchmarks (benchmarks);
+	register_finals_benchmarks (benchmarks);
+	register_time_benchmarks (benchmarks);
+	register_search_benchmarks (benchmarks);
+
+	n_json rv;
+
+	try {
+		finals_data_handler::instance ().load_finals_data_from_file (opts.finals_path);
+
+		for (auto const& b : benchmarks) {
+			if (!filter.empty () && b.name.find (filter) == std::string::npos)
+				continue;
+			rv[b.name] = b.run (opts);
+		}
+	}
+	catch (std::exception & e) {
+		rv["error"] = e.what ();
+	}
+
+	std::cout << rv.dump (2) << std::endl;
+}
@@ -0,0 +1,226 @@
+#ifndef ZBRENT_H
+#define ZBRENT_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "event_search.h"
+
+/*
+* The one-root-at-a-time bracketing and refinement the searches of
+* novas_utils ran before event_search, kept as the reference the
+* benchmarks measure event_search and proxy_search against.
+*
+*/
+
+/*
+* bracket_roots -- inward root bracketing
+*
+* Given <func>, defined over <in_range>, divide <in_range> into <intervals>
+* subranges, and if the subrange brackets a root, add it to out_ranges.
+* The maximum number of subranges to report is determined by
+* <out_ranges_size>.
+*
+*/
+
+template <typename T>
+void zbrak (T & fx, const double x1, const double x2, const int n, std::vector<double> & xb1, std::vector<double> & xb2, int & nroot) {
+    int nb = 20;
+    xb1.resize (nb);
+    xb2.resize (nb);
+    nroot = 0;
+    double dx = (x2 - x1) / n;
+    double x = x1;
+    double fp = fx (x1);
+    for (int i = 0; i < n; i++) {
+        x += dx;
+        double fc = fx (x);
+        if (fc*fp <= 0.0) {
+            xb1[nroot] = x - dx;
+            xb2[nroot++] = x;
+            if (nroot == nb) {
+                std::vector<double> tempvec1 (xb1), tempvec2 (xb2);
+                xb1.resize (2 * nb);
+                xb2.resize (2 * nb);
+                for (int j = 0; j < nb; j++) {
+                    xb1[j] = tempvec1[j];
+                    xb2[j] = tempvec2[j];
+                }
+                nb *= 2;
+            }
+        }
+        fp = fc;
+    }
+}
+
+/*
+* zbrak_adaptive -- root bracketing with steps sized by a rate bound
+*
+* Steps from <x1> to <x2> as event_search::bracket () steps a lane, one
+* evaluation at a time, reporting brackets as zbrak does.
+*
+*/
+
+template <typename T>
+void zbrak_adaptive (T & fx, const double x1, const double x2, bracket_rate const & rate, std::vector<double> & xb1, std::vector<double> & xb2, int & nroot) {
+    xb1.clear ();
+    xb2.clear ();
+    double x = x1;
+    double fp = fx (x1);
+    while (x < x2) {
+        double gap = std::abs (fp);
+        if (rate.wrap > 0.0)
+            gap = std::min (gap, 0.5 * rate.wrap - gap);
+        double step = std::clamp (gap / rate.max_rate, rate.min_step, rate.max_step);
+        double xn = x2 - x > step ? x + step : x2;
+        double fc = fx (xn);
+        if (fc*fp <= 0.0) {
+            xb1.push_back (x);
+            xb2.push_back (xn);
+        }
+        x = xn;
+        fp = fc;
+    }
+    nroot = (int)xb1.size ();
+}
+
+template<class T>
+inline T SIGN (const T &a, const T &b) {
+    return b >= 0 ? (a >= 0 ? a : -a) : (a >= 0 ? -a : a);
+}
+
+template <typename T>
+double zbrent (T &func, const double x1, const double x2, const double tol) {
+    const int ITMAX = 100;
+    const double EPS = std::numeric_limits<double>::epsilon ();
+    double a = x1, b = x2, c = x2, d, e, fa = func (a), fb = func (b), fc, p, q, r, s, tol1, xm;
+    if ((fa > 0.0 && fb > 0.0) || (fa < 0.0 && fb < 0.0))
+        throw("Root must be bracketed in zbrent");
+    fc = fb;
+    for (int iter = 0; iter < ITMAX; iter++) {
+        if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+            c = a;
+            fc = fa;
+            e = d = b - a;
+        }
+        if (std::abs (fc) < std::abs (fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        tol1 = 2.0*EPS*std::abs (b) + 0.5*tol;
+        xm = 0.5*(c - b);
+        if (std::abs (xm) <= tol1 || fb == 0.0) return b;
+        if (std::abs (e) >= tol1 && std::abs (fa) > std::abs (fb)) {
+            s = fb / fa;
+            if (a == c) {
+                p = 2.0*xm*s;
+                q = 1.0 - s;
+            } else {
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2.0*xm*q*(q - r) - (b - a)*(r - 1.0));
+                q = (q - 1.0)*(r - 1.0)*(s - 1.0);
+            }
+            if (p > 0.0) q = -q;
+            p = std::abs (p);
+            double min1 = 3.0*xm*q - std::abs (tol1*q);
+            double min2 = std::abs (e*q);
+            if (2.0*p < (min1 < min2 ? min1 : min2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = xm;
+                e = d;
+            }
+        } else {
+            d = xm;
+            e = d;
+        }
+        a = b;
+        fa = fb;
+        if (std::abs (d) > tol1)
+            b += d;
+        else
+            b += SIGN (tol1, xm);
+        fb = func (b);
+    }
+    throw("Maximum number of iterations exceeded in zbrent");
+}
+
+/*
+* zbrent_newton -- root refinement with derivatives
+*
+* Refines the root bracketed by <x1> and <x2> with Newton steps on <funcd>,
+* which returns f and df/dx as a std::pair, starting from the end where |f|
+* is smaller and keeping the bracket narrowed by every evaluation. A step
+* that leaves the bracket, or that does not halve |f|, hands the narrowed
+* bracket to zbrent on f alone. Stops when a step is within the tolerance
+* zbrent uses for the same <tol>. <wrap> is as in bracket_rate: a bracket
+* across the jump of a wrapped angle is refined on the angle shifted by
+* half a period, which is continuous there.
+*
+*/
+
+template <typename T>
+double zbrent_newton (T & funcd, const double x1, const double x2, const double tol, const double wrap = 0.0) {
+    const int ITMAX = 20;
+    const double EPS = std::numeric_limits<double>::epsilon ();
+    std::pair<double, double> l = funcd (x1), h = funcd (x2);
+    const bool shifted = wrap > 0.0 && std::abs (l.first) > 0.25*wrap && std::abs (h.first) > 0.25*wrap;
+    auto value = [&] (double f) {
+        return shifted ? (f > 0.0 ? f - 0.5*wrap : f + 0.5*wrap) : f;
+    };
+    double fl = value (l.first), fh = value (h.first);
+    if ((fl > 0.0 && fh > 0.0) || (fl < 0.0 && fh < 0.0))
+        throw("Root must be bracketed in zbrent_newton");
+    if (fl == 0.0) return x1;
+    if (fh == 0.0) return x2;
+    double xneg = fl < 0.0 ? x1 : x2, xpos = fl < 0.0 ? x2 : x1;
+    const bool from_x1 = std::abs (fl) <= std::abs (fh);
+    double x = from_x1 ? x1 : x2, f = from_x1 ? fl : fh, df = from_x1 ? l.second : h.second;
+    for (int iter = 0; iter < ITMAX && df != 0.0; iter++) {
+        double dx = f / df, xn = x - dx;
+        if ((xn - xneg)*(xn - xpos) > 0.0) break;
+        if (std::abs (dx) <= 2.0*EPS*std::abs (xn) + 0.5*tol) return xn;
+        std::pair<double, double> n = funcd (xn);
+        double fn = value (n.first);
+        if (fn == 0.0) return xn;
+        if (fn < 0.0)
+            xneg = xn;
+        else
+            xpos = xn;
+        if (std::abs (fn) > 0.5*std::abs (f)) break;
+        x = xn;
+        f = fn;
+        df = n.second;
+    }
+    auto func = [&] (double xx) {
+        return value (funcd (xx).first);
+    };
+    return zbrent (func, std::min (xneg, xpos), std::max (xneg, xpos), tol);
+}
+
+/*
+* batch_funcd -- one point of a batch function
+*
+* The value and derivative of function number <function> of the batch
+* function <fxs> (see event_search) at <x>, as zbrent_newton takes them.
+*
+*/
+
+template <typename F>
+std::pair<double, double> batch_funcd (F & fxs, const int function, const double x) {
+    const event_query query { function, x };
+    double f, df;
+    fxs (&query, 1, &f, &df);
+    return { f, df };
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <locale>
+
+#include <json.hpp>
+using n_json = nlohmann::json;
+
+#include "novas_wrapper.h"
+#include "ephemeris.h"
+
+// Writes a compact ephemeris file, holding only the bodies and date span a deployment needs, from a JPL DE file.
+// The compact file is opened like the DE file by planetaria (-e) and the ephemeris classes.
+
+inline bool iequals (const std::string& l, const std::string& r)
+{
+	std::locale const locale;
+	return std::equal (l.cbegin (), l.cend (), r.cbegin (), r.cend (), [&](char a, char b) {
+		return std::toupper (a, locale) == std::toupper (b, locale);
+		});
+}
+
+// Julian date of 0h on a YYYY, YYYY-MM or YYYY-MM-DD date.
+double julian_date_of (std::string const& date)
+{
+	short year = 0, month = 1, day = 1;
+	char sep;
+
+	std::istringstream in (date);
+	in >> year;
+	if (in >> sep >> month) {
+		in >> sep >> day;
+	}
+
+	if (year == 0 || month < 1 || month > 12 || day < 1 || day > 31) {
+		throw std::runtime_error ("invalid date '" + date + "'; expected YYYY, YYYY-MM or YYYY-MM-DD");
+	}
+
+	return julian_date (year, month, day, 0.0);
+}
+
+// eph_manager target number of a planet (the Earth is taken from the Earth-Moon barycenter).
+short ephemeris_target (novas_planet const& planet)
+{
+	switch (planet.id) {
+	case novas_planet_id::SUN:
+		return 10;
+	case novas_planet_id::MOON:
+		return 9;
+	default:
+		return (short)planet.id - 1;
+	}
+}
+
+long file_size (std::string const& path)
+{
+	std::ifstream in (path, std::ios::binary | std::ios::ate);
+	return in ? (long)in.tellg () : -1;
+}
+
+int main (int argc, char* argv[])
+{
+	std::string const app_name (argv[0]);
+	std::vector<std::string> tokens (argv + 1, argv + argc);
+
+	auto option = [&](std::string const& name, std::string const& fallback) -> std::string {
+		auto it = std::find (tokens.begin (), tokens.end (), name);
+		if (it != tokens.end () && ++it != tokens.end ())
+			return *it;
+		return fallback;
+	};
+
+	if (std::find (tokens.begin (), tokens.end (), "-h") != tokens.end () || option ("-o", "").empty ())
+	{
+		std::cout << (app_name + " [-e ephemeris-location] -o compact-location [-start date] [-end date] [-planets name,name,...]") << std::endl;
+		std::cout << std::endl;
+		std::cout << "-e defaults to './data/jpleph.430'" << std::endl;
+		std::cout << "-start and -end default to the span of the source file; dates are YYYY, YYYY-MM or YYYY-MM-DD" << std::endl;
+		std::cout << "-planets defaults to all of: Mercury, Venus, Earth, Mars, Jupiter, Saturn, Uranus, Neptune, Pluto, Sun, Moon" << std::endl;
+		std::cout << "The Earth, Moon and Sun are always kept; every position needs them." << std::endl;
+		return 0;
+	}
+
+	n_json rv;
+
+	try
+	{
+		std::string em_path = option ("-e", "./data/jpleph.430");
+		std::string compact_path = option ("-o", "");
+
+		ephemeris_reader reader (em_path, ephemeris_access::mapped);
+
+		// One day either side keeps the UTC dates inside the span whatever TDB - UTC is.
+		double jd_begin = reader.eph_begin ();
+		double jd_end = reader.eph_end ();
+
+		if (!option ("-start", "").empty ()) {
+			jd_begin = std::max (jd_begin, julian_date_of (option ("-start", "")) - 1.0);
+		}
+
+		if (!option ("-end", "").empty ()) {
+			jd_end = std::min (jd_end, julian_date_of (option ("-end", "")) + 1.0);
+		}
+
+		std::vector<short> targets;
+		n_json arg_planets;
+
+		std::istringstream names (option ("-planets", ""));
+		for (std::string name; std::getline (names, name, ',');) {
+			auto p = std::find_if (novas_constants::all_planets.begin (), novas_constants::all_planets.end (),
+				[&](novas_planet const& planet) { return iequals (planet.name, name); });
+			if (iequals (name, novas_constants::EARTH.name)) {
+				targets.push_back (ephemeris_target (novas_constants::EARTH));
+			}
+			else if (p != novas_constants::all_planets.end ()) {
+				targets.push_back (ephemeris_target (*p));
+			}
+			else {
+				throw std::runtime_error ("unknown planet '" + name + "'");
+			}
+			arg_planets.push_back (name);
+		}
+
+		reader.extract (compact_path, jd_begin, jd_end, targets);
+
+		ephemeris_reader compact (compact_path, ephemeris_access::buffered);
+
+		rv["source"] = { { "path", em_path }, { "bytes", file_size (em_path) }, { "start_julian", reader.eph_begin () }, { "end_julian", reader.eph_end () } };
+		rv["compact"] = { { "path", compact_path }, { "bytes", file_size (compact_path) }, { "start_julian", compact.eph_begin () }, { "end_julian", compact.eph_end () } };
+		rv["planets"] = arg_planets.is_null () ? n_json ("all") : arg_planets;
+	}
+	catch (std::exception & e) {
+		rv["error"] = e.what ();
+		std::cout << rv.dump (2) << std::endl;
+		return 1;
+	}
+
+	std::cout << rv.dump (2) << std::endl;
+	return 0;
+}
@@ -14,11 +14,46 @@
    #include "eph_manager.h"
 #endif
 
+#include <string.h>
+
+#if defined(_WIN32)
+   #include <windows.h>
+   #include <io.h>
+#else
+   #include <pthread.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+#endif
+
+#if defined(_MSC_VER)
+   #define EPH_THREAD_LOCAL __declspec(thread)
+#else
+   #define EPH_THREAD_LOCAL _Thread_local
+#endif
+
 /*
-   Define global variables
+   The AVX2 kernels are compiled for x86 only, and selected at run time
+   when the processor supports them.  FMA is deliberately not enabled:
+   every kernel performs the same roundings, so results do not depend
+   on the kernel in use.
 */
 
-short int KM;
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+   #define EPH_HAVE_AVX2
+   #include <immintrin.h>
+   #if defined(_MSC_VER)
+      #include <intrin.h>
+      #define EPH_TARGET_AVX2
+   #else
+      #define EPH_TARGET_AVX2 __attribute__ ((target ("avx2")))
+   #endif
+#endif
+
+/*
+   Define global variables.  These hold the header values of the file
+   opened by 'ephem_open'; all per-file state lives in 'ephem_reader'.
+*/
 
 /*
    IPT and LPT defined as int to support 64 bit systems.
@@ -26,14 +61,120 @@ short int KM;
 
 int IPT[3][12], LPT[3];
 
-long int NRL, NP, NV;
 long int RECORD_LENGTH;
 
-double SS[3], JPLAU, PC[18], VC[18], TWOT, EM_RATIO;
-double *BUFFER;
+double SS[3], JPLAU, EM_RATIO;
 
 FILE *EPHFILE = NULL;
 
+/*
+   Reader used by 'ephem_open', 'state' and 'planet_ephemeris', unless
+   the calling thread has bound its own with 'ephem_reader_bind'.
+*/
+
+static ephem_reader DEFAULT_READER;
+static EPH_THREAD_LOCAL ephem_reader *BOUND_READER = NULL;
+
+/*
+   Polynomial cache for the reader-less 'interpolate' entry point.
+*/
+
+static EPH_THREAD_LOCAL cheby_basis INTERPOLATE_BASIS;
+
+/*
+   Chebyshev summation kernel in use: the scalar kernel until the first
+   reader opens, when 'detect_kernel' selects the fastest the processor
+   supports, once for the process.  Every thread that computes
+   positions has opened a reader, or uses one opened before it started,
+   so it reads KERNEL after that selection.
+*/
+
+static short int KERNEL = EPH_KERNEL_SCALAR;
+
+#if defined(_WIN32)
+   static INIT_ONCE KERNEL_ONCE = INIT_ONCE_STATIC_INIT;
+#else
+   static pthread_once_t KERNEL_ONCE = PTHREAD_ONCE_INIT;
+#endif
+
+/*
+   Coefficient precision 'state' uses on this thread.
+*/
+
+static EPH_THREAD_LOCAL short int PRECISION = EPH_PRECISION_DOUBLE;
+
+static ephem_reader *current_reader (void);
+static void copy_default_header (void);
+static void reset_basis (cheby_basis *basis);
+static long int update_basis (cheby_basis *basis, double *t,
+                              long int ncf, long int na, double *vfac);
+static void evaluate_chebyshev (cheby_basis *basis, double *buf,
+                                double *t, long int ncf, long int na,
+                                double *position, double *velocity);
+static void evaluate_chebyshev_single (cheby_basis *basis, float *buf,
+                                       double *t, long int ncf,
+                                       long int na, double *position,
+                                       double *velocity);
+static void sum_series (double *pc, double *vc, double *buf,
+                        long int ncf, double vfac,
+                        double *position, double *velocity);
+static void sum_series_scalar (double *pc, double *vc, double *buf,
+                               long int ncf, double vfac,
+                               double *position, double *velocity);
+static void sum_series_single (double *pc, double *vc, float *buf,
+                               long int ncf, double vfac,
+                               double *position, double *velocity);
+static void sum_series_single_scalar (double *pc, double *vc, float *buf,
+                                      long int ncf, double vfac,
+                                      double *position,
+                                      double *velocity);
+static short int cpu_has_avx2 (void);
+static void select_detected_kernel (void);
+#if defined(_WIN32)
+static BOOL CALLBACK detect_kernel (PINIT_ONCE once, PVOID parameter,
+                                    PVOID *context);
+#else
+static void detect_kernel (void);
+#endif
+#if defined(EPH_HAVE_AVX2)
+static void sum_series_single_avx2 (double *pc, double *vc, float *buf,
+                                    long int ncf, double vfac,
+                                    double *position, double *velocity);
+static void sum_series_avx2 (double *pc, double *vc, double *buf,
+                             long int ncf, double vfac,
+                             double *position, double *velocity);
+static void interpolate_4_avx2 (double *buf, double *t, double span,
+                                long int ncf, long int na,
+                                double *position, double *velocity);
+#endif
+static short int map_reader_file (ephem_reader *reader);
+static void unmap_reader_file (ephem_reader *reader);
+static short int allocate_cache (ephem_reader *reader);
+static void free_cache (ephem_reader *reader);
+static void free_preload (ephem_reader *reader);
+static void free_single (ephem_reader *reader);
+static double *find_record (ephem_reader *reader, long int nr);
+static short int covering_records (ephem_reader *reader, double jd_begin,
+                                   double jd_end, long int *first,
+                                   long int *last);
+static short int record_time (ephem_reader *reader, double *jed,
+                              long int *nr, double *t);
+static int compare_batch_epochs (const void *a, const void *b);
+
+/*
+   Epochs of 'ephem_reader_state_batch' are grouped by record in blocks
+   of EPH_BATCH_BLOCK.
+*/
+
+#define EPH_BATCH_BLOCK 256
+
+typedef struct
+{
+   long int nr;
+   double t;
+   size_t index;
+} batch_epoch;
+
 /********ephem_open */
 
 short int ephem_open (char *ephem_name,
@@ -74,32 +215,21 @@ short int ephem_open (char *ephem_name,
           2-10...error reading from file header.
           11  ...unable to set record length; ephemeris (DE number)
                  not in look-up table.
+          12  ...unable to allocate the record cache.
 
    GLOBALS
    USED:
       SS                eph_manager.h
       JPLAU             eph_manager.h
-      PC                eph_manager.h
-      VC                eph_manager.h
-      TWOT              eph_manager.h
       EM_RATIO          eph_manager.h
-      BUFFER            eph_manager.h
       IPT               eph_manager.h
       LPT               eph_manager.h
-      NRL               eph_manager.h
-      KM                eph_manager.h
-      NP                eph_manager.h
-      NV                eph_manager.h
       RECORD_LENGTH     eph_manager.h
       EPHFILE           eph_manager.h
 
    FUNCTIONS
    CALLED:
-      fclose            stdio.h
-      free              stdlib.h
-      fopen             stdio.h
-      fread             stdio.h
-      calloc            stdlib.h
+      ephem_reader_open eph_manager.h
 
    VER./DATE/
    PROGRAMMER:
@@ -115,12 +245,241 @@ short int ephem_open (char *ephem_name,
                                 for switch, close file on error.
       V1.6/10-10/WKP (USNO/AA): Renamed function to lowercase to
                                 comply with coding standards.
+      V1.7/10-26 (planetaria):  Opens the default 'ephem_reader'; the
+                                file is read by 'ephem_reader_open'.
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error;
+
+   error = ephem_reader_open (&DEFAULT_READER, ephem_name,
+      EPH_ACCESS_BUFFERED, jd_begin,jd_end,de_number);
+   copy_default_header ();
+
+   return error;
+}
+
+/********ephem_close */
+
+short int ephem_close (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function closes a JPL planetary ephemeris file and frees the
+      memory.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+          0  ...file was already closed or closed correctly.
+          EOF...error closing file.
+
+   GLOBALS
+   USED:
+      EPHFILE           eph_manager.h
+
+   FUNCTIONS
+   CALLED:
+      ephem_reader_close
+                        eph_manager.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/11-07/WKP (USNO/AA)
+      V1.1/09-10/WKP (USNO/AA): Explicitly cast fclose return value to
+                                type 'short int'.
+      V1.2/10-10/WKP (USNO/AA): Renamed function to lowercase to
+                                comply with coding standards.
+      V1.3/10-26 (planetaria):  Closes the default 'ephem_reader'.
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error;
+
+   error = ephem_reader_close (&DEFAULT_READER);
+   EPHFILE = NULL;
+
+   return error;
+}
+
+/********ephem_open_mapped */
+
+short int ephem_open_mapped (char *ephem_name,
+
+                             double *jd_begin, double *jd_end,
+                             short int *de_number)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function opens a JPL planetary ephemeris file in the same
+      way as 'ephem_open', then maps the whole file into memory so
+      that 'state' addresses Chebyshev records in place instead of
+      seeking and reading them into 'BUFFER'.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *ephem_name (char)
+         Name of the direct-access ephemeris file.
+
+   OUTPUT
+   ARGUMENTS:
+      *jd_begin (double)
+         Beginning Julian date of the ephemeris file.
+      *jd_end (double)
+         Ending Julian date of the ephemeris file.
+      *de_number (short int)
+         DE number of the ephemeris file opened.
+
+   RETURNED
+   VALUE:
+      (short int)
+          0   ...file exists and is opened and mapped correctly.
+          1-11...error reading the file, as for 'ephem_open'.
+          12  ...unable to map the ephemeris file into memory.
+
+   GLOBALS
+   USED:
+      SS                eph_manager.h
+      JPLAU             eph_manager.h
+      EM_RATIO          eph_manager.h
+      IPT               eph_manager.h
+      LPT               eph_manager.h
+      RECORD_LENGTH     eph_manager.h
+      EPHFILE           eph_manager.h
+
+   FUNCTIONS
+   CALLED:
+      ephem_reader_open eph_manager.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The file handle stays open while the mapping exists; it is
+         released, together with the mapping, by 'ephem_close'.
+      2. Opens the default 'ephem_reader' with EPH_ACCESS_MAPPED.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error;
+
+   error = ephem_reader_open (&DEFAULT_READER, ephem_name,
+      EPH_ACCESS_MAPPED, jd_begin,jd_end,de_number);
+   copy_default_header ();
+
+   return error;
+}
+
+/********ephem_reader_open */
+
+short int ephem_reader_open (ephem_reader *reader, char *ephem_name,
+                             short int access,
+
+                             double *jd_begin, double *jd_end,
+                             short int *de_number)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function opens a JPL planetary ephemeris file into 'reader'
+      and sets its initial values.  Each reader owns its file handle or
+      mapping, header data and record cache, so readers held by
+      different threads can be used concurrently.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Reader to open; must be zero-initialized or previously used
+         with this function.  Any file it holds is closed first.
+      *ephem_name (char)
+         Name of the direct-access ephemeris file.
+      access (short int)
+         EPH_ACCESS_BUFFERED ... read records into the cache on demand.
+         EPH_ACCESS_MAPPED   ... map the file and address records in
+                                 place.
+
+   OUTPUT
+   ARGUMENTS:
+      *jd_begin (double)
+         Beginning Julian date of the ephemeris file.
+      *jd_end (double)
+         Ending Julian date of the ephemeris file.
+      *de_number (short int)
+         DE number of the ephemeris file opened.
+
+   RETURNED
+   VALUE:
+      (short int)
+          0   ...file exists and is opened correctly.
+          1   ...file does not exist/not found.
+          2-10...error reading from file header.
+          11  ...unable to set record length; ephemeris (DE number)
+                 not in look-up table.
+          12  ...unable to allocate the record cache or map the file.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      ephem_reader_close
+                        eph_manager.h
+      ephem_reader_reset_stats
+                        eph_manager.h
+      allocate_cache    eph_manager.c
+      map_reader_file   eph_manager.c
+      select_detected_kernel
+                        eph_manager.c
+      fclose            stdio.h
+      fopen             stdio.h
+      fread             stdio.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria):  Per-reader version of 'ephem_open'.
+      V1.1/10-26 (planetaria):  Opens compact files written by
+                                'ephem_reader_extract'.
+      V1.2/10-26 (planetaria):  The first successful open selects the
+                                Chebyshev kernel.
 
    NOTES:
-      KM...flag defining physical units of the output states.
+      1. reader->km is the flag defining physical units of the output
+         states.
          = 1, km and km/sec
          = 0, AU and AU/day
-      Default value is 0 (KM determines time unit for nutations.
+      Default value is 0 (km determines time unit for nutations.
                           Angle unit is always radians.)
 
 ------------------------------------------------------------------------
@@ -130,19 +489,15 @@ short int ephem_open (char *ephem_name,
 
    short int i, j;
 
-   int ncon, denum;
+   int ncon, denum, compact[2];
 
-   if (EPHFILE)
-   {
-      fclose (EPHFILE);
-      free (BUFFER);
-   }
+   ephem_reader_close (reader);
 
 /*
    Open file ephem_name.
 */
 
-   if ((EPHFILE = fopen (ephem_name, "rb")) == NULL)
+   if ((reader->file = fopen (ephem_name, "rb")) == NULL)
    {
       return 1;
    }
@@ -153,93 +508,96 @@ short int ephem_open (char *ephem_name,
    File found. Set initializations and default values.
 */
 
-      KM = 0;
-
-      NRL = 0;
+      reader->km = 0;
 
-      NP = 2;
-      NV = 3;
-      TWOT = 0.0;
-
-      for (i = 0; i < 18; i++)
-      {
-         PC[i] = 0.0;
-         VC[i] = 0.0;
-      }
-
-      PC[0] = 1.0;
-      VC[1] = 1.0;
+      reset_basis (&reader->basis);
 
 /*
    Read in values from the first record, aka the header.
 */
 
-      if (fread (ttl, sizeof ttl, 1, EPHFILE) != 1)
+      if (fread (ttl, sizeof ttl, 1, reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 2;
       }
-      if (fread (cnam, sizeof cnam, 1, EPHFILE) != 1)
+      if (fread (cnam, sizeof cnam, 1, reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 3;
       }
-      if (fread (SS, sizeof SS, 1, EPHFILE) != 1)
+      if (fread (reader->ss, sizeof reader->ss, 1, reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 4;
       }
-      if (fread (&ncon, sizeof ncon, 1, EPHFILE) != 1)
+      if (fread (&ncon, sizeof ncon, 1, reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 5;
       }
-      if (fread (&JPLAU, sizeof JPLAU, 1, EPHFILE) != 1)
+      if (fread (&reader->jplau, sizeof reader->jplau, 1,
+         reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 6;
       }
-      if (fread (&EM_RATIO, sizeof EM_RATIO, 1, EPHFILE) != 1)
+      if (fread (&reader->em_ratio, sizeof reader->em_ratio, 1,
+         reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 7;
       }
       for (i = 0; i < 12; i++)
          for (j = 0; j < 3; j++)
-            if (fread (&IPT[j][i], sizeof(int), 1, EPHFILE) != 1)
+            if (fread (&reader->ipt[j][i], sizeof(int), 1,
+               reader->file) != 1)
             {
-               fclose (EPHFILE);
+               fclose (reader->file);
+               reader->file = NULL;
                return 8;
             }
-      if (fread (&denum, sizeof denum, 1, EPHFILE) != 1)
+      if (fread (&denum, sizeof denum, 1, reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 9;
       }
-      if (fread (LPT, sizeof LPT, 1, EPHFILE) != 1)
+      if (fread (reader->lpt, sizeof reader->lpt, 1, reader->file) != 1)
       {
-         fclose (EPHFILE);
+         fclose (reader->file);
+         reader->file = NULL;
          return 10;
       }
 
 /*
    Set the value of the record length according to what JPL ephemeris is
-   being opened.
+   being opened.  A compact file written by 'ephem_reader_extract'
+   carries its own record length after LPT.
 */
 
-      switch (denum)
+      if ((fread (compact, sizeof compact, 1, reader->file) == 1) &&
+          (compact[0] == EPH_COMPACT_MAGIC) && (compact[1] > 0))
+         reader->record_length = compact[1];
+       else switch (denum)
       {
          case 200:
-            RECORD_LENGTH = 6608;
+            reader->record_length = 6608;
             break;
          case 403: case 405:
          case 421:
          case 430:
          case 431:
-            RECORD_LENGTH = 8144;
+            reader->record_length = 8144;
             break;
          case 404: case 406:
-            RECORD_LENGTH = 5824;
+            reader->record_length = 5824;
             break;
 
 /*
@@ -251,38 +609,66 @@ short int ephem_open (char *ephem_name,
             *jd_begin = 0.0;
             *jd_end = 0.0;
             *de_number = 0;
-            fclose (EPHFILE);
+            fclose (reader->file);
+            reader->file = NULL;
             return 11;
             break;
       }
 
-      BUFFER = (double *) calloc (RECORD_LENGTH / 8, sizeof(double));
+      if (allocate_cache (reader))
+      {
+         fclose (reader->file);
+         reader->file = NULL;
+         return 12;
+      }
+
+/*
+   Map the file if requested.
+*/
+
+      if (access == EPH_ACCESS_MAPPED)
+      {
+         if (map_reader_file (reader))
+         {
+            ephem_reader_close (reader);
+            return 12;
+         }
+      }
+
+      reader->access = access;
+      reader->de_number = (short int) denum;
+
+      ephem_reader_reset_stats (reader);
+      select_detected_kernel ();
 
       *de_number = (short int) denum;
-      *jd_begin = SS[0];
-      *jd_end = SS[1];
+      *jd_begin = reader->ss[0];
+      *jd_end = reader->ss[1];
    }
 
    return 0;
 }
 
-/********ephem_close */
 
-short int ephem_close (void)
+
+/********ephem_reader_close */
+
+short int ephem_reader_close (ephem_reader *reader)
 /*
 ------------------------------------------------------------------------
 
    PURPOSE:
-      This function closes a JPL planetary ephemeris file and frees the
-      memory.
+      This function closes the ephemeris file held by 'reader', removes
+      its mapping and frees its memory.  The reader may be reopened
+      with 'ephem_reader_open'.
 
    REFERENCES:
-      Standish, E.M. and Newhall, X X (1988). "The JPL Export
-         Planetary Ephemeris"; JPL document dated 17 June 1988.
+      None.
 
    INPUT
    ARGUMENTS:
-      None.
+      *reader (ephem_reader)
+         Reader to close.
 
    OUTPUT
    ARGUMENTS:
@@ -296,21 +682,19 @@ short int ephem_close (void)
 
    GLOBALS
    USED:
-      BUFFER            eph_manager.h
-      EPHFILE           eph_manager.h
+      None.
 
    FUNCTIONS
    CALLED:
+      unmap_reader_file eph_manager.c
+      free_cache        eph_manager.c
+      free_preload      eph_manager.c
+      free_single       eph_manager.c
       fclose            stdio.h
-      free              stdlib.h
 
    VER./DATE/
    PROGRAMMER:
-      V1.0/11-07/WKP (USNO/AA)
-      V1.1/09-10/WKP (USNO/AA): Explicitly cast fclose return value to
-                                type 'short int'.
-      V1.2/10-10/WKP (USNO/AA): Renamed function to lowercase to
-                                comply with coding standards.
+      V1.0/10-26 (planetaria):  Per-reader version of 'ephem_close'.
 
    NOTES:
       None.
@@ -320,40 +704,1885 @@ short int ephem_close (void)
 {
    short int error = 0;
 
-   if (EPHFILE)
+   if (reader->file)
    {
-      error =  (short int) fclose (EPHFILE);
-      EPHFILE = NULL; // new line, reset pointer
-      free (BUFFER);
+      unmap_reader_file (reader);
+      error = (short int) fclose (reader->file);
+      reader->file = NULL;
+      free_cache (reader);
+      free_preload (reader);
+      free_single (reader);
    }
    return error;
 }
 
-/********planet_ephemeris */
-
-short int planet_ephemeris (double tjd[2], short int target,
-                            short int center,
+/********ephem_reader_bind */
 
-                            double *position, double *velocity)
+ephem_reader *ephem_reader_bind (ephem_reader *reader)
 /*
 ------------------------------------------------------------------------
 
    PURPOSE:
-      This function accesses the JPL planetary ephemeris to give the
-      position and velocity of the target object with respect to the
-      center object.
+      Makes 'reader' the one used by 'state' and 'planet_ephemeris' -
+      and so by 'solarsystem' and the NOVAS functions above it - on
+      the calling thread.  Other threads are not affected.
 
    REFERENCES:
-      Standish, E.M. and Newhall, X X (1988). "The JPL Export
-         Planetary Ephemeris"; JPL document dated 17 June 1988.
+      None.
 
    INPUT
    ARGUMENTS:
-      tjd[2] (double)
-         Two-element array containing the Julian date, which may be
-         split any way (although the first element is usually the
-         "integer" part, and the second element is the "fractional"
-         part).  Julian date is in the TDB or "T_eph" time scale.
+      *reader (ephem_reader)
+         Reader to bind, or NULL to return to the reader opened by
+         'ephem_open'.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (ephem_reader *)
+         The reader previously bound on this thread (NULL for the
+         default reader), so that callers can restore it.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   ephem_reader *previous = BOUND_READER;
+
+   BOUND_READER = reader;
+   return previous;
+}
+
+/********ephem_default_reader */
+
+ephem_reader *ephem_default_reader (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the reader opened by 'ephem_open' and 'ephem_open_mapped',
+      so that its cache can be configured and its counters read.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (ephem_reader *)
+         The default reader.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   return &DEFAULT_READER;
+}
+
+/********ephem_current_reader */
+
+ephem_reader *ephem_current_reader (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the reader 'state' uses on the calling thread: the one
+      bound with 'ephem_reader_bind', or the default reader.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (ephem_reader *)
+         The reader in use on this thread.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      current_reader    eph_manager.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   return current_reader ();
+}
+
+/********ephem_reader_set_cache_size */
+
+short int ephem_reader_set_cache_size (ephem_reader *reader,
+                                       long int records)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Sets the number of Chebyshev records a buffered reader keeps in
+      memory.  Records are kept by record number and the least recently
+      used one is replaced on a miss, so queries that alternate between
+      a few records (several bodies over a multi-day window, or a root
+      finder iterating across a record boundary) read each record once.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Open or closed reader.  The size is kept across
+         'ephem_reader_open' calls.
+      records (long int)
+         Number of records to cache (1 reproduces the single-record
+         behavior of the original 'state').
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0...everything OK.
+         1...invalid value of 'records'.
+         2...unable to allocate the cache; the reader has been closed.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      allocate_cache    eph_manager.c
+      ephem_reader_close
+                        eph_manager.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. Changing the size of an open reader empties its cache.  The
+         hit and miss counters are not reset.
+      2. Mapped readers address records in place and do not use the
+         cache.
+
+------------------------------------------------------------------------
+*/
+{
+   if (records < 1)
+      return 1;
+
+   reader->cache_size = records;
+
+   if (reader->file && allocate_cache (reader))
+   {
+      ephem_reader_close (reader);
+      return 2;
+   }
+
+   return 0;
+}
+
+/********ephem_reader_reset_stats */
+
+void ephem_reader_reset_stats (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Sets the reader's access counters to zero: record cache hits
+      and misses, record switches, reads from the file, and
+      interpolations per body.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Open or closed reader.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+      V1.1/10-26 (planetaria):  Resets the counters added to support
+                                per-request cost attribution.
+
+   NOTES:
+      1. 'ephem_reader_open' resets the counters; the reads of the
+         header are not counted.
+      2. 'record_switches' counts the 'state' calls, and the groups of
+         'ephem_reader_state_batch' epochs, whose record differs from
+         that of the previous one, whether or not it had to be read.
+         'reads' counts calls to 'fread' for record data (one per
+         cache miss, one per preload), 'records_read' and 'bytes_read'
+         the record data they returned.  'interpolations' counts
+         evaluated epochs by 'state' target.
+
+------------------------------------------------------------------------
+*/
+{
+   short int i;
+
+   reader->cache_hits = 0;
+   reader->cache_misses = 0;
+   reader->record_switches = 0;
+   reader->record_last = 0;
+   reader->reads = 0;
+   reader->records_read = 0;
+   reader->bytes_read = 0;
+   for (i = 0; i < EPH_STATE_TARGETS; i++)
+      reader->interpolations[i] = 0;
+}
+
+/********ephem_reader_preload */
+
+short int ephem_reader_preload (ephem_reader *reader, double jd_begin,
+                                double jd_end)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Reads the Chebyshev records covering 'jd_begin' to 'jd_end' into
+      one contiguous, cache-line aligned block, from which 'state'
+      then serves every epoch in that range without touching the file.
+      Epochs outside the range are still read from the file.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Open reader.
+      jd_begin (double)
+         Beginning TDB Julian date of the range to preload.
+      jd_end (double)
+         Ending TDB Julian date of the range to preload.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0...everything OK.
+         1...reader not open, or 'jd_end' before 'jd_begin'.
+         2...range does not overlap the ephemeris file.
+         3...unable to allocate memory for the records.
+         4...error reading ephemeris file.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      covering_records  eph_manager.c
+      free_preload      eph_manager.c
+      unmap_reader_file eph_manager.c
+      malloc            stdlib.h
+      fseek             stdio.h
+      fread             stdio.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The range is clipped to the span of the file.  A previous
+         preload is released first.
+      2. A mapped reader is unmapped, so that only the preloaded
+         records stay resident; it reverts to buffered access (through
+         the record cache) for epochs outside the range.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error;
+
+   long int first, last, count;
+   size_t bytes;
+
+   char *block;
+
+   if ((error = covering_records (reader, jd_begin, jd_end, &first,
+      &last)) != 0)
+      return error;
+
+   free_preload (reader);
+
+   count = last - first + 1;
+   bytes = (size_t) count * (size_t) reader->record_length;
+
+/*
+   Allocate with room to align the records to a 64-byte boundary.
+*/
+
+   if ((reader->preload_block = malloc (bytes + 64)) == NULL)
+      return 3;
+
+   block = (char *) reader->preload_block;
+   block += (64 - ((size_t) block % 64)) % 64;
+
+   fseek (reader->file, (first - 1) * reader->record_length, SEEK_SET);
+   reader->reads++;
+   if (fread (block, reader->record_length, (size_t) count,
+      reader->file) != (size_t) count)
+   {
+      free_preload (reader);
+      return 4;
+   }
+   reader->records_read += (unsigned long int) count;
+   reader->bytes_read += (unsigned long int) bytes;
+
+   reader->preload = (double *) block;
+   reader->preload_first = first;
+   reader->preload_count = count;
+
+   if (reader->access == EPH_ACCESS_MAPPED)
+   {
+      unmap_reader_file (reader);
+   }
+
+   return 0;
+}
+
+/********ephem_reader_load_single */
+
+short int ephem_reader_load_single (ephem_reader *reader,
+                                    double jd_begin, double jd_end)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Keeps a single-precision (float) copy of the Chebyshev records
+      covering 'jd_begin' to 'jd_end', which 'state' evaluates instead
+      of the double-precision records on threads that have selected
+      EPH_PRECISION_SINGLE.  Intended for coarse screening, such as the
+      grid of a root bracketing pass, where it halves the coefficient
+      data read per evaluation.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Open reader.
+      jd_begin (double)
+         Beginning TDB Julian date of the range to copy.
+      jd_end (double)
+         Ending TDB Julian date of the range to copy.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0...everything OK.
+         1...reader not open, or 'jd_end' before 'jd_begin'.
+         2...range does not overlap the ephemeris file.
+         3...unable to allocate memory for the records.
+         4...error reading ephemeris file.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      covering_records  eph_manager.c
+      find_record       eph_manager.c
+      free_single       eph_manager.c
+      malloc            stdlib.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The range is clipped to the span of the file.  A previous
+         copy is released first.  The double-precision records are
+         not affected, and are used for epochs outside the range.
+      2. Each coefficient is rounded to the nearest float, a relative
+         error of at most 2^-24 (6.0e-8); the series are still summed
+         in double precision.  Since no Chebyshev polynomial exceeds 1
+         in magnitude, a position component is in error by at most
+         2^-24 times the sum of the magnitudes of its coefficients,
+         which is dominated by the body's distance from the origin of
+         its series: about 9 km for the Earth-Moon barycenter, 50 km
+         for Jupiter, 0.06 km for the Sun and 0.025 km for the
+         geocentric Moon.  Seen from the Earth this is at most about
+         0.02 arcsecond in direction (0.012 arcsecond for the Sun and
+         Moon), or a few milliseconds in the time of a rise or set.
+         A velocity component is in error by at most 2^-24 times the
+         sum of n^2 |c(n)| over its coefficients, in the units of the
+         series per half sub-interval.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error;
+
+   long int first, last, count, doubles, r, i;
+   size_t bytes;
+
+   char *block;
+   float *out;
+   double *record;
+
+   if ((error = covering_records (reader, jd_begin, jd_end, &first,
+      &last)) != 0)
+      return error;
+
+   free_single (reader);
+
+   count = last - first + 1;
+   doubles = reader->record_length / 8;
+   bytes = (size_t) count * (size_t) doubles * sizeof (float);
+
+/*
+   Allocate with room to align the records to a 64-byte boundary.
+*/
+
+   if ((reader->single_block = malloc (bytes + 64)) == NULL)
+      return 3;
+
+   block = (char *) reader->single_block;
+   block += (64 - ((size_t) block % 64)) % 64;
+
+   out = (float *) block;
+   for (r = first; r <= last; r++)
+   {
+      if ((record = find_record (reader, r)) == NULL)
+      {
+         free_single (reader);
+         return 4;
+      }
+      for (i = 0; i < doubles; i++)
+         *out++ = (float) record[i];
+   }
+
+   reader->single = (float *) block;
+   reader->single_first = first;
+   reader->single_count = count;
+
+   return 0;
+}
+
+/********ephem_reader_extract */
+
+short int ephem_reader_extract (ephem_reader *reader, char *compact_name,
+                                double jd_begin, double jd_end,
+                                long int series)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Writes a compact ephemeris file holding only the selected series
+      of the records covering 'jd_begin' to 'jd_end'.  The compact file
+      is opened by 'ephem_reader_open' (and 'ephem_open') like the DE
+      file it was extracted from.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Open reader of the source file.
+      *compact_name (char)
+         Name of the compact file to write.
+      jd_begin (double)
+         Beginning TDB Julian date of the range to extract.
+      jd_end (double)
+         Ending TDB Julian date of the range to extract.
+      series (long int)
+         Series to keep: an OR of (1L << target) for 'state' targets
+         0-10, EPH_SERIES_NUTATIONS and EPH_SERIES_LIBRATIONS.
+         EPH_SERIES_PLANETARY keeps everything 'planet_ephemeris'
+         needs.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0...everything OK.
+         1...reader not open, 'jd_end' before 'jd_begin', or no series
+             selected.
+         2...range does not overlap the ephemeris file.
+         3...unable to create the compact file, or to allocate its
+             record buffer.
+         4...error reading ephemeris file.
+         5...error writing the compact file.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      covering_records  eph_manager.c
+      find_record       eph_manager.c
+      calloc            stdlib.h
+      free              stdlib.h
+      memcpy            string.h
+      memset            string.h
+      fopen             stdio.h
+      fclose            stdio.h
+      fseek             stdio.h
+      fread             stdio.h
+      fwrite            stdio.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The compact file keeps the layout of a DE file: the header in
+         record 1 (with the kept series renumbered in IPT and LPT, a
+         dropped series having all three entries zero, and the span
+         in SS clipped to the extracted records), record 2 empty (the
+         constants are not used by NOVAS), then one record per
+         source record with its two time values followed by the kept
+         series.  EPH_COMPACT_MAGIC and the record length follow LPT
+         in the header.
+      2. Planets are computed relative to the Earth-Moon barycenter
+         and the Moon, so 'planet_ephemeris' (and 'place') need targets
+         2 and 9 (and the Sun, 10, for light deflection) whichever
+         other bodies are kept.
+
+------------------------------------------------------------------------
+*/
+{
+   char ttl[252], cnam[2400];
+
+   short int i, error;
+
+   int ipt[3][12], lpt[3], compact[2], denum, ncon = 0;
+   long int first, last, nr, ncoeff, record_length, header, offset;
+
+   double ss[3];
+   double *record, *out;
+
+   FILE *compact_file;
+
+   if ((reader->file == NULL) || ((series & (EPH_SERIES_PLANETARY |
+      EPH_SERIES_NUTATIONS | EPH_SERIES_LIBRATIONS)) == 0))
+      return 1;
+
+   if ((error = covering_records (reader, jd_begin, jd_end, &first,
+      &last)) != 0)
+      return error;
+
+/*
+   Title and constant names are copied from the source header.
+*/
+
+   fseek (reader->file, 0L, SEEK_SET);
+   if ((fread (ttl, sizeof ttl, 1, reader->file) != 1) ||
+       (fread (cnam, sizeof cnam, 1, reader->file) != 1))
+      return 4;
+
+/*
+   Lay out the kept series one after the other, following the two time
+   values.  Nutations have two components, every other series three.
+*/
+
+   ncoeff = 2;
+   for (i = 0; i < 12; i++)
+   {
+      if ((series & (1L << i)) && (reader->ipt[1][i] > 0))
+      {
+         ipt[0][i] = (int) ncoeff + 1;
+         ipt[1][i] = reader->ipt[1][i];
+         ipt[2][i] = reader->ipt[2][i];
+         ncoeff += (long int) ipt[1][i] * ipt[2][i] * ((i == 11) ? 2 : 3);
+      }
+       else
+         ipt[0][i] = ipt[1][i] = ipt[2][i] = 0;
+   }
+   if ((series & EPH_SERIES_LIBRATIONS) && (reader->lpt[1] > 0))
+   {
+      lpt[0] = (int) ncoeff + 1;
+      lpt[1] = reader->lpt[1];
+      lpt[2] = reader->lpt[2];
+      ncoeff += (long int) lpt[1] * lpt[2] * 3;
+   }
+    else
+      lpt[0] = lpt[1] = lpt[2] = 0;
+
+/*
+   The record must also hold the header.
+*/
+
+   header = (long int) (sizeof ttl + sizeof cnam + sizeof ss +
+      sizeof ncon + 2 * sizeof (double) + sizeof ipt + sizeof denum +
+      sizeof lpt + sizeof compact);
+   record_length = ncoeff * 8;
+   if (record_length < header)
+      record_length = (header + 7) / 8 * 8;
+
+   ss[0] = reader->ss[0] + (double) (first - 3) * reader->ss[2];
+   ss[1] = reader->ss[0] + (double) (last - 2) * reader->ss[2];
+   ss[2] = reader->ss[2];
+   denum = reader->de_number;
+   compact[0] = EPH_COMPACT_MAGIC;
+   compact[1] = (int) record_length;
+
+   if ((out = (double *) calloc ((size_t) record_length, 1)) == NULL)
+      return 3;
+
+   if ((compact_file = fopen (compact_name, "wb")) == NULL)
+   {
+      free (out);
+      return 3;
+   }
+
+/*
+   Record 1: the header, in the order read by 'ephem_reader_open'.
+   Record 2: empty.
+*/
+
+   offset = 0;
+   memcpy ((char *) out + offset, ttl, sizeof ttl);
+   offset += sizeof ttl;
+   memcpy ((char *) out + offset, cnam, sizeof cnam);
+   offset += sizeof cnam;
+   memcpy ((char *) out + offset, ss, sizeof ss);
+   offset += sizeof ss;
+   memcpy ((char *) out + offset, &ncon, sizeof ncon);
+   offset += sizeof ncon;
+   memcpy ((char *) out + offset, &reader->jplau, sizeof (double));
+   offset += sizeof (double);
+   memcpy ((char *) out + offset, &reader->em_ratio, sizeof (double));
+   offset += sizeof (double);
+   for (i = 0; i < 12; i++)
+   {
+      memcpy ((char *) out + offset, &ipt[0][i], sizeof (int));
+      memcpy ((char *) out + offset + sizeof (int), &ipt[1][i],
+         sizeof (int));
+      memcpy ((char *) out + offset + 2 * sizeof (int), &ipt[2][i],
+         sizeof (int));
+      offset += 3 * sizeof (int);
+   }
+   memcpy ((char *) out + offset, &denum, sizeof denum);
+   offset += sizeof denum;
+   memcpy ((char *) out + offset, lpt, sizeof lpt);
+   offset += sizeof lpt;
+   memcpy ((char *) out + offset, compact, sizeof compact);
+
+   error = 0;
+   if (fwrite (out, (size_t) record_length, 1, compact_file) != 1)
+      error = 5;
+
+   memset (out, 0, (size_t) record_length);
+   if (!error && (fwrite (out, (size_t) record_length, 1,
+      compact_file) != 1))
+      error = 5;
+
+/*
+   Data records.
+*/
+
+   for (nr = first; !error && (nr <= last); nr++)
+   {
+      if ((record = find_record (reader, nr)) == NULL)
+      {
+         error = 4;
+         break;
+      }
+
+      out[0] = record[0];
+      out[1] = record[1];
+      for (i = 0; i < 12; i++)
+         if (ipt[1][i] > 0)
+            memcpy (&out[ipt[0][i] - 1], &record[reader->ipt[0][i] - 1],
+               sizeof (double) * (size_t) ipt[1][i] * (size_t) ipt[2][i] *
+               ((i == 11) ? 2 : 3));
+      if (lpt[1] > 0)
+         memcpy (&out[lpt[0] - 1], &record[reader->lpt[0] - 1],
+            sizeof (double) * (size_t) lpt[1] * (size_t) lpt[2] * 3);
+
+      if (fwrite (out, (size_t) record_length, 1, compact_file) != 1)
+         error = 5;
+   }
+
+   if (fclose (compact_file) && !error)
+      error = 5;
+   free (out);
+
+   return error;
+}
+
+/********map_reader_file */
+
+static short int map_reader_file (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Maps the open file reader->file read-only into memory, setting
+      reader->map and reader->map_size.  Returns 0 on success, 1 on
+      failure.
+
+------------------------------------------------------------------------
+*/
+{
+#if defined(_WIN32)
+   HANDLE file_handle, map_handle;
+   LARGE_INTEGER size;
+
+   file_handle = (HANDLE) _get_osfhandle (_fileno (reader->file));
+   if ((file_handle == INVALID_HANDLE_VALUE) ||
+       !GetFileSizeEx (file_handle, &size))
+      return 1;
+
+   map_handle = CreateFileMapping (file_handle, NULL, PAGE_READONLY,
+      0, 0, NULL);
+   if (map_handle == NULL)
+      return 1;
+
+   reader->map = (char *) MapViewOfFile (map_handle, FILE_MAP_READ,
+      0,0,0);
+   if (reader->map == NULL)
+   {
+      CloseHandle (map_handle);
+      return 1;
+   }
+   reader->map_handle = map_handle;
+   reader->map_size = (long int) size.QuadPart;
+#else
+   struct stat st;
+   void *addr;
+
+   if (fstat (fileno (reader->file), &st) != 0)
+      return 1;
+
+   addr = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED,
+      fileno (reader->file), 0);
+   if (addr == MAP_FAILED)
+      return 1;
+
+   reader->map = (char *) addr;
+   reader->map_size = (long int) st.st_size;
+#endif
+
+   return 0;
+}
+
+/********unmap_reader_file */
+
+static void unmap_reader_file (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Releases the mapping created by 'map_reader_file', if any, and
+      returns the reader to buffered access.
+
+------------------------------------------------------------------------
+*/
+{
+   if (reader->map)
+   {
+#if defined(_WIN32)
+      UnmapViewOfFile (reader->map);
+      CloseHandle ((HANDLE) reader->map_handle);
+      reader->map_handle = NULL;
+#else
+      munmap (reader->map, (size_t) reader->map_size);
+#endif
+   }
+
+   reader->map = NULL;
+   reader->map_size = 0;
+   reader->access = EPH_ACCESS_BUFFERED;
+}
+
+/********allocate_cache */
+
+static short int allocate_cache (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      (Re)allocates an empty record cache of reader->cache_size records
+      (EPH_CACHE_RECORDS if unset).  Returns 0 on success, 1 on failure.
+
+------------------------------------------------------------------------
+*/
+{
+   free_cache (reader);
+
+   if (reader->cache_size < 1)
+      reader->cache_size = EPH_CACHE_RECORDS;
+
+   reader->cache_records = (long int *) calloc (reader->cache_size,
+      sizeof(long int));
+   reader->cache_used = (unsigned long int *) calloc (reader->cache_size,
+      sizeof(unsigned long int));
+   reader->cache = (double *) calloc (reader->cache_size *
+      (reader->record_length / 8), sizeof(double));
+
+   if ((reader->cache_records == NULL) || (reader->cache_used == NULL) ||
+       (reader->cache == NULL))
+   {
+      free_cache (reader);
+      return 1;
+   }
+
+   return 0;
+}
+
+/********free_cache */
+
+static void free_cache (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Frees the record cache.  The configured size is kept.
+
+------------------------------------------------------------------------
+*/
+{
+   free (reader->cache_records);
+   free (reader->cache_used);
+   free (reader->cache);
+
+   reader->cache_records = NULL;
+   reader->cache_used = NULL;
+   reader->cache = NULL;
+   reader->cache_last = 0;
+   reader->cache_clock = 0;
+}
+
+/********free_preload */
+
+static void free_preload (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Frees the records read by 'ephem_reader_preload'.
+
+------------------------------------------------------------------------
+*/
+{
+   free (reader->preload_block);
+
+   reader->preload_block = NULL;
+   reader->preload = NULL;
+   reader->preload_first = 0;
+   reader->preload_count = 0;
+}
+
+/********free_single */
+
+static void free_single (ephem_reader *reader)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Frees the records copied by 'ephem_reader_load_single'.
+
+------------------------------------------------------------------------
+*/
+{
+   free (reader->single_block);
+
+   reader->single_block = NULL;
+   reader->single = NULL;
+   reader->single_first = 0;
+   reader->single_count = 0;
+}
+
+/********covering_records */
+
+static short int covering_records (ephem_reader *reader, double jd_begin,
+                                   double jd_end, long int *first,
+                                   long int *last)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns in 'first' and 'last' the numbers of the first and last
+      records (the header is record 1) covering 'jd_begin' to 'jd_end',
+      clipped to the span of the file, numbered as in
+      'ephem_reader_state'.  Returns 1 if the reader is not open or the
+      range is reversed, 2 if it does not overlap the file, else 0.
+
+------------------------------------------------------------------------
+*/
+{
+   if ((reader->file == NULL) || (jd_end < jd_begin))
+      return 1;
+
+   if ((jd_end < reader->ss[0]) || (jd_begin > reader->ss[1]))
+      return 2;
+
+   if (jd_begin < reader->ss[0])
+      jd_begin = reader->ss[0];
+   if (jd_end > reader->ss[1])
+      jd_end = reader->ss[1];
+
+   *first = (long int) ((jd_begin - reader->ss[0]) / reader->ss[2]) + 3;
+   *last = (long int) ((jd_end - reader->ss[0]) / reader->ss[2]) + 3;
+   if (*last > (long int) ((reader->ss[1] - reader->ss[0]) /
+      reader->ss[2]) + 2)
+      *last -= 1;
+   if (*first > *last)
+      *first = *last;
+
+   return 0;
+}
+
+/********find_record */
+
+static double *find_record (ephem_reader *reader, long int nr)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the address of record 'nr' of the reader's file (the
+      header is record 1): from the preloaded block if it holds the
+      record, in place for a mapped file, otherwise from the record
+      cache, reading the record into the least recently used slot on a
+      miss.  Returns NULL if the record cannot be read.
+
+------------------------------------------------------------------------
+*/
+{
+   long int i, slot, rec;
+
+   if ((nr >= reader->preload_first) &&
+       (nr < reader->preload_first + reader->preload_count))
+      return &reader->preload[(nr - reader->preload_first) *
+         (reader->record_length / 8)];
+
+   rec = (nr - 1) * reader->record_length;
+
+   if (reader->access == EPH_ACCESS_MAPPED)
+   {
+      if (rec + reader->record_length > reader->map_size)
+         return NULL;
+      return (double *) (reader->map + rec);
+   }
+
+/*
+   Check the most recently used slot first, then the rest.
+*/
+
+   slot = reader->cache_last;
+   if (reader->cache_records[slot] != nr)
+   {
+      for (slot = 0; slot < reader->cache_size; slot++)
+         if (reader->cache_records[slot] == nr)
+            break;
+   }
+
+   if (slot < reader->cache_size)
+      reader->cache_hits++;
+    else
+   {
+
+/*
+   Miss: replace the least recently used (or an empty) slot.
+*/
+
+      reader->cache_misses++;
+
+      slot = 0;
+      for (i = 1; i < reader->cache_size; i++)
+         if (reader->cache_used[i] < reader->cache_used[slot])
+            slot = i;
+
+      reader->cache_records[slot] = 0;
+      reader->reads++;
+      fseek (reader->file, rec, SEEK_SET);
+      if (!fread (&reader->cache[slot * (reader->record_length / 8)],
+         reader->record_length, 1, reader->file))
+         return NULL;
+      reader->cache_records[slot] = nr;
+      reader->records_read++;
+      reader->bytes_read += (unsigned long int) reader->record_length;
+   }
+
+   reader->cache_used[slot] = ++reader->cache_clock;
+   reader->cache_last = slot;
+
+   return &reader->cache[slot * (reader->record_length / 8)];
+}
+
+/********current_reader */
+
+static ephem_reader *current_reader (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the reader bound on the calling thread, or the default
+      reader.
+
+------------------------------------------------------------------------
+*/
+{
+   return BOUND_READER ? BOUND_READER : &DEFAULT_READER;
+}
+
+/********copy_default_header */
+
+static void copy_default_header (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Copies the header values of the default reader into the global
+      variables declared in eph_manager.h.
+
+------------------------------------------------------------------------
+*/
+{
+   memcpy (IPT, DEFAULT_READER.ipt, sizeof IPT);
+   memcpy (LPT, DEFAULT_READER.lpt, sizeof LPT);
+   memcpy (SS, DEFAULT_READER.ss, sizeof SS);
+   RECORD_LENGTH = DEFAULT_READER.record_length;
+   JPLAU = DEFAULT_READER.jplau;
+   EM_RATIO = DEFAULT_READER.em_ratio;
+   EPHFILE = DEFAULT_READER.file;
+}
+
+/********planet_ephemeris */
+
+short int planet_ephemeris (double tjd[2], short int target,
+                            short int center,
+
+                            double *position, double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function accesses the JPL planetary ephemeris to give the
+      position and velocity of the target object with respect to the
+      center object.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      tjd[2] (double)
+         Two-element array containing the Julian date, which may be
+         split any way (although the first element is usually the
+         "integer" part, and the second element is the "fractional"
+         part).  Julian date is in the TDB or "T_eph" time scale.
+      target (short int)
+         Number of 'target' point.
+      center (short int)
+         Number of 'center' (origin) point.
+         The numbering convention for 'target' and'center' is:
+            0 = Mercury           7 = Neptune
+            1 = Venus             8 = Pluto
+            2 = Earth             9 = Moon
+            3 = Mars             10 = Sun
+            4 = Jupiter          11 = Solar system bary.
+            5 = Saturn           12 = Earth-Moon bary.
+            6 = Uranus           13 = Nutations (long int. and obliq.)
+            (If nutations are desired, set 'target' = 13;
+             'center' will be ignored on that call.)
+
+   OUTPUT
+   ARGUMENTS:
+      *position (double)
+         Position vector array of target relative to center, measured
+         in AU.
+      *velocity (double)
+         Velocity vector array of target relative to center, measured
+         in AU/day.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0  ...everything OK.
+         1-3...error returned from State.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      ephem_reader_planet_ephemeris
+                        eph_manager.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/03-93/WTH (USNO/AA): Convert FORTRAN to C.
+      V1.1/07-93/WTH (USNO/AA): Update to C standards.
+      V2.0/07-98/WTH (USNO/AA): Modified for ease of use and linearity.
+      V3.0/11-06/JAB (USNO/AA): Allowed for use of input 'split' Julian
+                                date for higher precision.
+      V3.1/11-07/WKP (USNO/AA): Updated prolog and error codes.
+      V3.1/12-07/WKP (USNO/AA): Removed unreferenced variables.
+      V3.2/10-10/WKP (USNO/AA): Renamed function to lowercase to
+                                comply with coding standards.
+      V3.3/10-26 (planetaria):  Uses the reader bound on the calling
+                                thread (see 'ephem_reader_bind').
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   return ephem_reader_planet_ephemeris (current_reader (), tjd,target,
+      center, position,velocity);
+}
+
+/********state */
+
+short int state (double *jed, short int target,
+
+                 double *target_pos, double *target_vel)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function reads and interpolates the JPL planetary
+      ephemeris file.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      *jed (double)
+         2-element Julian date (TDB) at which interpolation is wanted.
+         Any combination of jed[0]+jed[1] which falls within the time
+         span on the file is a permissible epoch.  See Note 1 below.
+      target (short int)
+         The requested body to get data for from the ephemeris file.
+         The designation of the astronomical bodies is:
+                 0 = Mercury                    6 = Uranus
+                 1 = Venus                      7 = Neptune
+                 2 = Earth-Moon barycenter      8 = Pluto
+                 3 = Mars                       9 = geocentric Moon
+                 4 = Jupiter                   10 = Sun
+                 5 = Saturn
+
+   OUTPUT
+   ARGUMENTS:
+      *target_pos (double)
+         The barycentric position vector array of the requested object,
+         in AU.
+         (If target object is the Moon, then the vector is geocentric.)
+      *target_vel (double)
+         The barycentric velocity vector array of the requested object,
+         in AU/Day.
+
+         Both vectors are referenced to the Earth mean equator and
+         equinox of epoch.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0...everything OK.
+         1...error reading ephemeris file.
+         2...epoch out of range.
+         3...target outside 0-10, or not in ephemeris file.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      ephem_reader_state
+                        eph_manager.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/03-93/WTH (USNO/AA): Convert FORTRAN to C.
+      V1.1/07-93/WTH (USNO/AA): Update to C standards.
+      V2.0/07-98/WTH (USNO/AA): Modify to make position and velocity
+                                two distinct vector arrays.  Routine set
+                                to compute one state per call.
+      V2.1/11-07/WKP (USNO/AA): Updated prolog.
+      V2.2/10-10/WKP (USNO/AA): Renamed function to lowercase to
+                                comply with coding standards.
+      V2.3/10-26 (planetaria):  Address records in place when the
+                                file was opened with 'ephem_open_mapped'.
+      V2.4/10-26 (planetaria):  Uses the reader bound on the calling
+                                thread (see 'ephem_reader_bind').
+
+   NOTES:
+      1. For ease in programming, the user may put the entire epoch in
+         jed[0] and set jed[1] = 0. For maximum interpolation accuracy,
+         set jed[0] = the most recent midnight at or before
+         interpolation epoch, and set jed[1] = fractional part of a day
+         elapsed between jed[0] and epoch. As an alternative, it may
+         prove convenient to set jed[0] = some fixed epoch, such as
+         start of the integration and jed[1] = elapsed interval between
+         then and epoch.
+
+------------------------------------------------------------------------
+*/
+{
+   return ephem_reader_state (current_reader (), jed,target,
+      target_pos,target_vel);
+}
+
+/********state_batch */
+
+short int state_batch (short int target, const double *jd, size_t n,
+
+                       double *target_pos, double *target_vel)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function reads and interpolates the JPL planetary
+      ephemeris file for one body at many epochs.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      target (short int)
+         The requested body, numbered as for 'state'.
+      *jd (double)
+         Array of 'n' Julian dates (TDB).
+      n (size_t)
+         Number of epochs.
+
+   OUTPUT
+   ARGUMENTS:
+      *target_pos (double)
+         Array of 3 * 'n' elements: the position of 'target' at each
+         epoch, as returned by 'state'.
+      *target_vel (double)
+         Array of 3 * 'n' elements, or NULL: the velocity of 'target'
+         at each epoch.
+
+   RETURNED
+   VALUE:
+      (short int)
+         As for 'ephem_reader_state_batch'.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      ephem_reader_state_batch
+                        eph_manager.h
+      current_reader    eph_manager.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. Uses the reader bound on the calling thread (see
+         'ephem_reader_bind').
+
+------------------------------------------------------------------------
+*/
+{
+   return ephem_reader_state_batch (current_reader (), target,jd,n,
+      target_pos,target_vel);
+}
+
+/********interpolate */
+
+void interpolate (double *buf, double *t, long int ncf, long int na,
+
+                  double *position, double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function differentiates and interpolates a set of
+      Chebyshev coefficients to give position and velocity.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      *buf (double)
+         Array of Chebyshev coefficients of position.
+      *t (double)
+         t[0] is fractional time interval covered by coefficients at
+         which interpolation is desired (0 <= t[0] <= 1).
+         t[1] is length of whole interval in input time units.
+      ncf (long int)
+         Number of coefficients per component.
+      na (long int)
+         Number of sets of coefficients in full array
+         (i.e., number of sub-intervals in full interval).
+
+   OUTPUT
+   ARGUMENTS:
+      *position (double)
+         Position array of requested object.
+      *velocity (double)
+         Velocity array of requested object.
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      evaluate_chebyshev
+                        eph_manager.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/03-93/WTH (USNO/AA): Convert FORTRAN to C.
+      V1.1/07-93/WTH (USNO/AA): Update to C standards.
+      V1.2/07-98/WTH (USNO/AA): Modify to make position and velocity
+                                two distinct vector arrays.
+      V1.3/11-07/WKP (USNO/AA): Updated prolog.
+      V1.4/12-07/WKP (USNO/AA): Changed ncf and na arguments from short
+                                int to long int.
+      V1.5/10-10/WKP (USNO/AA): Renamed function to lowercase to
+                                comply with coding standards.
+      V1.6/10-26 (planetaria):  Polynomial cache moved into a
+                                per-thread 'cheby_basis'; readers keep
+                                their own.
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   evaluate_chebyshev (&INTERPOLATE_BASIS, buf,t,ncf,na,
+      position,velocity);
+
+   return;
+}
+
+/********interpolate_epochs */
+
+void interpolate_epochs (double *buf, double *t, long int n,
+                         double span, long int ncf, long int na,
+
+                         double *position, double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function differentiates and interpolates a set of
+      Chebyshev coefficients at several epochs, giving position and
+      velocity at each.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      *buf (double)
+         Array of Chebyshev coefficients of position, as for
+         'interpolate'.
+      *t (double)
+         Array of 'n' fractional time intervals covered by the
+         coefficients at which interpolation is desired
+         (0 <= t[i] <= 1).
+      n (long int)
+         Number of epochs.
+      span (double)
+         Length of whole interval in input time units.
+      ncf (long int)
+         Number of coefficients per component.
+      na (long int)
+         Number of sets of coefficients in full array
+         (i.e., number of sub-intervals in full interval).
+
+   OUTPUT
+   ARGUMENTS:
+      *position (double)
+         Array of 3 * 'n' elements: position of the object at each
+         epoch, x, y and z together.
+      *velocity (double)
+         Array of 3 * 'n' elements, or NULL: velocity of the object
+         at each epoch.
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      ephem_kernel      eph_manager.h
+      interpolate_4_avx2
+                        eph_manager.c
+      evaluate_chebyshev
+                        eph_manager.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. With EPH_KERNEL_AVX2, epochs are evaluated four at a time,
+         one per vector lane, polynomial values included.  The results
+         are identical to calling 'interpolate' at each epoch.
+
+------------------------------------------------------------------------
+*/
+{
+   long int e = 0;
+
+   double tt[2], vel[3];
+
+   cheby_basis basis;
+
+#if defined(EPH_HAVE_AVX2)
+   if (ephem_kernel () == EPH_KERNEL_AVX2)
+   {
+      for ( ; e + 4 <= n; e += 4)
+         interpolate_4_avx2 (buf,&t[e],span,ncf,na, &position[3 * e],
+            (velocity == NULL) ? NULL : &velocity[3 * e]);
+   }
+#endif
+
+   basis.np = 0;
+   tt[1] = span;
+
+   for ( ; e < n; e++)
+   {
+      tt[0] = t[e];
+      evaluate_chebyshev (&basis, buf,tt,ncf,na, &position[3 * e],
+         (velocity == NULL) ? vel : &velocity[3 * e]);
+   }
+
+   return;
+}
+
+/********ephem_select_kernel */
+
+short int ephem_select_kernel (short int kernel)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Selects the kernel that sums Chebyshev series in 'state',
+      'interpolate' and 'interpolate_epochs'.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      kernel (short int)
+         EPH_KERNEL_SCALAR or EPH_KERNEL_AVX2.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         The kernel now in use: EPH_KERNEL_SCALAR if EPH_KERNEL_AVX2
+         was requested and the processor does not support it.
+
+   GLOBALS
+   USED:
+      KERNEL            eph_manager.c
+
+   FUNCTIONS
+   CALLED:
+      select_detected_kernel
+                        eph_manager.c
+      cpu_has_avx2      eph_manager.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The selection is process-wide.  The kernels give identical
+         results, but the selection is not synchronized: it must not
+         be changed while other threads compute positions.
+      2. The first reader opened selects the fastest kernel the
+         processor supports, once; a kernel selected here is not
+         replaced by that selection.
+
+------------------------------------------------------------------------
+*/
+{
+   select_detected_kernel ();
+
+   if ((kernel == EPH_KERNEL_AVX2) && cpu_has_avx2 ())
+      KERNEL = EPH_KERNEL_AVX2;
+    else
+      KERNEL = EPH_KERNEL_SCALAR;
+
+   return KERNEL;
+}
+
+/********ephem_kernel */
+
+short int ephem_kernel (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the kernel that sums Chebyshev series: EPH_KERNEL_SCALAR
+      until the first reader opens and selects the fastest the
+      processor supports.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         EPH_KERNEL_SCALAR or EPH_KERNEL_AVX2.
+
+   GLOBALS
+   USED:
+      KERNEL            eph_manager.c
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   return KERNEL;
+}
+
+/********ephem_set_precision */
+
+short int ephem_set_precision (short int precision)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Selects, for the calling thread, whether 'state' evaluates the
+      single-precision records kept by 'ephem_reader_load_single' or
+      the double-precision records of the file.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      precision (short int)
+         EPH_PRECISION_DOUBLE or EPH_PRECISION_SINGLE.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         The precision previously selected on this thread, so that
+         callers can restore it.
+
+   GLOBALS
+   USED:
+      PRECISION         eph_manager.c
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. With EPH_PRECISION_SINGLE, epochs whose records were not
+         copied by 'ephem_reader_load_single' are evaluated in double
+         precision, so selecting it without a copy changes nothing.
+      2. 'ephem_reader_state_batch' always uses double precision.
+      3. NOVAS caches some positions by epoch (e.g. the Earth and Sun
+         in 'place'); a value computed in single precision is reused
+         if the next call is at the same epoch.
+
+------------------------------------------------------------------------
+*/
+{
+   short int previous = PRECISION;
+
+   PRECISION = (precision == EPH_PRECISION_SINGLE) ?
+      EPH_PRECISION_SINGLE : EPH_PRECISION_DOUBLE;
+
+   return previous;
+}
+
+/********ephem_precision */
+
+short int ephem_precision (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the coefficient precision selected on the calling thread
+      (see 'ephem_set_precision').
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (short int)
+         EPH_PRECISION_DOUBLE or EPH_PRECISION_SINGLE.
+
+   GLOBALS
+   USED:
+      PRECISION         eph_manager.c
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   return PRECISION;
+}
+
+/********split */
+
+void split (double tt,
+
+            double *fr)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function breaks up a double number into a double integer
+      part and a fractional part.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      tt (double)
+         Input number.
+
+   OUTPUT
+   ARGUMENTS:
+      *fr (double)
+         2-element output array;
+            fr[0] contains integer part,
+            fr[1] contains fractional part.
+         For negative input numbers,
+            fr[0] contains the next more negative integer;
+            fr[1] contains a positive fraction.
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/06-90/JAB (USNO/NA): CA coding standards
+      V1.1/03-93/WTH (USNO/AA): Convert to C.
+      V1.2/07-93/WTH (USNO/AA): Update to C standards.
+      V1.3/10-10/WKP (USNO/AA): Renamed function to lowercase to
+                                comply with coding standards.
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+
+/*
+   Get integer and fractional parts.
+*/
+
+   fr[0] = (double)((long int) tt);
+   fr[1] = tt - fr[0];
+
+/*
+   Make adjustments for negative input number.
+*/
+
+   if ((tt >= 0.0) || (fr[1] == 0.0))
+      return;
+    else
+   {
+      fr[0] = fr[0] - 1.0;
+      fr[1] = fr[1] + 1.0;
+   }
+
+   return;
+}
+
+/********ephem_reader_planet_ephemeris */
+
+short int ephem_reader_planet_ephemeris (ephem_reader *reader,
+                                         double tjd[2], short int target,
+                                         short int center,
+
+                                         double *position,
+                                         double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function accesses the JPL planetary ephemeris held by
+      'reader' to give the position and velocity of the target object
+      with respect to the center object.
+
+   REFERENCES:
+      Standish, E.M. and Newhall, X X (1988). "The JPL Export
+         Planetary Ephemeris"; JPL document dated 17 June 1988.
+
+   INPUT
+   ARGUMENTS:
+      *reader (ephem_reader)
+         Open ephemeris reader.
+      tjd[2] (double)
+         Two-element array containing the Julian date, which may be
+         split any way (although the first element is usually the
+         "integer" part, and the second element is the "fractional"
+         part).  Julian date is in the TDB or "T_eph" time scale.
       target (short int)
          Number of 'target' point.
       center (short int)
@@ -382,15 +2611,16 @@ short int planet_ephemeris (double tjd[2], short int target,
    VALUE:
       (short int)
          0  ...everything OK.
-         1,2...error returned from State.
+         1-3...error returned from State.
 
    GLOBALS
    USED:
-      EM_RATIO          eph_manager.h
+      None.
 
    FUNCTIONS
    CALLED:
-      state             eph_manager.h
+      ephem_reader_state
+                        eph_manager.h
 
    VER./DATE/
    PROGRAMMER:
@@ -403,6 +2633,8 @@ short int planet_ephemeris (double tjd[2], short int target,
       V3.1/12-07/WKP (USNO/AA): Removed unreferenced variables.
       V3.2/10-10/WKP (USNO/AA): Renamed function to lowercase to
                                 comply with coding standards.
+      V3.3/10-26 (planetaria):  Per-reader version of
+                                'planet_ephemeris'.
 
    NOTES:
       None.
@@ -454,14 +2686,14 @@ short int planet_ephemeris (double tjd[2], short int target,
 
    if (do_earth)
    {
-      error = state (jed,2, pos_earth,vel_earth);
+      error = ephem_reader_state (reader,jed,2, pos_earth,vel_earth);
       if (error)
          return error;
    }
 
    if (do_moon)
    {
-      error = state (jed,9, pos_moon,vel_moon);
+      error = ephem_reader_state (reader,jed,9, pos_moon,vel_moon);
       if (error)
          return error;
    }
@@ -487,7 +2719,7 @@ short int planet_ephemeris (double tjd[2], short int target,
       }
    }
     else
-      error = state (jed,target, target_pos,target_vel);
+      error = ephem_reader_state (reader,jed,target, target_pos,target_vel);
 
    if (error)
       return error;
@@ -523,7 +2755,7 @@ short int planet_ephemeris (double tjd[2], short int target,
       }
    }
     else
-      error = state (jed,center, center_pos,center_vel);
+      error = ephem_reader_state (reader,jed,center, center_pos,center_vel);
 
    if (error)
       return error;
@@ -560,9 +2792,9 @@ short int planet_ephemeris (double tjd[2], short int target,
       for (i = 0; i < 3; i++)
       {
          target_pos[i] = target_pos[i] - (pos_moon[i] /
-            (1.0 + EM_RATIO));
+            (1.0 + reader->em_ratio));
          target_vel[i] = target_vel[i] - (vel_moon[i] /
-            (1.0 + EM_RATIO));
+            (1.0 + reader->em_ratio));
       }
    }
     else if (center == earth)
@@ -570,9 +2802,9 @@ short int planet_ephemeris (double tjd[2], short int target,
       for (i = 0; i < 3; i++)
       {
          center_pos[i] = center_pos[i] - (pos_moon[i] /
-            (1.0 + EM_RATIO));
+            (1.0 + reader->em_ratio));
          center_vel[i] = center_vel[i] - (vel_moon[i] /
-            (1.0 + EM_RATIO));
+            (1.0 + reader->em_ratio));
       }
    }
 
@@ -585,9 +2817,9 @@ short int planet_ephemeris (double tjd[2], short int target,
       for (i = 0; i < 3; i++)
       {
          target_pos[i] = (pos_earth[i] - (target_pos[i] /
-            (1.0 + EM_RATIO))) + target_pos[i];
+            (1.0 + reader->em_ratio))) + target_pos[i];
          target_vel[i] = (vel_earth[i] - (target_vel[i] /
-            (1.0 + EM_RATIO))) + target_vel[i];
+            (1.0 + reader->em_ratio))) + target_vel[i];
       }
    }
     else if (center == moon)
@@ -595,9 +2827,9 @@ short int planet_ephemeris (double tjd[2], short int target,
       for (i = 0; i < 3; i++)
       {
          center_pos[i] = (pos_earth[i] - (center_pos[i] /
-            (1.0 + EM_RATIO))) + center_pos[i];
+            (1.0 + reader->em_ratio))) + center_pos[i];
          center_vel[i] = (vel_earth[i] - (center_vel[i] /
-            (1.0 + EM_RATIO))) + center_vel[i];
+            (1.0 + reader->em_ratio))) + center_vel[i];
       }
    }
 
@@ -615,17 +2847,18 @@ short int planet_ephemeris (double tjd[2], short int target,
 }
 
 
-/********state */
+/********ephem_reader_state */
 
-short int state (double *jed, short int target,
+short int ephem_reader_state (ephem_reader *reader, double *jed,
+                              short int target,
 
-                 double *target_pos, double *target_vel)
+                              double *target_pos, double *target_vel)
 /*
 ------------------------------------------------------------------------
 
    PURPOSE:
       This function reads and interpolates the JPL planetary
-      ephemeris file.
+      ephemeris file held by 'reader'.
 
    REFERENCES:
       Standish, E.M. and Newhall, X X (1988). "The JPL Export
@@ -633,6 +2866,8 @@ short int state (double *jed, short int target,
 
    INPUT
    ARGUMENTS:
+      *reader (ephem_reader)
+         Open ephemeris reader.
       *jed (double)
          2-element Julian date (TDB) at which interpolation is wanted.
          Any combination of jed[0]+jed[1] which falls within the time
@@ -666,25 +2901,21 @@ short int state (double *jed, short int target,
          0...everything OK.
          1...error reading ephemeris file.
          2...epoch out of range.
+         3...target outside 0-10, or not in ephemeris file (see
+             'ephem_reader_extract').
 
    GLOBALS
    USED:
-      KM                eph_manager.h
-      EPHFILE           eph_manager.h
-      IPT               eph_manager.h
-      BUFFER            eph_manager.h
-      NRL               eph_manager.h
-      RECORD_LENGTH     eph_manager.h
-      SS                eph_manager.h
-      JPLAU             eph_manager.h
+      None.
 
    FUNCTIONS
    CALLED:
-      split             eph_manager.h
-      fseek             stdio.h
-      fread             stdio.h
-      interpolate       eph_manager.h
-      ephem_close       eph_manager.h
+      record_time       eph_manager.c
+      find_record       eph_manager.c
+      evaluate_chebyshev
+                        eph_manager.c
+      evaluate_chebyshev_single
+                        eph_manager.c
 
    VER./DATE/
    PROGRAMMER:
@@ -696,6 +2927,23 @@ short int state (double *jed, short int target,
       V2.1/11-07/WKP (USNO/AA): Updated prolog.
       V2.2/10-10/WKP (USNO/AA): Renamed function to lowercase to
                                 comply with coding standards.
+      V2.3/10-26 (planetaria):  Address records in place when the
+                                file was opened with 'ephem_open_mapped'.
+      V2.4/10-26 (planetaria):  Per-reader version of 'state'.  A read
+                                error no longer closes the file.
+      V2.5/10-26 (planetaria):  Records come from a multi-record LRU
+                                cache (see 'ephem_reader_set_cache_size').
+      V2.6/10-26 (planetaria):  Reports targets missing from compact
+                                files.
+      V2.7/10-26 (planetaria):  Epoch checks moved to 'record_time',
+                                shared with 'ephem_reader_state_batch'.
+      V2.8/10-26 (planetaria):  Evaluates single-precision records
+                                when selected (see
+                                'ephem_set_precision').
+      V2.9/10-26 (planetaria):  Counts record switches and
+                                interpolations (see
+                                'ephem_reader_reset_stats').
+      V2.10/10-26 (planetaria): Rejects targets outside 0-10.
 
    NOTES:
       1. For ease in programming, the user may put the entire epoch in
@@ -712,72 +2960,78 @@ short int state (double *jed, short int target,
 {
    short int i;
 
-   long int nr, rec;
+   long int nr;
+
+   double t[2], aufac = 1.0;
+   double *record;
+
+   if (reader->file == NULL)
+      return 1;
 
-   double t[2], aufac = 1.0, jd[4], s;
+   if ((target < 0) || (target >= EPH_STATE_TARGETS) ||
+       (reader->ipt[1][target] == 0))
+      return 3;
 
 /*
-   Set units based on value of the 'KM' flag.
+   Set units based on value of the reader's 'km' flag.
 */
 
-   if (KM)
-      t[1] = SS[2] * 86400.0;
+   if (reader->km)
+      t[1] = reader->ss[2] * 86400.0;
     else
    {
-      t[1] = SS[2];
-      aufac = 1.0 / JPLAU;
+      t[1] = reader->ss[2];
+      aufac = 1.0 / reader->jplau;
    }
 
 /*
-   Check epoch.
+   Check epoch, and calculate record number and relative time interval.
 */
 
-   s = jed[0] - 0.5;
-   split (s, &jd[0]);
-   split (jed[1], &jd[2]);
-   jd[0] += jd[2] + 0.5;
-   jd[1] += jd[3];
-   split (jd[1], &jd[2]);
-   jd[0] += jd[2];
+   if (record_time (reader, jed, &nr, &t[0]))
+      return 2;
 
-/*
-   Return error code if date is out of range.
-*/
+   if (nr != reader->record_last)
+   {
+      reader->record_switches++;
+      reader->record_last = nr;
+   }
+   reader->interpolations[target]++;
 
-   if ((jd[0] < SS[0]) || ((jd[0] + jd[3]) > SS[1]))
-      return 2;
+   if ((PRECISION == EPH_PRECISION_SINGLE) &&
+       (nr >= reader->single_first) &&
+       (nr < reader->single_first + reader->single_count))
+   {
 
 /*
-   Calculate record number and relative time interval.
+   Interpolate from the single-precision copy of the record.
 */
 
-   nr = (long int) ((jd[0] - SS[0]) / SS[2]) + 3;
-   if (jd[0] == SS[1])
-      nr -= 2;
-   t[0] = ((jd[0] - ((double) (nr-3) * SS[2] + SS[0])) + jd[3]) / SS[2];
+      evaluate_chebyshev_single (&reader->basis,
+         &reader->single[(nr - reader->single_first) *
+         (reader->record_length / 8) + reader->ipt[0][target]-1],
+         t,reader->ipt[1][target],reader->ipt[2][target],
+         target_pos,target_vel);
+   }
+    else
+   {
 
 /*
-   Read correct record if it is not already in memory.
+   Locate the record, in place or in the record cache.
 */
 
-   if (nr != NRL)
-   {
-      NRL = nr;
-      rec = (nr - 1) * RECORD_LENGTH;
-      fseek (EPHFILE, rec, SEEK_SET);
-      if (!fread (BUFFER, RECORD_LENGTH, 1, EPHFILE))
-      {
-         ephem_close ();
+      if ((record = find_record (reader, nr)) == NULL)
          return 1;
-      }
-   }
 
 /*
    Check and interpolate for requested body.
 */
 
-   interpolate (&BUFFER[IPT[0][target]-1],t,IPT[1][target],
-      IPT[2][target], target_pos,target_vel);
+      evaluate_chebyshev (&reader->basis,
+         &record[reader->ipt[0][target]-1],
+         t,reader->ipt[1][target],reader->ipt[2][target],
+         target_pos,target_vel);
+   }
 
    for (i = 0; i < 3; i++)
    {
@@ -788,17 +3042,22 @@ short int state (double *jed, short int target,
    return 0;
 }
 
-/********interpolate */
+/********ephem_reader_state_batch */
 
-void interpolate (double *buf, double *t, long int ncf, long int na,
+short int ephem_reader_state_batch (ephem_reader *reader,
+                                    short int target,
+                                    const double *jd, size_t n,
 
-                  double *position, double *velocity)
+                                    double *target_pos,
+                                    double *target_vel)
 /*
 ------------------------------------------------------------------------
 
    PURPOSE:
-      This function differentiates and interpolates a set of
-      Chebyshev coefficients to give position and velocity.
+      This function reads and interpolates the JPL planetary
+      ephemeris file held by 'reader' for one body at many epochs.
+      Epochs are grouped by record, so each record is located once per
+      group and its epochs are interpolated together.
 
    REFERENCES:
       Standish, E.M. and Newhall, X X (1988). "The JPL Export
@@ -806,62 +3065,314 @@ void interpolate (double *buf, double *t, long int ncf, long int na,
 
    INPUT
    ARGUMENTS:
-      *buf (double)
-         Array of Chebyshev coefficients of position.
-      *t (double)
-         t[0] is fractional time interval covered by coefficients at
-         which interpolation is desired (0 <= t[0] <= 1).
-         t[1] is length of whole interval in input time units.
-      ncf (long int)
-         Number of coefficients per component.
-      na (long int)
-         Number of sets of coefficients in full array
-         (i.e., number of sub-intervals in full interval).
+      *reader (ephem_reader)
+         Open ephemeris reader.
+      target (short int)
+         The requested body, numbered as for 'ephem_reader_state'.
+      *jd (double)
+         Array of 'n' Julian dates (TDB).
+      n (size_t)
+         Number of epochs.
+
+   OUTPUT
+   ARGUMENTS:
+      *target_pos (double)
+         Array of 3 * 'n' elements: the position of 'target' at each
+         epoch, in the units of 'ephem_reader_state'.
+      *target_vel (double)
+         Array of 3 * 'n' elements, or NULL: the velocity of 'target'
+         at each epoch.
+
+   RETURNED
+   VALUE:
+      (short int)
+         0...everything OK.
+         1...error reading ephemeris file.
+         2...an epoch out of range.
+         3...target outside 0-10, or not in ephemeris file (see
+             'ephem_reader_extract').
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      record_time       eph_manager.c
+      compare_batch_epochs
+                        eph_manager.c
+      find_record       eph_manager.c
+      interpolate_epochs
+                        eph_manager.h
+      qsort             stdlib.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+      V1.1/10-26 (planetaria):  Counts record switches and
+                                interpolations (see
+                                'ephem_reader_reset_stats').
+      V1.2/10-26 (planetaria):  Rejects targets outside 0-10.
+
+   NOTES:
+      1. Each result is identical to 'ephem_reader_state' with
+         jed[0] = jd[i] and jed[1] = 0.
+      2. Epochs are sorted in blocks of EPH_BATCH_BLOCK, so a sorted or
+         unsorted grid of any length touches each record once per
+         block; consecutive blocks on the same record find it in the
+         record cache.
+      3. On error, the contents of the output arrays are undefined.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error, sorted;
+
+   long int m, ncf, na;
+
+   size_t first, count, i, j, k;
+
+   double jed[2], aufac = 1.0, span, t[EPH_BATCH_BLOCK];
+   double pos[3 * EPH_BATCH_BLOCK], vel[3 * EPH_BATCH_BLOCK];
+   double *record;
+
+   batch_epoch epochs[EPH_BATCH_BLOCK];
+
+   if (reader->file == NULL)
+      return 1;
+
+   if ((target < 0) || (target >= EPH_STATE_TARGETS) ||
+       (reader->ipt[1][target] == 0))
+      return 3;
+
+   if (reader->km)
+      span = reader->ss[2] * 86400.0;
+    else
+   {
+      span = reader->ss[2];
+      aufac = 1.0 / reader->jplau;
+   }
+
+   ncf = reader->ipt[1][target];
+   na = reader->ipt[2][target];
+
+   for (first = 0; first < n; first += count)
+   {
+      count = n - first;
+      if (count > EPH_BATCH_BLOCK)
+         count = EPH_BATCH_BLOCK;
+
+/*
+   Record and relative time of each epoch in the block, grouped by
+   record.
+*/
+
+      sorted = 1;
+      for (i = 0; i < count; i++)
+      {
+         jed[0] = jd[first + i];
+         jed[1] = 0.0;
+         if ((error = record_time (reader, jed, &epochs[i].nr,
+            &epochs[i].t)) != 0)
+            return error;
+         epochs[i].index = first + i;
+         if ((i > 0) && (epochs[i].nr < epochs[i-1].nr))
+            sorted = 0;
+      }
+
+      if (!sorted)
+         qsort (epochs, count, sizeof (batch_epoch), compare_batch_epochs);
+
+/*
+   Interpolate each group of epochs sharing a record.
+*/
+
+      for (i = 0; i < count; i = j)
+      {
+         for (j = i; (j < count) && (epochs[j].nr == epochs[i].nr); j++)
+            t[j - i] = epochs[j].t;
+         m = (long int) (j - i);
+
+         if (epochs[i].nr != reader->record_last)
+         {
+            reader->record_switches++;
+            reader->record_last = epochs[i].nr;
+         }
+         reader->interpolations[target] += (unsigned long int) m;
+
+         if ((record = find_record (reader, epochs[i].nr)) == NULL)
+            return 1;
+
+         interpolate_epochs (&record[reader->ipt[0][target]-1], t,m,span,
+            ncf,na, pos,(target_vel == NULL) ? NULL : vel);
+
+         for (k = 0; k < (size_t) m; k++)
+         {
+            target_pos[3 * epochs[i + k].index] = pos[3 * k] * aufac;
+            target_pos[3 * epochs[i + k].index + 1] = pos[3 * k + 1] * aufac;
+            target_pos[3 * epochs[i + k].index + 2] = pos[3 * k + 2] * aufac;
+            if (target_vel != NULL)
+            {
+               target_vel[3 * epochs[i + k].index] = vel[3 * k] * aufac;
+               target_vel[3 * epochs[i + k].index + 1] =
+                  vel[3 * k + 1] * aufac;
+               target_vel[3 * epochs[i + k].index + 2] =
+                  vel[3 * k + 2] * aufac;
+            }
+         }
+      }
+   }
+
+   return 0;
+}
+
+/********record_time */
+
+static short int record_time (ephem_reader *reader, double *jed,
+                              long int *nr, double *t)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Computes, for the 2-element Julian date 'jed', the number 'nr' of
+      the record covering it (the header is record 1) and the fraction
+      't' of the record's interval elapsed.  Returns 2 if 'jed' is out
+      of the range of the file, else 0.
+
+------------------------------------------------------------------------
+*/
+{
+   double jd[4], s;
+
+   s = jed[0] - 0.5;
+   split (s, &jd[0]);
+   split (jed[1], &jd[2]);
+   jd[0] += jd[2] + 0.5;
+   jd[1] += jd[3];
+   split (jd[1], &jd[2]);
+   jd[0] += jd[2];
+
+/*
+   Return error code if date is out of range.
+*/
+
+   if ((jd[0] < reader->ss[0]) || ((jd[0] + jd[3]) > reader->ss[1]))
+      return 2;
+
+/*
+   Calculate record number and relative time interval.
+*/
+
+   *nr = (long int) ((jd[0] - reader->ss[0]) / reader->ss[2]) + 3;
+   if (jd[0] == reader->ss[1])
+      *nr -= 2;
+   *t = ((jd[0] - ((double) (*nr-3) * reader->ss[2] + reader->ss[0])) +
+      jd[3]) / reader->ss[2];
+
+   return 0;
+}
+
+/********compare_batch_epochs */
+
+static int compare_batch_epochs (const void *a, const void *b)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      'qsort' order of 'batch_epoch's: by record, then by input order.
+
+------------------------------------------------------------------------
+*/
+{
+   const batch_epoch *ea = (const batch_epoch *) a;
+   const batch_epoch *eb = (const batch_epoch *) b;
+
+   if (ea->nr != eb->nr)
+      return (ea->nr < eb->nr) ? -1 : 1;
+   if (ea->index != eb->index)
+      return (ea->index < eb->index) ? -1 : 1;
+   return 0;
+}
+
+/********evaluate_chebyshev */
+
+static void evaluate_chebyshev (cheby_basis *basis, double *buf,
+                                double *t, long int ncf, long int na,
+                                double *position, double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Body of 'interpolate', keeping its polynomial values in 'basis'
+      rather than in process globals.  See 'interpolate' for the
+      arguments.
+
+------------------------------------------------------------------------
+*/
+{
+   long int l;
+
+   double vfac;
+
+   l = update_basis (basis, t, ncf, na, &vfac);
+
+/*
+   Interpolate to get position and velocity for each component.
+*/
+
+   sum_series (basis->pc,basis->vc,&buf[l * (3 * ncf)],ncf,vfac,
+      position,velocity);
+
+   return;
+}
+
+/********evaluate_chebyshev_single */
+
+static void evaluate_chebyshev_single (cheby_basis *basis, float *buf,
+                                       double *t, long int ncf,
+                                       long int na, double *position,
+                                       double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      'evaluate_chebyshev' for a series copied by
+      'ephem_reader_load_single'.
+
+------------------------------------------------------------------------
+*/
+{
+   long int l;
 
-   OUTPUT
-   ARGUMENTS:
-      *position (double)
-         Position array of requested object.
-      *velocity (double)
-         Velocity array of requested object.
+   double vfac;
 
-   RETURNED
-   VALUE:
-      None.
+   l = update_basis (basis, t, ncf, na, &vfac);
 
-   GLOBALS
-   USED:
-      NP                eph_manager.h
-      NV                eph_manager.h
-      PC                eph_manager.h
-      VC                eph_manager.h
-      TWOT              eph_manager.h
+   sum_series_single (basis->pc,basis->vc,&buf[l * (3 * ncf)],ncf,vfac,
+      position,velocity);
 
-   FUNCTIONS
-   CALLED:
-      fmod              math.h
+   return;
+}
 
-   VER./DATE/
-   PROGRAMMER:
-      V1.0/03-93/WTH (USNO/AA): Convert FORTRAN to C.
-      V1.1/07-93/WTH (USNO/AA): Update to C standards.
-      V1.2/07-98/WTH (USNO/AA): Modify to make position and velocity
-                                two distinct vector arrays.
-      V1.3/11-07/WKP (USNO/AA): Updated prolog.
-      V1.4/12-07/WKP (USNO/AA): Changed ncf and na arguments from short
-                                int to long int.
-      V1.5/10-10/WKP (USNO/AA): Renamed function to lowercase to
-                                comply with coding standards.
+/********update_basis */
 
-   NOTES:
-      None.
+static long int update_basis (cheby_basis *basis, double *t,
+                              long int ncf, long int na, double *vfac)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Brings the polynomial values in 'basis' up to date for the
+      normalized time 't' (see 'interpolate') and 'ncf' coefficients.
+      Returns the sub-interval covering 't' and sets 'vfac', the
+      velocity scale factor.
 
 ------------------------------------------------------------------------
 */
 {
-   long int i, j, k, l;
+   long int i, l;
 
-   double dna, dt1, temp, tc, vfac;
+   double dna, dt1, temp, tc;
 
 /*
    Get correct sub-interval number for this set of coefficients and
@@ -881,152 +3392,451 @@ void interpolate (double *buf, double *t, long int ncf, long int na,
 
 /*
    Check to see whether Chebyshev time has changed, and compute new
-   polynomial values if it has.  (The element PC[1] is the value of
-   t1[tc] and hence contains the value of 'tc' on the previous call.)
+   polynomial values if it has.  (The element basis->pc[1] is the value
+   of t1[tc] and hence contains the value of 'tc' on the previous call.)
 */
 
-   if (tc != PC[1])
+   if ((basis->np == 0) || (tc != basis->pc[1]))
    {
-      NP = 2;
-      NV = 3;
-      PC[1] = tc;
-      TWOT = tc + tc;
+      if (basis->np == 0)
+         reset_basis (basis);
+      basis->np = 2;
+      basis->nv = 3;
+      basis->pc[1] = tc;
+      basis->twot = tc + tc;
    }
 
 /*
    Be sure that at least 'ncf' polynomials have been evaluated and
-   are stored in the array 'PC'.
+   are stored in the array 'pc'.
+*/
+
+   if (basis->np < ncf)
+   {
+      for (i = basis->np; i < ncf; i++)
+         basis->pc[i] = basis->twot * basis->pc[i-1] - basis->pc[i-2];
+      basis->np = ncf;
+   }
+
+/*
+   Be sure enough derivative polynomials have been generated and
+   stored.
 */
 
-   if (NP < ncf)
+   *vfac = (2.0 * dna) / t[1];
+   basis->vc[2] = 2.0 * basis->twot;
+   if (basis->nv < ncf)
+   {
+      for (i = basis->nv; i < ncf; i++)
+         basis->vc[i] = basis->twot * basis->vc[i-1] + basis->pc[i-1] +
+            basis->pc[i-1] - basis->vc[i-2];
+      basis->nv = ncf;
+   }
+
+   return l;
+}
+
+/********sum_series */
+
+static void sum_series (double *pc, double *vc, double *buf,
+                        long int ncf, double vfac,
+                        double *position, double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Sums the x, y and z series of one sub-interval, 'buf', against
+      the polynomial values 'pc' (position) and 'vc' (velocity, scaled
+      by 'vfac'), with the kernel selected by 'ephem_kernel'.
+
+------------------------------------------------------------------------
+*/
+{
+#if defined(EPH_HAVE_AVX2)
+   if (ephem_kernel () == EPH_KERNEL_AVX2)
    {
-      for (i = NP; i < ncf; i++)
-         PC[i] = TWOT * PC[i-1] - PC[i-2];
-      NP = ncf;
+      sum_series_avx2 (pc,vc,buf,ncf,vfac, position,velocity);
+      return;
    }
+#endif
+
+   sum_series_scalar (pc,vc,buf,ncf,vfac, position,velocity);
+}
+
+/********sum_series_scalar */
 
+static void sum_series_scalar (double *pc, double *vc, double *buf,
+                               long int ncf, double vfac,
+                               double *position, double *velocity)
 /*
-   Interpolate to get position for each component.
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Portable 'sum_series': one component at a time, highest order
+      term first, as in the original 'interpolate'.
+
+------------------------------------------------------------------------
 */
+{
+   long int i, j;
 
    for (i = 0; i < 3; i++)
    {
       position[i] = 0.0;
       for (j = ncf-1; j >= 0; j--)
-      {
-         k = j + (i * ncf) + (l * (3 * ncf));
-         position[i] += PC[j] * buf[k];
-      }
+         position[i] += pc[j] * buf[j + (i * ncf)];
+   }
+
+   for (i = 0; i < 3; i++)
+   {
+      velocity[i] = 0.0;
+      for (j = ncf-1; j > 0; j--)
+         velocity[i] += vc[j] * buf[j + (i * ncf)];
+      velocity[i] *= vfac;
    }
+}
 
+/********sum_series_single */
+
+static void sum_series_single (double *pc, double *vc, float *buf,
+                               long int ncf, double vfac,
+                               double *position, double *velocity)
 /*
-   If velocity interpolation is desired, be sure enough derivative
-   polynomials have been generated and stored.
-*/
+------------------------------------------------------------------------
+
+   PURPOSE:
+      'sum_series' for single-precision coefficients, which are summed
+      in double precision, with the kernel selected by 'ephem_kernel'.
 
-   vfac = (2.0 * dna) / t[1];
-   VC[2] = 2.0 * TWOT;
-   if (NV < ncf)
+------------------------------------------------------------------------
+*/
+{
+#if defined(EPH_HAVE_AVX2)
+   if (ephem_kernel () == EPH_KERNEL_AVX2)
    {
-      for (i = NV; i < ncf; i++)
-         VC[i] = TWOT * VC[i-1] + PC[i-1] + PC[i-1] - VC[i-2];
-      NV = ncf;
+      sum_series_single_avx2 (pc,vc,buf,ncf,vfac, position,velocity);
+      return;
    }
+#endif
 
+   sum_series_single_scalar (pc,vc,buf,ncf,vfac, position,velocity);
+}
+
+/********sum_series_single_scalar */
+
+static void sum_series_single_scalar (double *pc, double *vc, float *buf,
+                                      long int ncf, double vfac,
+                                      double *position,
+                                      double *velocity)
 /*
-   Interpolate to get velocity for each component.
+------------------------------------------------------------------------
+
+   PURPOSE:
+      'sum_series_scalar' for single-precision coefficients.
+
+------------------------------------------------------------------------
 */
+{
+   long int i, j;
+
+   for (i = 0; i < 3; i++)
+   {
+      position[i] = 0.0;
+      for (j = ncf-1; j >= 0; j--)
+         position[i] += pc[j] * (double) buf[j + (i * ncf)];
+   }
 
    for (i = 0; i < 3; i++)
    {
       velocity[i] = 0.0;
       for (j = ncf-1; j > 0; j--)
-      {
-         k = j + (i * ncf) + (l * (3 * ncf));
-         velocity[i] += VC[j] * buf[k];
-      }
+         velocity[i] += vc[j] * (double) buf[j + (i * ncf)];
       velocity[i] *= vfac;
    }
+}
 
-   return;
+/********cpu_has_avx2 */
+
+static short int cpu_has_avx2 (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns 1 if the AVX2 kernels are compiled in and the processor
+      and operating system support them, else 0.
+
+------------------------------------------------------------------------
+*/
+{
+#if defined(EPH_HAVE_AVX2) && defined(_MSC_VER)
+   int info[4];
+
+   __cpuid (info, 1);
+   if (((info[2] & (1 << 27)) == 0) || ((info[2] & (1 << 28)) == 0))
+      return 0;
+   if ((_xgetbv (0) & 6) != 6)
+      return 0;
+   __cpuidex (info, 7, 0);
+   return (short int) ((info[1] & (1 << 5)) != 0);
+#elif defined(EPH_HAVE_AVX2)
+   __builtin_cpu_init ();
+   return (short int) (__builtin_cpu_supports ("avx2") != 0);
+#else
+   return 0;
+#endif
 }
 
-/********split */
+/********select_detected_kernel */
 
-void split (double tt,
+static void select_detected_kernel (void)
+/*
+------------------------------------------------------------------------
 
-            double *fr)
+   PURPOSE:
+      Selects the fastest kernel the processor supports the first time
+      it is called in the process; later calls, from any thread, wait
+      for that selection and change nothing.
+
+------------------------------------------------------------------------
+*/
+{
+#if defined(_WIN32)
+   InitOnceExecuteOnce (&KERNEL_ONCE, detect_kernel, NULL, NULL);
+#else
+   pthread_once (&KERNEL_ONCE, detect_kernel);
+#endif
+}
+
+/********detect_kernel */
+
+#if defined(_WIN32)
+static BOOL CALLBACK detect_kernel (PINIT_ONCE once, PVOID parameter,
+                                    PVOID *context)
+#else
+static void detect_kernel (void)
+#endif
 /*
 ------------------------------------------------------------------------
 
    PURPOSE:
-      This function breaks up a double number into a double integer
-      part and a fractional part.
+      Sets KERNEL to EPH_KERNEL_AVX2 if the processor supports it, else
+      EPH_KERNEL_SCALAR; run once by 'select_detected_kernel'.
 
-   REFERENCES:
-      Standish, E.M. and Newhall, X X (1988). "The JPL Export
-         Planetary Ephemeris"; JPL document dated 17 June 1988.
+------------------------------------------------------------------------
+*/
+{
+   KERNEL = cpu_has_avx2 () ? EPH_KERNEL_AVX2 : EPH_KERNEL_SCALAR;
 
-   INPUT
-   ARGUMENTS:
-      tt (double)
-         Input number.
+#if defined(_WIN32)
+   (void) once;
+   (void) parameter;
+   (void) context;
+   return TRUE;
+#endif
+}
 
-   OUTPUT
-   ARGUMENTS:
-      *fr (double)
-         2-element output array;
-            fr[0] contains integer part,
-            fr[1] contains fractional part.
-         For negative input numbers,
-            fr[0] contains the next more negative integer;
-            fr[1] contains a positive fraction.
+#if defined(EPH_HAVE_AVX2)
 
-   RETURNED
-   VALUE:
-      None.
+/********sum_series_avx2 */
 
-   GLOBALS
-   USED:
-      None.
+EPH_TARGET_AVX2
+static void sum_series_avx2 (double *pc, double *vc, double *buf,
+                             long int ncf, double vfac,
+                             double *position, double *velocity)
+/*
+------------------------------------------------------------------------
 
-   FUNCTIONS
-   CALLED:
-      None.
+   PURPOSE:
+      AVX2 'sum_series': x, y and z in three lanes of one vector,
+      position and velocity in the same pass over the coefficients.
 
-   VER./DATE/
-   PROGRAMMER:
-      V1.0/06-90/JAB (USNO/NA): CA coding standards
-      V1.1/03-93/WTH (USNO/AA): Convert to C.
-      V1.2/07-93/WTH (USNO/AA): Update to C standards.
-      V1.3/10-10/WKP (USNO/AA): Renamed function to lowercase to
-                                comply with coding standards.
+------------------------------------------------------------------------
+*/
+{
+   long int j;
 
-   NOTES:
-      None.
+   double p[4], v[4];
+
+   __m256d c, pos, vel;
+
+   pos = _mm256_setzero_pd ();
+   vel = _mm256_setzero_pd ();
+
+   for (j = ncf-1; j > 0; j--)
+   {
+      c = _mm256_set_pd (0.0, buf[j + 2 * ncf], buf[j + ncf], buf[j]);
+      pos = _mm256_add_pd (pos, _mm256_mul_pd (_mm256_set1_pd (pc[j]), c));
+      vel = _mm256_add_pd (vel, _mm256_mul_pd (_mm256_set1_pd (vc[j]), c));
+   }
+   c = _mm256_set_pd (0.0, buf[2 * ncf], buf[ncf], buf[0]);
+   pos = _mm256_add_pd (pos, _mm256_mul_pd (_mm256_set1_pd (pc[0]), c));
+   vel = _mm256_mul_pd (vel, _mm256_set1_pd (vfac));
+
+   _mm256_storeu_pd (p, pos);
+   _mm256_storeu_pd (v, vel);
+
+   for (j = 0; j < 3; j++)
+   {
+      position[j] = p[j];
+      velocity[j] = v[j];
+   }
+}
+
+/********sum_series_single_avx2 */
+
+EPH_TARGET_AVX2
+static void sum_series_single_avx2 (double *pc, double *vc, float *buf,
+                                    long int ncf, double vfac,
+                                    double *position, double *velocity)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      'sum_series_avx2' for single-precision coefficients, which are
+      widened to double as they are loaded.
 
 ------------------------------------------------------------------------
 */
 {
+   long int j;
+
+   double p[4], v[4];
+
+   __m256d c, pos, vel;
+
+   pos = _mm256_setzero_pd ();
+   vel = _mm256_setzero_pd ();
+
+   for (j = ncf-1; j > 0; j--)
+   {
+      c = _mm256_cvtps_pd (_mm_set_ps (0.0f, buf[j + 2 * ncf],
+         buf[j + ncf], buf[j]));
+      pos = _mm256_add_pd (pos, _mm256_mul_pd (_mm256_set1_pd (pc[j]), c));
+      vel = _mm256_add_pd (vel, _mm256_mul_pd (_mm256_set1_pd (vc[j]), c));
+   }
+   c = _mm256_cvtps_pd (_mm_set_ps (0.0f, buf[2 * ncf], buf[ncf],
+      buf[0]));
+   pos = _mm256_add_pd (pos, _mm256_mul_pd (_mm256_set1_pd (pc[0]), c));
+   vel = _mm256_mul_pd (vel, _mm256_set1_pd (vfac));
+
+   _mm256_storeu_pd (p, pos);
+   _mm256_storeu_pd (v, vel);
+
+   for (j = 0; j < 3; j++)
+   {
+      position[j] = p[j];
+      velocity[j] = v[j];
+   }
+}
 
+/********interpolate_4_avx2 */
+
+EPH_TARGET_AVX2
+static void interpolate_4_avx2 (double *buf, double *t, double span,
+                                long int ncf, long int na,
+                                double *position, double *velocity)
 /*
-   Get integer and fractional parts.
+------------------------------------------------------------------------
+
+   PURPOSE:
+      'interpolate_epochs' for four epochs, one per vector lane: the
+      polynomial values of all four are computed together, and each
+      lane gathers the coefficients of its own sub-interval.
+
+------------------------------------------------------------------------
 */
+{
+   long int e, i, j, l;
 
-   fr[0] = (double)((long int) tt);
-   fr[1] = tt - fr[0];
+   long long int offset[4];
+
+   double dna, dt1, temp, tc[4], out[4];
+
+   __m256d pc[18], vc[18], twot, sum, vfac;
+   __m256i index;
 
 /*
-   Make adjustments for negative input number.
+   Sub-interval and normalized Chebyshev time of each epoch, as in
+   'evaluate_chebyshev'.
 */
 
-   if ((tt >= 0.0) || (fr[1] == 0.0))
-      return;
-    else
+   dna = (double) na;
+   for (e = 0; e < 4; e++)
    {
-      fr[0] = fr[0] - 1.0;
-      fr[1] = fr[1] + 1.0;
+      dt1 = (double) ((long int) t[e]);
+      temp = dna * t[e];
+      l = (long int) (temp - dt1);
+      tc[e] = 2.0 * (fmod (temp, 1.0) + dt1) - 1.0;
+      offset[e] = (long long int) (l * (3 * ncf));
    }
 
-   return;
+   index = _mm256_loadu_si256 ((__m256i *) offset);
+
+   pc[0] = _mm256_set1_pd (1.0);
+   pc[1] = _mm256_loadu_pd (tc);
+   twot = _mm256_add_pd (pc[1], pc[1]);
+   for (j = 2; j < ncf; j++)
+      pc[j] = _mm256_sub_pd (_mm256_mul_pd (twot, pc[j-1]), pc[j-2]);
+
+   vc[0] = _mm256_setzero_pd ();
+   vc[1] = _mm256_set1_pd (1.0);
+   vc[2] = _mm256_mul_pd (_mm256_set1_pd (2.0), twot);
+   for (j = 3; j < ncf; j++)
+      vc[j] = _mm256_sub_pd (_mm256_add_pd (_mm256_add_pd (
+         _mm256_mul_pd (twot, vc[j-1]), pc[j-1]), pc[j-1]), vc[j-2]);
+
+   vfac = _mm256_set1_pd ((2.0 * dna) / span);
+
+   for (i = 0; i < 3; i++)
+   {
+      sum = _mm256_setzero_pd ();
+      for (j = ncf-1; j >= 0; j--)
+         sum = _mm256_add_pd (sum, _mm256_mul_pd (pc[j],
+            _mm256_i64gather_pd (&buf[j + (i * ncf)], index, 8)));
+      _mm256_storeu_pd (out, sum);
+      for (e = 0; e < 4; e++)
+         position[3 * e + i] = out[e];
+
+      if (velocity == NULL)
+         continue;
+
+      sum = _mm256_setzero_pd ();
+      for (j = ncf-1; j > 0; j--)
+         sum = _mm256_add_pd (sum, _mm256_mul_pd (vc[j],
+            _mm256_i64gather_pd (&buf[j + (i * ncf)], index, 8)));
+      sum = _mm256_mul_pd (sum, vfac);
+      _mm256_storeu_pd (out, sum);
+      for (e = 0; e < 4; e++)
+         velocity[3 * e + i] = out[e];
+   }
+}
+
+#endif
+
+/********reset_basis */
+
+static void reset_basis (cheby_basis *basis)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Sets the initial polynomial values T0 = 1 and T1' = 1.
+
+------------------------------------------------------------------------
+*/
+{
+   short int i;
+
+   basis->np = 2;
+   basis->nv = 3;
+   basis->twot = 0.0;
+
+   for (i = 0; i < 18; i++)
+   {
+      basis->pc[i] = 0.0;
+      basis->vc[i] = 0.0;
+   }
+
+   basis->pc[0] = 1.0;
+   basis->vc[1] = 1.0;
 }
@@ -30,18 +30,127 @@
 #endif
 
 /*
-   External variables
+   Ephemeris file access modes (see 'ephem_reader_open').
+*/
+
+#define EPH_ACCESS_BUFFERED 0
+#define EPH_ACCESS_MAPPED   1
+
+/*
+   Number of records a buffered reader keeps in memory unless set with
+   'ephem_reader_set_cache_size'.
+*/
+
+#define EPH_CACHE_RECORDS   8
+
+/*
+   Number of bodies 'state' interpolates (targets 0-10).
+*/
+
+#define EPH_STATE_TARGETS   11
+
+/*
+   Series selection for 'ephem_reader_extract': bit n selects 'state'
+   target n (0-10), EPH_SERIES_NUTATIONS and EPH_SERIES_LIBRATIONS the
+   remaining series of the file.  EPH_SERIES_PLANETARY selects the
+   Sun, Moon, Earth-Moon barycenter and planets.
+*/
+
+#define EPH_SERIES_NUTATIONS  0x0800L
+#define EPH_SERIES_LIBRATIONS 0x1000L
+#define EPH_SERIES_PLANETARY  0x07FFL
+
+/*
+   Marks the header of a compact file written by 'ephem_reader_extract';
+   it follows LPT in the header record, and is followed by the record
+   length.
+*/
+
+#define EPH_COMPACT_MAGIC   0x70C0DE01
+
+/*
+   Chebyshev summation kernels (see 'ephem_select_kernel').
+*/
+
+#define EPH_KERNEL_SCALAR   0
+#define EPH_KERNEL_AVX2     1
+
+/*
+   Precision of the coefficients 'state' evaluates on the calling
+   thread (see 'ephem_set_precision').
+*/
+
+#define EPH_PRECISION_DOUBLE 0
+#define EPH_PRECISION_SINGLE 1
+
+/*
+   Chebyshev polynomial values cached between interpolations at the
+   same normalized time.
+*/
+
+typedef struct
+{
+   long int np;
+   long int nv;
+   double pc[18];
+   double vc[18];
+   double twot;
+} cheby_basis;
+
+/*
+   State of one open ephemeris file.  A reader is used by one thread at
+   a time; a zero-initialized reader is closed.
 */
 
-extern short int KM;
+typedef struct ephem_reader
+{
+   FILE *file;
+   short int access;
+   char *map;
+   long int map_size;
+   void *map_handle;
+   short int km;
+   short int de_number;
+   int ipt[3][12];
+   int lpt[3];
+   long int record_length;
+   double ss[3];
+   double jplau;
+   double em_ratio;
+   long int cache_size;
+   long int cache_last;
+   long int *cache_records;
+   unsigned long int *cache_used;
+   unsigned long int cache_clock;
+   unsigned long int cache_hits;
+   unsigned long int cache_misses;
+   unsigned long int record_switches;
+   long int record_last;
+   unsigned long int reads;
+   unsigned long int records_read;
+   unsigned long int bytes_read;
+   unsigned long int interpolations[EPH_STATE_TARGETS];
+   double *cache;
+   void *preload_block;
+   double *preload;
+   long int preload_first;
+   long int preload_count;
+   void *single_block;
+   float *single;
+   long int single_first;
+   long int single_count;
+   cheby_basis basis;
+} ephem_reader;
+
+/*
+   External variables
+*/
 
 extern int IPT[3][12], LPT[3];
 
-extern long int  NRL, NP, NV;
 extern long int RECORD_LENGTH;
 
-extern double SS[3], JPLAU, PC[18], VC[18], TWOT, EM_RATIO;
-extern double *BUFFER;
+extern double SS[3], JPLAU, EM_RATIO;
 
 extern FILE *EPHFILE;
 
@@ -54,6 +163,11 @@ short int ephem_open (char *ephem_name,
                       double *jd_begin, double *jd_end, 
                       short int *de_number);
 
+short int ephem_open_mapped (char *ephem_name,
+
+                             double *jd_begin, double *jd_end,
+                             short int *de_number);
+
 short int ephem_close (void);
 
 short int planet_ephemeris (double tjd[2], short int target, 
@@ -65,10 +179,75 @@ short int state (double *jed, short int target,
 
                  double *target_pos, double *target_vel);
 
+short int state_batch (short int target, const double *jd, size_t n,
+
+                       double *target_pos, double *target_vel);
+
 void interpolate (double *buf, double *t, long int ncm, long int na,
 
                   double *position, double *velocity);
 
+void interpolate_epochs (double *buf, double *t, long int n,
+                         double span, long int ncf, long int na,
+
+                         double *position, double *velocity);
+
+short int ephem_select_kernel (short int kernel);
+
+short int ephem_kernel (void);
+
 void split (double tt, double *fr);
 
+short int ephem_reader_open (ephem_reader *reader, char *ephem_name,
+                             short int access,
+
+                             double *jd_begin, double *jd_end,
+                             short int *de_number);
+
+short int ephem_reader_close (ephem_reader *reader);
+
+ephem_reader *ephem_reader_bind (ephem_reader *reader);
+
+ephem_reader *ephem_default_reader (void);
+
+ephem_reader *ephem_current_reader (void);
+
+short int ephem_reader_set_cache_size (ephem_reader *reader,
+                                       long int records);
+
+void ephem_reader_reset_stats (ephem_reader *reader);
+
+short int ephem_reader_preload (ephem_reader *reader, double jd_begin,
+                                double jd_end);
+
+short int ephem_reader_load_single (ephem_reader *reader,
+                                    double jd_begin, double jd_end);
+
+short int ephem_set_precision (short int precision);
+
+short int ephem_precision (void);
+
+short int ephem_reader_extract (ephem_reader *reader, char *compact_name,
+                                double jd_begin, double jd_end,
+                                long int series);
+
+short int ephem_reader_planet_ephemeris (ephem_reader *reader,
+                                         double tjd[2], short int target,
+                                         short int center,
+
+                                         double *position,
+                                         double *velocity);
+
+short int ephem_reader_state (ephem_reader *reader, double *jed,
+                              short int target,
+
+                              double *target_pos, double *target_vel);
+
+short int ephem_reader_state_batch (ephem_reader *reader,
+                                    short int target,
+                                    const double *jd, size_t n,
+
+                                    double *target_pos,
+                                    double *target_vel);
+
 #endif
@@ -26,6 +26,37 @@
 static double PSI_COR = 0.0;
 static double EPS_COR = 0.0;
 
+#if defined(_MSC_VER)
+   #define NOVAS_THREAD_LOCAL __declspec(thread)
+#else
+   #define NOVAS_THREAD_LOCAL _Thread_local
+#endif
+
+/*
+   Values kept between calls: the context bound on each thread with
+   'novas_context_bind', or the default context.
+*/
+
+static novas_context DEFAULT_CONTEXT;
+static NOVAS_THREAD_LOCAL novas_context *BOUND_CONTEXT = NULL;
+
+static novas_context *current_context (void);
+
+static short int place_bodies_of_epoch (double jd_tt, short int accuracy,
+                                        object *earth, object *sun,
+
+                                        place_epoch *epoch);
+
+static short int place_observer (double jd_tt, double delta_t,
+                                 short int accuracy, observer *location,
+
+                                 place_epoch *epoch);
+
+static short int place_object (place_epoch *epoch, object *cel_object,
+                               short int coord_sys, short int accuracy,
+
+                               sky_pos *output);
+
 
 
 /********app_star */
@@ -1567,6 +1598,12 @@ short int place (double jd_tt, object *cel_object,
       V1.7/10-08/JAB (USNO/AA) Modify calls to 'ephemeris' to support
                                two-part input Julian date.
       V1.8/07-10/JLB (USNO/AA) Corrected citation to Kaplan et al.
+      V1.9/10-26 (planetaria)  Split into 'place_bodies_of_epoch',
+                               'place_observer' and 'place_object',
+                               shared with 'place_bodies'.
+      V2.0/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. Values of 'location->where' and 'coord_sys' dictate the various
@@ -1584,23 +1621,11 @@ short int place (double jd_tt, object *cel_object,
 ------------------------------------------------------------------------
 */
 {
-   static short int first_time = 1;
+   novas_place_state *cache = &current_context ()->place;
    short int error = 0;
-   short int loc, rs, i;
-
-   static double tlast1 = 0.0;
-   static double tlast2 = 0.0;
-   static double jd_tdb, peb[3], veb[3], psb[3], vsb[3], px[3], py[3],
-      pz[3];
-   double x, secdif, jd[2], pog[3], vog[3], pob[3], vob[3], pos1[3],
-      vel1[3], dt, pos2[3], pos3[3], t_light, t_light0, pos4[3], frlimb,
-      pos5[3], pos6[3], pos7[3], pos8[3], r_cio, d_obs_geo, d_obs_sun,
-      d_obj_sun;
 
    cat_entry null_star;
 
-   static object earth, sun;
-
 /*
    Check for invalid value of 'coord_sys' or 'accuracy'.
 */
@@ -1615,15 +1640,15 @@ short int place (double jd_tt, object *cel_object,
    Create a null star 'cat_entry' and  Earth and Sun 'object's.
 */
 
-   if (first_time)
+   if (cache->first_time)
    {
       make_cat_entry ("NULL_STAR","   ",0L,0.0,0.0,0.0,0.0,0.0,0.0,
          &null_star);
 
-      make_object (0,3,"Earth",&null_star, &earth);
-      make_object (0,10,"Sun",&null_star, &sun);
+      make_object (0,3,"Earth",&null_star, &cache->earth);
+      make_object (0,10,"Sun",&null_star, &cache->sun);
 
-      first_time = 0;
+      cache->first_time = 0;
    }
 
 /*
@@ -1643,44 +1668,236 @@ short int place (double jd_tt, object *cel_object,
    ---------------------------------------------------------------------
 */
 
-   if (fabs (jd_tt - tlast1) > 1.0e-8)
+   if (fabs (jd_tt - cache->tlast1) > 1.0e-8)
    {
+      if ((error = place_bodies_of_epoch (jd_tt,accuracy,
+         &cache->earth,&cache->sun, &cache->epoch)) != 0)
+         return error;
+
+      cache->tlast1 = jd_tt;
+   }
+
+/*
+   ---------------------------------------------------------------------
+   Get position and velocity of observer.
+   ---------------------------------------------------------------------
+*/
+
+   if ((error = place_observer (jd_tt,delta_t,accuracy,location,
+      &cache->epoch)) != 0)
+      return error;
+
+   return place_object (&cache->epoch,cel_object,coord_sys,accuracy,
+      output);
+}
+
+/********place_bodies */
+
+short int place_bodies (double jd_tt, short int n, object *cel_objects,
+                        observer *location, double delta_t,
+                        short int coord_sys, short int accuracy,
+
+                        sky_pos *output)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      This function computes the apparent directions of several stars
+      or solar system bodies at one time, in one coordinate system.
+      The terms common to all of them (TDB, the barycentric states of
+      the Earth and Sun, and the position of the observer) are
+      computed once.
+
+   REFERENCES:
+      Kaplan, G. et al. (1989), Astronomical Journal 97, 1197-1210.
+      Klioner, S. (2003), Astronomical Journal 125, 1580-1597.
+
+   INPUT
+   ARGUMENTS:
+      jd_tt (double)
+         TT Julian date for place.
+      n (short int)
+         Number of objects.
+      *cel_objects (struct object)
+         Array of 'n' celestial objects of interest (structure defined
+         in novas.h).
+      *location (struct observer)
+         Specifies the location of the observer (structure defined in
+         novas.h).
+      delta_t (double)
+         Difference TT-UT1 at 'jd_tt', in seconds of time.
+      coord_sys (short int)
+         Code specifying coordinate system of the output position, as
+         for 'place'.
+      accuracy (short int)
+         Code specifying the relative accuracy of the output position.
+            = 0 ... full accuracy
+            = 1 ... reduced accuracy
+
+   OUTPUT
+   ARGUMENTS:
+      *output (struct sky_pos)
+         Array of 'n' places on the sky, one for each object, as
+         returned by 'place'.
+
+   RETURNED
+   VALUE:
+      = 0         ... No problems.
+      otherwise   ... Error code of 'place', for the first object in
+                      error.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      make_cat_entry     novas.c
+      make_object        novas.c
+      place_bodies_of_epoch
+                         novas.c
+      place_observer     novas.c
+      place_object       novas.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. Each place is identical to the one 'place' returns for the
+      same object.
+      2. Unlike 'place', nothing is kept between calls.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error = 0;
+   short int i;
+
+   place_epoch epoch;
+
+   cat_entry null_star;
+
+   object earth, sun;
+
+   if ((coord_sys < 0) || (coord_sys > 3))
+      return (error = 1);
+
+   if ((accuracy < 0) || (accuracy > 1))
+      return (error = 2);
+
+   for (i = 0; i < n; i++)
+   {
+      if ((cel_objects[i].type == 0) && (cel_objects[i].number == 3) &&
+         (location->where != 2))
+         return (error = 3);
+   }
+
+   make_cat_entry ("NULL_STAR","   ",0L,0.0,0.0,0.0,0.0,0.0,0.0,
+      &null_star);
+
+   make_object (0,3,"Earth",&null_star, &earth);
+   make_object (0,10,"Sun",&null_star, &sun);
+
+/*
+   Terms shared by all objects.
+*/
+
+   if ((error = place_bodies_of_epoch (jd_tt,accuracy,&earth,&sun,
+      &epoch)) != 0)
+      return error;
+
+   if ((error = place_observer (jd_tt,delta_t,accuracy,location,
+      &epoch)) != 0)
+      return error;
+
+/*
+   Place of each object.
+*/
+
+   for (i = 0; i < n; i++)
+   {
+      if ((error = place_object (&epoch,&cel_objects[i],coord_sys,
+         accuracy, &output[i])) != 0)
+         return error;
+   }
+
+   return (error);
+}
+
+/********place_bodies_of_epoch */
+
+static short int place_bodies_of_epoch (double jd_tt, short int accuracy,
+                                        object *earth, object *sun,
+
+                                        place_epoch *epoch)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Part of 'place': TDB Julian date and barycentric states of the
+      Earth and Sun at 'jd_tt'.  Returns 0 or the error code of
+      'place'.
+
+------------------------------------------------------------------------
+*/
+{
+   short int error = 0;
+
+   double x, secdif, jd[2];
 
 /*
    Compute 'jd_tdb', the TDB Julian date corresponding to 'jd_tt'.
 */
 
-      jd_tdb = jd_tt;
-      tdb2tt (jd_tdb, &x,&secdif);
-      jd_tdb = jd_tt + secdif / 86400.0;
+   epoch->jd_tdb = jd_tt;
+   tdb2tt (epoch->jd_tdb, &x,&secdif);
+   epoch->jd_tdb = jd_tt + secdif / 86400.0;
 
 /*
    Get position and velocity of Earth wrt barycenter of solar system,
    in ICRS.
 */
 
-      jd[0] = jd_tdb;
-      jd[1] = 0.0;
+   jd[0] = epoch->jd_tdb;
+   jd[1] = 0.0;
 
-      if ((error = ephemeris (jd,&earth,0,accuracy, peb,veb)) != 0)
-         return (error += 10);
+   if ((error = ephemeris (jd,earth,0,accuracy, epoch->peb,epoch->veb))
+      != 0)
+      return (error += 10);
 
 /*
    Get position and velocity of Sun wrt barycenter of solar system,
    in ICRS.
 */
 
-      if ((error = ephemeris (jd,&sun,0,accuracy, psb,vsb)) != 0)
-         return (error += 10);
+   if ((error = ephemeris (jd,sun,0,accuracy, epoch->psb,epoch->vsb))
+      != 0)
+      return (error += 10);
 
-      tlast1 = jd_tt;
-   }
+   return error;
+}
+
+/********place_observer */
+
+static short int place_observer (double jd_tt, double delta_t,
+                                 short int accuracy, observer *location,
 
+                                 place_epoch *epoch)
 /*
-   ---------------------------------------------------------------------
-   Get position and velocity of observer.
-   ---------------------------------------------------------------------
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Part of 'place': position and velocity of the observer, relative
+      to the geocenter and to the barycenter of the solar system.
+      Requires the Earth's state from 'place_bodies_of_epoch'.
+      Returns 0 or the error code of 'place'.
+
+------------------------------------------------------------------------
 */
+{
+   short int error = 0;
+   short int i;
 
    if ((location->where == 1) || (location->where == 2))
    {
@@ -1691,11 +1908,11 @@ short int place (double jd_tt, object *cel_object,
    satellite).
 */
 
-      if ((error = geo_posvel (jd_tt,delta_t,accuracy,location, pog,vog))
-         != 0)
+      if ((error = geo_posvel (jd_tt,delta_t,accuracy,location,
+         epoch->pog,epoch->vog)) != 0)
          return (error += 40);
 
-      loc = 1;
+      epoch->loc = 1;
    }
     else
    {
@@ -1707,11 +1924,11 @@ short int place (double jd_tt, object *cel_object,
 
     for (i = 0; i < 3; i++)
     {
-       pog[i] = 0.0;
-       vog[i] = 0.0;
+       epoch->pog[i] = 0.0;
+       epoch->vog[i] = 0.0;
     }
 
-    loc = 0;
+    epoch->loc = 0;
    }
 
 /*
@@ -1721,10 +1938,47 @@ short int place (double jd_tt, object *cel_object,
 
     for (i = 0; i < 3; i++)
     {
-       pob[i] = peb[i] + pog[i];
-       vob[i] = veb[i] + vog[i];
+       epoch->pob[i] = epoch->peb[i] + epoch->pog[i];
+       epoch->vob[i] = epoch->veb[i] + epoch->vog[i];
     }
 
+   return error;
+}
+
+/********place_object */
+
+static short int place_object (place_epoch *epoch, object *cel_object,
+                               short int coord_sys, short int accuracy,
+
+                               sky_pos *output)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Part of 'place': the place of one object, given the terms in
+      'epoch' from 'place_bodies_of_epoch' and 'place_observer'.
+      Returns 0 or the error code of 'place'.
+
+------------------------------------------------------------------------
+*/
+{
+   novas_place_state *cache = &current_context ()->place;
+   short int error = 0;
+   short int loc, rs, i;
+
+   double x, jd[2], jd_tdb, pos1[3], vel1[3], dt, pos2[3], pos3[3],
+      t_light, t_light0, pos4[3], frlimb, pos5[3], pos6[3], pos7[3],
+      pos8[3], r_cio, d_obs_geo, d_obs_sun, d_obj_sun;
+   double *peb, *psb, *pog, *pob, *vob;
+
+   jd_tdb = epoch->jd_tdb;
+   peb = epoch->peb;
+   psb = epoch->psb;
+   pog = epoch->pog;
+   pob = epoch->pob;
+   vob = epoch->vob;
+   loc = epoch->loc;
+
 /*
    ---------------------------------------------------------------------
    Find geometric position of observed object.
@@ -1839,7 +2093,7 @@ short int place (double jd_tt, object *cel_object,
 
       case (2):    /* Transform to equator and CIO of date. */
 
-         if (fabs (jd_tdb - tlast2) > 1.0e-8 )
+         if (fabs (jd_tdb - cache->tlast2) > 1.0e-8 )
          {
 
 /*
@@ -1851,19 +2105,22 @@ short int place (double jd_tt, object *cel_object,
                &rs)) != 0)
                return (error += 80);
             if ((error = cio_basis (jd_tdb,r_cio,rs,accuracy,
-               px,py,pz)) != 0)
+               cache->px,cache->py,cache->pz)) != 0)
                return (error += 90);
 
-            tlast2 = jd_tdb;
+            cache->tlast2 = jd_tdb;
          }
 
 /*
    Transform position vector to celestial intermediate system.
 */
 
-         pos8[0] = px[0] * pos5[0] + px[1] * pos5[1] + px[2] * pos5[2];
-         pos8[1] = py[0] * pos5[0] + py[1] * pos5[1] + py[2] * pos5[2];
-         pos8[2] = pz[0] * pos5[0] + pz[1] * pos5[1] + pz[2] * pos5[2];
+         pos8[0] = cache->px[0] * pos5[0] + cache->px[1] * pos5[1]
+            + cache->px[2] * pos5[2];
+         pos8[1] = cache->py[0] * pos5[0] + cache->py[1] * pos5[1]
+            + cache->py[2] * pos5[2];
+         pos8[2] = cache->pz[0] * pos5[0] + cache->pz[1] * pos5[1]
+            + cache->pz[2] * pos5[2];
          break;
 
       default:     /* No transformation -- keep coordinates in GCRS, */
@@ -2228,6 +2485,9 @@ short int equ2ecl_vec (double jd_tt, short int coord_sys,
       V1.0/05-06/JAB (USNO/AA)
       V1.1/05-08/WKP (USNO/AA) Changed values of coord_sys to be
                                more consistent with gcrs2equ.
+      V1.2/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. To convert an ICRS vector to an ecliptic vector (mean ecliptic
@@ -2241,11 +2501,9 @@ short int equ2ecl_vec (double jd_tt, short int coord_sys,
 ------------------------------------------------------------------------
 */
 {
+   novas_obliquity_state *cache = &current_context ()->equ2ecl;
    short int error = 0;
 
-   static double t_last = 0.0;
-   static double ob2000 = 0.0;
-   static double oblm, oblt;
    double t, secdiff, jd_tdb, pos0[3], w, x, y, z, obl;
 
 /*
@@ -2266,19 +2524,20 @@ short int equ2ecl_vec (double jd_tt, short int coord_sys,
          pos0[0] = pos1[0];
          pos0[1] = pos1[1];
          pos0[2] = pos1[2];
-         if (fabs (jd_tt - t_last) > 1.0e-8)
+         if (fabs (jd_tt - cache->t_last) > 1.0e-8)
          {
-            e_tilt (jd_tdb,accuracy, &oblm,&oblt,&x,&y,&z);
-            t_last = jd_tt;
+            e_tilt (jd_tdb,accuracy,
+               &cache->oblm,&cache->oblt,&x,&y,&z);
+            cache->t_last = jd_tt;
          }
 
          switch (coord_sys)
          {
             case 0:       /* Use mean obliquity of date */
-               obl = oblm * DEG2RAD;
+               obl = cache->oblm * DEG2RAD;
                break;
             case 1:       /* Use true obliquity of date */
-               obl = oblt * DEG2RAD;
+               obl = cache->oblt * DEG2RAD;
                break;
          }
          break;
@@ -2286,12 +2545,12 @@ short int equ2ecl_vec (double jd_tt, short int coord_sys,
       case 2:             /* Input: ICRS */
          frame_tie (pos1,1, pos0);
 
-         if (ob2000 == 0.0)
+         if (cache->ob2000 == 0.0)
          {
-            e_tilt (T0,accuracy, &oblm,&w,&x,&y,&z);
-            ob2000 = oblm;
+            e_tilt (T0,accuracy, &cache->oblm,&w,&x,&y,&z);
+            cache->ob2000 = cache->oblm;
          }
-         obl = ob2000 * DEG2RAD;
+         obl = cache->ob2000 * DEG2RAD;
          break;
 
       default:
@@ -2377,6 +2636,9 @@ short int ecl2equ_vec (double jd_tt, short int coord_sys,
                                more consistent with gcrs2equ.
       V1.2/09-10/WKP (USNO/AA) Initialized 'obl' variable to silence
                                compiler warning.
+      V1.3/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. To convert an ecliptic vector (mean ecliptic and equinox of
@@ -2390,11 +2652,9 @@ short int ecl2equ_vec (double jd_tt, short int coord_sys,
 ------------------------------------------------------------------------
 */
 {
+   novas_obliquity_state *cache = &current_context ()->ecl2equ;
    short int error = 0;
 
-   static double t_last = 0.0;
-   static double ob2000 = 0.0;
-   static double oblm, oblt;
    double t, secdiff, jd_tdb, pos0[3], w, x, y, z, obl = 0.0;
 
 /*
@@ -2412,30 +2672,31 @@ short int ecl2equ_vec (double jd_tt, short int coord_sys,
    {
       case 0:             /* Output: mean equator and equinox of date */
       case 1:             /* Output: true equator and equinox of date */
-         if (fabs (jd_tt - t_last) > 1.0e-8)
+         if (fabs (jd_tt - cache->t_last) > 1.0e-8)
          {
-            e_tilt (jd_tdb,accuracy, &oblm,&oblt,&x,&y,&z);
-            t_last = jd_tt;
+            e_tilt (jd_tdb,accuracy,
+               &cache->oblm,&cache->oblt,&x,&y,&z);
+            cache->t_last = jd_tt;
          }
 
          switch (coord_sys)
          {
             case 0:       /* Use mean obliquity of date */
-               obl = oblm * DEG2RAD;
+               obl = cache->oblm * DEG2RAD;
                break;
             case 1:       /* Use true obliquity of date */
-               obl = oblt * DEG2RAD;
+               obl = cache->oblt * DEG2RAD;
                break;
          }
          break;
 
       case 2:             /* Output: ICRS */
-         if (ob2000 == 0.0)
+         if (cache->ob2000 == 0.0)
          {
-            e_tilt (T0,accuracy, &oblm,&w,&x,&y,&z);
-            ob2000 = oblm;
+            e_tilt (T0,accuracy, &cache->oblm,&w,&x,&y,&z);
+            cache->ob2000 = cache->oblm;
          }
-         obl = ob2000 * DEG2RAD;
+         obl = cache->ob2000 * DEG2RAD;
          break;
 
       default:
@@ -3013,6 +3274,9 @@ short int sidereal_time (double jd_high, double jd_low,
                                this function computes either mean or
                                apparent sidereal time, and removed
                                Note 1 for consistency with Fortran.
+      V2.8/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. The Julian date may be split at any point, but for highest
@@ -3024,11 +3288,10 @@ short int sidereal_time (double jd_high, double jd_low,
 ------------------------------------------------------------------------
 */
 {
+   novas_sidereal_time_state *cache = &current_context ()->sidereal_time;
    short int error = 0;
    short int ref_sys;
 
-   static double ee;
-   static double jd_last = -99.0;
    double unitx[3] = {1.0, 0.0, 0.0};
    double jd_ut, jd_tt, jd_tdb, tt_temp, t, theta, a, b, c, d,
       ra_cio, x[3], y[3], z[3], w1[3], w2[3], eq[3], ha_eq, st,
@@ -3068,12 +3331,12 @@ short int sidereal_time (double jd_high, double jd_low,
    if (((gst_type == 0) && (method == 0)) ||       /* GMST; CIO-TIO */
        ((gst_type == 1) && (method == 1)))         /* GAST; equinox */
    {
-      if (fabs (jd_tdb - jd_last) > 1.0e-8)
+      if (fabs (jd_tdb - cache->jd_last) > 1.0e-8)
       {
-         e_tilt (jd_tdb,accuracy, &a,&b,&ee,&c,&d);
-         jd_last = jd_tdb;
+         e_tilt (jd_tdb,accuracy, &a,&b,&cache->ee,&c,&d);
+         cache->jd_last = jd_tdb;
       }
-      eqeq = ee * 15.0;
+      eqeq = cache->ee * 15.0;
    }
     else
    {
@@ -3795,6 +4058,9 @@ void spin (double angle, double *pos1,
       V1.0/08-93/WTH (USNO/AA) Translate Fortran.
       V2.0/10-03/JAB (USNO/AA) Update for IAU 2000 resolutions.
       V2.1/01-05/JAB (USNO/AA) Generalize the function.
+      V2.2/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. This function is the C version of NOVAS Fortran routine 'spin'.
@@ -3802,11 +4068,10 @@ void spin (double angle, double *pos1,
 ------------------------------------------------------------------------
 */
 {
-   static double ang_last = -999.0;
-   static double xx, yx, zx, xy, yy, zy, xz, yz, zz;
+   novas_spin_state *cache = &current_context ()->spin;
    double angr, cosang, sinang;
 
-   if (fabs (angle - ang_last) >= 1.0e-12)
+   if (fabs (angle - cache->ang_last) >= 1.0e-12)
    {
       angr = angle * DEG2RAD;
       cosang = cos (angr);
@@ -3816,26 +4081,29 @@ void spin (double angle, double *pos1,
    Rotation matrix follows.
 */
 
-      xx =  cosang;
-      yx =  sinang;
-      zx =  0.0;
-      xy =  -sinang;
-      yy =  cosang;
-      zy =  0.0;
-      xz =  0.0;
-      yz =  0.0;
-      zz =  1.0;
+      cache->xx =  cosang;
+      cache->yx =  sinang;
+      cache->zx =  0.0;
+      cache->xy =  -sinang;
+      cache->yy =  cosang;
+      cache->zy =  0.0;
+      cache->xz =  0.0;
+      cache->yz =  0.0;
+      cache->zz =  1.0;
 
-      ang_last = angle;
+      cache->ang_last = angle;
    }
 
 /*
    Perform rotation.
 */
 
-   pos2[0] = xx * pos1[0] + yx * pos1[1] + zx * pos1[2];
-   pos2[1] = xy * pos1[0] + yy * pos1[1] + zy * pos1[2];
-   pos2[2] = xz * pos1[0] + yz * pos1[1] + zz * pos1[2];
+   pos2[0] = cache->xx * pos1[0] + cache->yx * pos1[1]
+      + cache->zx * pos1[2];
+   pos2[1] = cache->xy * pos1[0] + cache->yy * pos1[1]
+      + cache->zy * pos1[2];
+   pos2[2] = cache->xz * pos1[0] + cache->yz * pos1[1]
+      + cache->zz * pos1[2];
 
    return;
 }
@@ -4046,6 +4314,8 @@ void terra (on_surface *location, double st,
       V1.3/12-04/JAB (USNO/AA):  Update to use 'on_surface" structure.
       V1.4/09-09/WKP (USNO/AA):  Moved ht_km calculation from first_entry
                                  block.
+      V1.5/10-26 (planetaria)  Constants computed on each call instead
+                               of kept in static variables.
 
    NOTES:
       1. If reference meridian is Greenwich and st=0, 'pos' is
@@ -4064,18 +4334,11 @@ void terra (on_surface *location, double st,
 ------------------------------------------------------------------------
 */
 {
-   static short int first_entry = 1;
    short int j;
 
-   static double erad_km, ht_km;
-   double df, df2, phi, sinphi, cosphi, c, s, ach, ash, stlocl, sinst,
-      cosst;
-
-   if (first_entry)
-   {
-      erad_km = ERAD / 1000.0;
-      first_entry = 0;
-   }
+   double erad_km = ERAD / 1000.0;
+   double ht_km, df, df2, phi, sinphi, cosphi, c, s, ach, ash, stlocl,
+      sinst, cosst;
 
 /*
    Compute parameters relating to geodetic to geocentric conversion.
@@ -4201,6 +4464,9 @@ void e_tilt (double jd_tdb, short int accuracy,
       V2.0/10-03/JAB (USNO/AA) Update function for IAU 2000 resolutions.
       V2.1/12-04/JAB (USNO/AA) Add 'mode' argument.
       V2.2/01-06/WKP (USNO/AA) Changed 'mode' to 'accuracy'.
+      V2.3/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. Values of the celestial pole offsets 'PSI_COR' and 'EPS_COR'
@@ -4212,11 +4478,9 @@ void e_tilt (double jd_tdb, short int accuracy,
 ------------------------------------------------------------------------
 */
 {
-   static short int accuracy_last = 0;
+   novas_e_tilt_state *cache = &current_context ()->e_tilt;
    short int acc_diff;
 
-   static double jd_last = 0.0;
-   static double dp, de, c_terms;
    double t, d_psi, d_eps, mean_ob, true_ob, eq_eq;
 
 /*
@@ -4229,7 +4493,7 @@ void e_tilt (double jd_tdb, short int accuracy,
    Check for difference in accuracy mode from last call.
 */
 
-   acc_diff = accuracy - accuracy_last;
+   acc_diff = accuracy - cache->accuracy_last;
 
 /*
    Compute the nutation angles (arcseconds) if the input Julian date
@@ -4237,31 +4501,31 @@ void e_tilt (double jd_tdb, short int accuracy,
    accuracy mode has changed from the last call.
 */
 
-   if (((fabs (jd_tdb - jd_last)) > 1.0e-8) || (acc_diff != 0))
+   if (((fabs (jd_tdb - cache->jd_last)) > 1.0e-8) || (acc_diff != 0))
    {
-      nutation_angles (t,accuracy, &dp,&de);
+      nutation_angles (t,accuracy, &cache->dp,&cache->de);
 
 /*
    Obtain complementary terms for equation of the equinoxes in
    arcseconds.
 */
 
-      c_terms = ee_ct (jd_tdb,0.0,accuracy) / ASEC2RAD;
+      cache->c_terms = ee_ct (jd_tdb,0.0,accuracy) / ASEC2RAD;
 
 /*
    Reset the values of the last Julian date and last mode.
 */
 
-      jd_last = jd_tdb;
-      accuracy_last = accuracy;
+      cache->jd_last = jd_tdb;
+      cache->accuracy_last = accuracy;
    }
 
 /*
    Apply observed celestial pole offsets.
 */
 
-   d_psi = dp + PSI_COR;
-   d_eps = de + EPS_COR;
+   d_psi = cache->dp + PSI_COR;
+   d_eps = cache->de + EPS_COR;
 
 /*
    Compute mean obliquity of the ecliptic in arcseconds.
@@ -4286,7 +4550,7 @@ void e_tilt (double jd_tdb, short int accuracy,
    Compute equation of the equinoxes in seconds of time.
 */
 
-   eq_eq = d_psi * cos (mean_ob * DEG2RAD) + c_terms;
+   eq_eq = d_psi * cos (mean_ob * DEG2RAD) + cache->c_terms;
    eq_eq /= 15.0;
 
 /*
@@ -4827,6 +5091,9 @@ void frame_tie (double *pos1, short int direction,
       V1.0/09-03/JAB (USNO/AA)
       V1.1/02-06/WKP (USNO/AA) Added second-order corrections to diagonal
                                elements.
+      V1.2/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. For geocentric coordinates, the same transformation is used
@@ -4836,7 +5103,7 @@ void frame_tie (double *pos1, short int direction,
 ------------------------------------------------------------------------
 */
 {
-   static short int compute_matrix = 1;
+   novas_frame_tie_state *cache = &current_context ()->frame_tie;
 
 /*
    'xi0', 'eta0', and 'da0' are ICRS frame biases in arcseconds taken
@@ -4846,7 +5113,6 @@ void frame_tie (double *pos1, short int direction,
    const double xi0  = -0.0166170;
    const double eta0 = -0.0068192;
    const double da0  = -0.01460;
-   static double xx, yx, zx, xy, yy, zy, xz, yz, zz;
 
 /*
    Compute elements of rotation matrix to first order the first time
@@ -4854,27 +5120,30 @@ void frame_tie (double *pos1, short int direction,
    not recomputed.
 */
 
-   if (compute_matrix == 1)
+   if (cache->compute_matrix == 1)
    {
-      xx =  1.0;
-      yx = -da0  * ASEC2RAD;
-      zx =  xi0  * ASEC2RAD;
-      xy =  da0  * ASEC2RAD;
-      yy =  1.0;
-      zy =  eta0 * ASEC2RAD;
-      xz = -xi0  * ASEC2RAD;
-      yz = -eta0 * ASEC2RAD;
-      zz =  1.0;
+      cache->xx =  1.0;
+      cache->yx = -da0  * ASEC2RAD;
+      cache->zx =  xi0  * ASEC2RAD;
+      cache->xy =  da0  * ASEC2RAD;
+      cache->yy =  1.0;
+      cache->zy =  eta0 * ASEC2RAD;
+      cache->xz = -xi0  * ASEC2RAD;
+      cache->yz = -eta0 * ASEC2RAD;
+      cache->zz =  1.0;
 
 /*
    Include second-order corrections to diagonal elements.
 */
 
-      xx = 1.0 - 0.5 * (yx * yx + zx * zx);
-      yy = 1.0 - 0.5 * (yx * yx + zy * zy);
-      zz = 1.0 - 0.5 * (zy * zy + zx * zx);
+      cache->xx = 1.0 - 0.5 * (cache->yx * cache->yx
+         + cache->zx * cache->zx);
+      cache->yy = 1.0 - 0.5 * (cache->yx * cache->yx
+         + cache->zy * cache->zy);
+      cache->zz = 1.0 - 0.5 * (cache->zy * cache->zy
+         + cache->zx * cache->zx);
 
-      compute_matrix = 0;
+      cache->compute_matrix = 0;
    }
 
 /*
@@ -4888,9 +5157,12 @@ void frame_tie (double *pos1, short int direction,
    Perform rotation from dynamical system to ICRS.
 */
 
-      pos2[0] = xx * pos1[0] + yx * pos1[1] + zx * pos1[2];
-      pos2[1] = xy * pos1[0] + yy * pos1[1] + zy * pos1[2];
-      pos2[2] = xz * pos1[0] + yz * pos1[1] + zz * pos1[2];
+      pos2[0] = cache->xx * pos1[0] + cache->yx * pos1[1]
+         + cache->zx * pos1[2];
+      pos2[1] = cache->xy * pos1[0] + cache->yy * pos1[1]
+         + cache->zy * pos1[2];
+      pos2[2] = cache->xz * pos1[0] + cache->yz * pos1[1]
+         + cache->zz * pos1[2];
    }
     else
    {
@@ -4899,9 +5171,12 @@ void frame_tie (double *pos1, short int direction,
    Perform rotation from ICRS to dynamical system.
 */
 
-      pos2[0] = xx * pos1[0] + xy * pos1[1] + xz * pos1[2];
-      pos2[1] = yx * pos1[0] + yy * pos1[1] + yz * pos1[2];
-      pos2[2] = zx * pos1[0] + zy * pos1[1] + zz * pos1[2];
+      pos2[0] = cache->xx * pos1[0] + cache->xy * pos1[1]
+         + cache->xz * pos1[2];
+      pos2[1] = cache->yx * pos1[0] + cache->yy * pos1[1]
+         + cache->yz * pos1[2];
+      pos2[2] = cache->zx * pos1[0] + cache->zy * pos1[1]
+         + cache->zz * pos1[2];
    }
 
    return;
@@ -5129,6 +5404,9 @@ short int geo_posvel (double jd_tt, double delta_t, short int accuracy,
                                is approximated by TT.
       V2.7/02-07/JAB (USNO/AA) Compute 'jd_tdb' corresponding to input
                                'jd_tt'.
+      V2.8/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
 
    NOTES:
@@ -5140,9 +5418,7 @@ short int geo_posvel (double jd_tt, double delta_t, short int accuracy,
 ------------------------------------------------------------------------
 */
 {
-   static double t_last = 0;
-   static double gast, fac;
-   static short int first_time = 1;
+   novas_geo_posvel_state *cache = &current_context ()->geo_posvel;
 
    double x, secdif, gmst, x1, x2, x3, x4, eqeq, pos1[3], vel1[3],
       pos2[3], vel2[3], pos3[3], vel3[3], jd_tdb, jd_ut1;
@@ -5194,19 +5470,19 @@ short int geo_posvel (double jd_tt, double delta_t, short int accuracy,
 */
 
          jd_ut1 = jd_tt - (delta_t / 86400.0);
-         if (fabs (jd_ut1 - t_last) > 1.0e-8 )
+         if (fabs (jd_ut1 - cache->t_last) > 1.0e-8 )
          {
             sidereal_time (jd_ut1,0.0,delta_t,0,1,accuracy, &gmst);
             e_tilt (jd_tdb,accuracy, &x1,&x2,&eqeq,&x3,&x4);
-            gast = gmst + eqeq / 3600.0;
-            t_last = jd_ut1;
+            cache->gast = gmst + eqeq / 3600.0;
+            cache->t_last = jd_ut1;
          }
 
 /*
    Function 'terra' does the hard work, given sidereal time.
 */
 
-         terra (&obs->on_surf,gast, pos1,vel1);
+         terra (&obs->on_surf,cache->gast, pos1,vel1);
          break;
 
 /*
@@ -5219,19 +5495,19 @@ short int geo_posvel (double jd_tt, double delta_t, short int accuracy,
    Convert units to AU and AU/day.
 */
 
-         if (first_time)
+         if (cache->first_time)
          {
-            fac = AU_KM / 86400.0;
-            first_time = 0;
+            cache->fac = AU_KM / 86400.0;
+            cache->first_time = 0;
          }
 
          pos1[0] = obs->near_earth.sc_pos[0] / AU_KM;
          pos1[1] = obs->near_earth.sc_pos[1] / AU_KM;
          pos1[2] = obs->near_earth.sc_pos[2] / AU_KM;
 
-         vel1[0] = obs->near_earth.sc_vel[0] / fac;
-         vel1[1] = obs->near_earth.sc_vel[1] / fac;
-         vel1[2] = obs->near_earth.sc_vel[2] / fac;
+         vel1[0] = obs->near_earth.sc_vel[0] / cache->fac;
+         vel1[1] = obs->near_earth.sc_vel[1] / cache->fac;
+         vel1[2] = obs->near_earth.sc_vel[2] / cache->fac;
          break;
    }
 
@@ -5572,6 +5848,9 @@ short int grav_def (double jd_tdb, short int loc_code,
       V1.2/10-08/JAB (USNO/AA): Substituted calls to 'ephemeris' for
                                 calls to 'solarsystem'; added
                                 actions based on 'accuracy' input.
+      V1.3/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. This function is the C version of NOVAS Fortran routine
@@ -5588,6 +5867,7 @@ short int grav_def (double jd_tdb, short int loc_code,
 ------------------------------------------------------------------------
 */
 {
+   novas_grav_def_state *cache = &current_context ()->grav_def;
 /*
    The following list of body numbers and corresponding names identifies
    which gravitating bodies (aside from the Earth) are potentially
@@ -5601,9 +5881,6 @@ short int grav_def (double jd_tdb, short int loc_code,
 
    const short int body_num[7] = {10, 5, 6, 11, 2, 7, 8};
 
-   static short int first_time = 1;
-   static short int nbodies_last = 0;
-
    short int error = 0;
    short int nbodies, i;
 
@@ -5611,8 +5888,6 @@ short int grav_def (double jd_tdb, short int loc_code,
 
    cat_entry dummy_star;
 
-   static object body[7], earth;
-
    jd[1] = 0.0;
 
 /*
@@ -5648,7 +5923,7 @@ short int grav_def (double jd_tdb, short int loc_code,
    information.
 */
 
-   if ((first_time == 1) || (nbodies != nbodies_last))
+   if ((cache->first_time == 1) || (nbodies != cache->nbodies_last))
    {
       for (i = 0; i < nbodies; i++)
       {
@@ -5657,17 +5932,17 @@ short int grav_def (double jd_tdb, short int loc_code,
             make_cat_entry ("dummy","   ",0,0.0,0.0,0.0,0.0,0.0,0.0,
                &dummy_star);
 
-            make_object (0,3,"Earth",&dummy_star, &earth);
+            make_object (0,3,"Earth",&dummy_star, &cache->earth);
          }
 
          if ((error = make_object (0,body_num[i],body_name[i],
-            &dummy_star, &body[i])) != 0)
+            &dummy_star, &cache->body[i])) != 0)
          {
             return (error += 30);
          }
       }
-      first_time = 0;
-      nbodies_last = nbodies;
+      cache->first_time = 0;
+      cache->nbodies_last = nbodies;
    }
 
 /*
@@ -5684,14 +5959,13 @@ short int grav_def (double jd_tdb, short int loc_code,
    for (i = 0; i < nbodies; i++)
    {
 
-
 /*
    Get position of gravitating body wrt ss barycenter at time 'jd_tdb'.
 */
 
       jd[0] = jd_tdb;
-      if ((error = ephemeris (jd,&body[i],0,accuracy, pbody,vbody))
-         != 0)
+      if ((error = ephemeris (jd,&cache->body[i],0,accuracy,
+         pbody,vbody)) != 0)
       {
          return (error);
       }
@@ -5723,8 +5997,8 @@ short int grav_def (double jd_tdb, short int loc_code,
          tclose = jd_tdb - tlt;
 
       jd[0] = tclose;
-      if ((error = ephemeris (jd,&body[i],0,accuracy, pbody,vbody))
-         != 0)
+      if ((error = ephemeris (jd,&cache->body[i],0,accuracy,
+         pbody,vbody)) != 0)
       {
          return (error);
       }
@@ -5748,7 +6022,7 @@ short int grav_def (double jd_tdb, short int loc_code,
 */
 
       jd[0] = jd_tdb;
-      if ((error = ephemeris (jd,&earth,0,accuracy, pbody,vbody))
+      if ((error = ephemeris (jd,&cache->earth,0,accuracy, pbody,vbody))
          != 0)
       {
          return (error);
@@ -6075,6 +6349,8 @@ void rad_vel (object *cel_object, double *pos, double *vel,
    PROGRAMMER:
       V1.0/09-06/JAB (USNO/AA)
       V2.0/01-07/JAB (USNO/AA): Implement new algorithm
+      V2.1/10-26 (planetaria)  Constants computed on each call instead
+                               of kept in static variables.
 
    NOTES:
       1. All the input arguments are BCRS quantities, expressed
@@ -6101,25 +6377,18 @@ void rad_vel (object *cel_object, double *pos, double *vel,
 ------------------------------------------------------------------------
 */
 {
-   static short int first_call = 1;
    short int i;
 
-   static double c2, toms, toms2;
    double v[3], ra, dec, radvel, posmag, uk[3], v2, vo2, r, phigeo,
       phisun, rel, rar, dcr, cosdec, du[3], zc, kv, zb1, kvobs, zobs1;
 
 /*
-   Set up local constants the first time this function is called.
+   Set up local constants.
 */
 
-   if (first_call)
-   {
-      c2 = C * C;
-      toms = AU / 86400.0;
-      toms2 = toms * toms;
-
-      first_call = 0;
-   }
+   const double c2 = C * C;
+   const double toms = AU / 86400.0;
+   const double toms2 = toms * toms;
 
 /*
    Initialize variables needed for radial velocity calculation.
@@ -6375,6 +6644,9 @@ short int precession (double jd_tdb1, double *pos1, double jd_tdb2,
       V2.3/03-10/JAB (USNO/AA) Implement 'first-time' to fix bug when
                                 'jd_tdb2' is 'T0' on first call to
                                 function.
+      V2.4/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. Either 'jd_tdb1' or 'jd_tdb2' must be 2451545.0 (J2000.0) TDB.
@@ -6384,11 +6656,9 @@ short int precession (double jd_tdb1, double *pos1, double jd_tdb2,
 ------------------------------------------------------------------------
 */
 {
-   static short int first_time = 1;
+   novas_precession_state *cache = &current_context ()->precession;
    short int error = 0;
 
-   static double t_last = 0.0;
-   static double xx, yx, zx, xy, yy, zy, xz, yz, zz;
    double eps0 = 84381.406;
    double  t, psia, omegaa, chia, sa, ca, sb, cb, sc, cc, sd, cd;
 
@@ -6408,7 +6678,8 @@ short int precession (double jd_tdb1, double *pos1, double jd_tdb2,
    if (jd_tdb2 == T0)
       t = -t;
 
-   if ((fabs (t - t_last) >= 1.0e-15) || (first_time == 1))
+   if ((fabs (t - cache->t_last) >= 1.0e-15)
+      || (cache->first_time == 1))
    {
 
 /*
@@ -6453,18 +6724,18 @@ short int precession (double jd_tdb1, double *pos1, double jd_tdb2,
    R3(chi_a) R1(-omega_a) R3(-psi_a) R1(epsilon_0).
 */
 
-      xx =  cd * cb - sb * sd * cc;
-      yx =  cd * sb * ca + sd * cc * cb * ca - sa * sd * sc;
-      zx =  cd * sb * sa + sd * cc * cb * sa + ca * sd * sc;
-      xy = -sd * cb - sb * cd * cc;
-      yy = -sd * sb * ca + cd * cc * cb * ca - sa * cd * sc;
-      zy = -sd * sb * sa + cd * cc * cb * sa + ca * cd * sc;
-      xz =  sb * sc;
-      yz = -sc * cb * ca - sa * cc;
-      zz = -sc * cb * sa + cc * ca;
+      cache->xx =  cd * cb - sb * sd * cc;
+      cache->yx =  cd * sb * ca + sd * cc * cb * ca - sa * sd * sc;
+      cache->zx =  cd * sb * sa + sd * cc * cb * sa + ca * sd * sc;
+      cache->xy = -sd * cb - sb * cd * cc;
+      cache->yy = -sd * sb * ca + cd * cc * cb * ca - sa * cd * sc;
+      cache->zy = -sd * sb * sa + cd * cc * cb * sa + ca * cd * sc;
+      cache->xz =  sb * sc;
+      cache->yz = -sc * cb * ca - sa * cc;
+      cache->zz = -sc * cb * sa + cc * ca;
 
-      t_last = t;
-      first_time = 0;
+      cache->t_last = t;
+      cache->first_time = 0;
    }
 
    if (jd_tdb2 == T0)
@@ -6473,9 +6744,12 @@ short int precession (double jd_tdb1, double *pos1, double jd_tdb2,
 /*
    Perform rotation from epoch to J2000.0.
 */
-      pos2[0] = xx * pos1[0] + xy * pos1[1] + xz * pos1[2];
-      pos2[1] = yx * pos1[0] + yy * pos1[1] + yz * pos1[2];
-      pos2[2] = zx * pos1[0] + zy * pos1[1] + zz * pos1[2];
+      pos2[0] = cache->xx * pos1[0] + cache->xy * pos1[1]
+         + cache->xz * pos1[2];
+      pos2[1] = cache->yx * pos1[0] + cache->yy * pos1[1]
+         + cache->yz * pos1[2];
+      pos2[2] = cache->zx * pos1[0] + cache->zy * pos1[1]
+         + cache->zz * pos1[2];
    }
     else
    {
@@ -6484,9 +6758,12 @@ short int precession (double jd_tdb1, double *pos1, double jd_tdb2,
    Perform rotation from J2000.0 to epoch.
 */
 
-      pos2[0] = xx * pos1[0] + yx * pos1[1] + zx * pos1[2];
-      pos2[1] = xy * pos1[0] + yy * pos1[1] + zy * pos1[2];
-      pos2[2] = xz * pos1[0] + yz * pos1[1] + zz * pos1[2];
+      pos2[0] = cache->xx * pos1[0] + cache->yx * pos1[1]
+         + cache->zx * pos1[2];
+      pos2[1] = cache->xy * pos1[0] + cache->yy * pos1[1]
+         + cache->zy * pos1[2];
+      pos2[2] = cache->xz * pos1[0] + cache->yz * pos1[1]
+         + cache->zz * pos1[2];
    }
 
    return (error = 0);
@@ -7440,6 +7717,9 @@ short int cio_location (double jd_tdb, short int accuracy,
    VER./DATE/
    PROGRAMMER:
       V1.0/07-06/JAB (USNO/AA)
+      V1.1/10-26 (planetaria)  Saved values, and the 'cio' array, kept
+                               in the bound 'novas_context' instead of
+                               static variables.
 
    NOTES:
       1. If an external file of CIO right ascensions is available,
@@ -7455,37 +7735,31 @@ short int cio_location (double jd_tdb, short int accuracy,
 ------------------------------------------------------------------------
 */
 {
-   static short int first_call = 1;
-   static short int ref_sys_last = 0;
-   static short int use_file = 0;
+   novas_cio_location_state *cache = &current_context ()->cio_location;
    short int error = 0;
 
    long int n_pts = 6;
    long int i, j;
 
-   static double t_last = 0.0;
-   static double ra_last;
    double p, eq_origins;
 
-   size_t cio_size;
+   ra_of_cio *cio = cache->cio;
 
-   static ra_of_cio *cio;
-
-   static FILE *cio_file;
+   FILE *cio_file;
 
 /*
    Check if the input external binary file exists and can be read.
 */
 
-   if (first_call)
+   if (cache->first_call)
    {
       if ((cio_file = fopen ("cio_ra.bin", "rb")) == NULL)
       {
-         use_file = 0;
+         cache->use_file = 0;
       }
        else
       {
-         use_file = 1;
+         cache->use_file = 1;
          fclose (cio_file);
       }
    }
@@ -7494,10 +7768,10 @@ short int cio_location (double jd_tdb, short int accuracy,
    Check if previously computed RA value can be used.
 */
 
-   if ((fabs (jd_tdb - t_last) <= 1.0e-8))
+   if ((fabs (jd_tdb - cache->t_last) <= 1.0e-8))
    {
-      *ra_cio = ra_last;
-      *ref_sys = ref_sys_last;
+      *ra_cio = cache->ra_last;
+      *ref_sys = cache->ref_sys_last;
       return (error = 0);
    }
 
@@ -7505,7 +7779,7 @@ short int cio_location (double jd_tdb, short int accuracy,
    Compute the RA of the CIO.
 */
 
-   switch (use_file)
+   switch (cache->use_file)
    {
 
 /*
@@ -7517,19 +7791,12 @@ short int cio_location (double jd_tdb, short int accuracy,
       case 1:
 
 /*
-   Allocate memory for the array 'cio'.  This array contains the values
-   to be interpolated, extracted from the CIO file.
+   The array 'cio' (kept in the context) contains the values to be
+   interpolated, extracted from the CIO file.
 */
 
-         if (first_call)
-         {
-            cio_size = sizeof (ra_of_cio);
-            cio = (ra_of_cio *) calloc ((size_t) n_pts, cio_size);
-            if (cio == NULL)
-               return (error = 1);
-             else
-               first_call = 0;
-         }
+         if (cache->first_call)
+            cache->first_call = 0;
 
 /*
    Get array of values to interpolate.
@@ -7575,8 +7842,8 @@ short int cio_location (double jd_tdb, short int accuracy,
    Compute equation of the origins.
 */
 
-         if (first_call)
-            first_call = 0;
+         if (cache->first_call)
+            cache->first_call = 0;
 
          eq_origins = ira_equinox (jd_tdb,1,accuracy);
 
@@ -7586,9 +7853,9 @@ short int cio_location (double jd_tdb, short int accuracy,
          break;
    }
 
-   t_last = jd_tdb;
-   ra_last = *ra_cio;
-   ref_sys_last = *ref_sys;
+   cache->t_last = jd_tdb;
+   cache->ra_last = *ra_cio;
+   cache->ref_sys_last = *ref_sys;
 
    return (error);
 }
@@ -7672,6 +7939,9 @@ short int cio_basis (double jd_tdb, double ra_cio, short int ref_sys,
       V1.3/06-08/WKP (USNO/AA) Changed value of direction argument in
                                calls to 'nutation' from 1 to -1 for
                                consistency.
+      V1.4/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. This function effectively constructs the matrix C in eq. (3)
@@ -7682,12 +7952,12 @@ short int cio_basis (double jd_tdb, double ra_cio, short int ref_sys,
 ------------------------------------------------------------------------
 */
 {
-   static short int ref_sys_last = 0;
+   novas_cio_basis_state *cache = &current_context ()->cio_basis;
    short int error = 0;
    short int i;
 
-   static double t_last = 0.0;
-   static double xx[3], yy[3], zz[3];
+   double *xx = cache->xx, *yy = cache->yy, *zz = cache->zz;
+
    double z0[3] = {0.0, 0.0, 1.0};
    double w0[3], w1[3], w2[3], sinra, cosra, xmag;
 
@@ -7695,14 +7965,15 @@ short int cio_basis (double jd_tdb, double ra_cio, short int ref_sys,
    Compute unit vector z toward celestial pole.
 */
 
-   if (((fabs (jd_tdb - t_last) > 1.0e-8)) || (ref_sys != ref_sys_last))
+   if (((fabs (jd_tdb - cache->t_last) > 1.0e-8))
+      || (ref_sys != cache->ref_sys_last))
    {
       nutation (jd_tdb,-1,accuracy,z0, w1);
       precession (jd_tdb,w1,T0, w2);
       frame_tie (w2,-1, zz);
 
-      t_last = jd_tdb;
-      ref_sys_last = ref_sys;
+      cache->t_last = jd_tdb;
+      cache->ref_sys_last = ref_sys;
    }
     else
    {
@@ -7896,6 +8167,9 @@ short int cio_array (double jd_tdb, long int n_pts,
                                'ra_of_cio' to avoid conflicts.
       V1.2/02-08/JAB (USNO/AA) Fix file-read strategy "Case 2" and
                                improve documentation.
+      V1.3/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. This function assumes that binary, random-access file
@@ -7907,58 +8181,55 @@ short int cio_array (double jd_tdb, long int n_pts,
 ------------------------------------------------------------------------
 */
 {
-   static short int first_call = 1;
+   novas_cio_array_state *cache = &current_context ()->cio_array;
    short int error = 0;
 
-   static long int last_index_rec = -50L;
-   static long int last_n_pts = 0L;
-   static long int header_size, record_size, n_recs;
    long int min_pts = 2;
    long int max_pts = 20;
    long int  del_n_pts, index_rec, half_int, lo_limit, hi_limit,
       del_index, abs_del_index, bytes_to_lo, n_swap, n_read, i, j;
 
-   static double jd_beg, jd_end, t_int, *t, *ra;
    double t_temp, ra_temp;
 
-   static size_t double_size, long_size;
-
-   static FILE *cio_file;
-
 /*
    Set the sizes of the file header and data records, open the CIO file,
    and read the file header on the first call to this function.
 */
 
-   if (first_call)
+   if (cache->first_call)
    {
-      double_size = sizeof (double);
-      long_size = sizeof (long int);
-      header_size = (long) ((size_t) 3 * double_size + long_size);
-      record_size = (long) ((size_t) 2 * double_size);
+      cache->double_size = sizeof (double);
+      cache->long_size = sizeof (long int);
+      cache->header_size = (long) ((size_t) 3 * cache->double_size
+         + cache->long_size);
+      cache->record_size = (long) ((size_t) 2 * cache->double_size);
 
 /*
    Open the input (binary, random-access) file.
 */
 
-      if ((cio_file = fopen ("cio_ra.bin", "rb")) == NULL)
+      if ((cache->cio_file = fopen ("cio_ra.bin", "rb")) == NULL)
          return (error = 1);
 
 /*
    Read the file header.
 */
 
-      fread (&jd_beg, double_size, (size_t) 1, cio_file);
-      fread (&jd_end, double_size, (size_t) 1, cio_file);
-      fread (&t_int, double_size, (size_t) 1, cio_file);
-      fread (&n_recs, long_size, (size_t) 1, cio_file);
+      fread (&cache->jd_beg, cache->double_size, (size_t) 1,
+         cache->cio_file);
+      fread (&cache->jd_end, cache->double_size, (size_t) 1,
+         cache->cio_file);
+      fread (&cache->t_int, cache->double_size, (size_t) 1,
+         cache->cio_file);
+      fread (&cache->n_recs, cache->long_size, (size_t) 1,
+         cache->cio_file);
    }
 
 /*
    Check the input data against limits.
 */
 
-   if ((jd_tdb < jd_beg) || (jd_tdb > jd_end))
+   if ((jd_tdb < cache->jd_beg) || (jd_tdb > cache->jd_end))
       return (error = 2);
 
    if ((n_pts < min_pts) || (n_pts > max_pts))
@@ -7969,7 +8240,7 @@ short int cio_array (double jd_tdb, long int n_pts,
    the last value of 'n_pts'.
 */
 
-   del_n_pts = abs (n_pts - last_n_pts);
+   del_n_pts = abs (n_pts - cache->last_n_pts);
 
 /*
    Allocate memory for the 't' and 'ra' arrays.
@@ -7977,28 +8248,29 @@ short int cio_array (double jd_tdb, long int n_pts,
 
    if (del_n_pts != 0L)
    {
-      if (!first_call)
+      if (!cache->first_call)
       {
-         free (t);
-         free (ra);
+         free (cache->t);
+         free (cache->ra);
       }
 
-      t = (double *) calloc ((size_t) n_pts, double_size);
-      if (t == NULL )
+      cache->t = (double *) calloc ((size_t) n_pts, cache->double_size);
+      if (cache->t == NULL )
       {
-         fclose (cio_file);
+         fclose (cache->cio_file);
          return (error = 4);
       }
 
-      ra = (double *) calloc ((size_t) n_pts, double_size);
-      if (ra == NULL )
+      cache->ra = (double *) calloc ((size_t) n_pts,
+         cache->double_size);
+      if (cache->ra == NULL )
       {
-         free (t);
-         fclose (cio_file);
+         free (cache->t);
+         fclose (cache->cio_file);
          return (error = 5);
       }
 
-      first_call = 0;
+      cache->first_call = 0;
    }
 
 /*
@@ -8006,7 +8278,8 @@ short int cio_array (double jd_tdb, long int n_pts,
    the date of interest: the "index record".
 */
 
-   index_rec = (long int) ((jd_tdb - jd_beg) / t_int) + 1L;
+   index_rec = (long int) ((jd_tdb - cache->jd_beg) / cache->t_int) +
+      1L;
 
 /*
    Test the range of 'n_pts' values centered on 'index_rec' to be sure
@@ -8017,7 +8290,7 @@ short int cio_array (double jd_tdb, long int n_pts,
    lo_limit = index_rec - half_int;
    hi_limit = index_rec + (n_pts - half_int - 1L);
 
-   if ((lo_limit < 1L) || (hi_limit > n_recs))
+   if ((lo_limit < 1L) || (hi_limit > cache->n_recs))
       return (error = 6);
 
 /*
@@ -8025,13 +8298,14 @@ short int cio_array (double jd_tdb, long int n_pts,
    the 'lo_limit'.
 */
 
-   bytes_to_lo = header_size + (lo_limit - 1L) * record_size;
+   bytes_to_lo = cache->header_size +
+      (lo_limit - 1L) * cache->record_size;
 
 /*
    Compare the current index record with the previous index record.
 */
 
-   del_index = index_rec - last_index_rec;
+   del_index = index_rec - cache->last_index_rec;
    abs_del_index = abs (del_index);
 
 /*
@@ -8046,12 +8320,14 @@ short int cio_array (double jd_tdb, long int n_pts,
 
    if ((abs_del_index > n_pts) || (del_n_pts != 0))
    {
-      fseek (cio_file, bytes_to_lo, SEEK_SET);
+      fseek (cache->cio_file, bytes_to_lo, SEEK_SET);
 
       for (i = 0L; i < n_pts; i++)
       {
-         fread (&t[i], double_size, (size_t) 1, cio_file);
-         fread (&ra[i], double_size, (size_t) 1, cio_file);
+         fread (&cache->t[i], cache->double_size, (size_t) 1,
+            cache->cio_file);
+         fread (&cache->ra[i], cache->double_size, (size_t) 1,
+            cache->cio_file);
       }
    }
 
@@ -8082,20 +8358,22 @@ short int cio_array (double jd_tdb, long int n_pts,
       {
          for (i = 0L; i < n_swap; i++)
          {
-            t_temp = t[i];
-            ra_temp = ra[i];
+            t_temp = cache->t[i];
+            ra_temp = cache->ra[i];
 
             j = i + abs_del_index;
-            t[j] = t_temp;
-            ra[j] = ra_temp;
+            cache->t[j] = t_temp;
+            cache->ra[j] = ra_temp;
          }
 
-         fseek (cio_file, bytes_to_lo, SEEK_SET);
+         fseek (cache->cio_file, bytes_to_lo, SEEK_SET);
 
          for (i = 0L; i < n_read; i++)
          {
-            fread (&t[i], double_size, (size_t) 1, cio_file);
-            fread (&ra[i], double_size, (size_t) 1, cio_file);
+            fread (&cache->t[i], cache->double_size, (size_t) 1,
+               cache->cio_file);
+            fread (&cache->ra[i], cache->double_size, (size_t) 1,
+               cache->cio_file);
          }
       }
 
@@ -8110,21 +8388,23 @@ short int cio_array (double jd_tdb, long int n_pts,
          for (i = 0L; i < n_swap; i++)
          {
             j = i + abs_del_index;
-            t_temp = t[j];
-            ra_temp = ra[j];
+            t_temp = cache->t[j];
+            ra_temp = cache->ra[j];
 
-            t[i] = t_temp;
-            ra[i] = ra_temp;
+            cache->t[i] = t_temp;
+            cache->ra[i] = ra_temp;
          }
 
-         fseek (cio_file, bytes_to_lo + (n_swap * record_size),
-            SEEK_SET);
+         fseek (cache->cio_file,
+            bytes_to_lo + (n_swap * cache->record_size), SEEK_SET);
 
          j = i++;
          for (i = j; i < n_pts; i++)
          {
-            fread (&t[i], double_size, (size_t) 1, cio_file);
-            fread (&ra[i], double_size, (size_t) 1, cio_file);
+            fread (&cache->t[i], cache->double_size, (size_t) 1,
+               cache->cio_file);
+            fread (&cache->ra[i], cache->double_size, (size_t) 1,
+               cache->cio_file);
          }
       }
    }
@@ -8141,16 +8421,16 @@ short int cio_array (double jd_tdb, long int n_pts,
 
    for (i = 0L; i < n_pts; i++)
    {
-      cio[i].jd_tdb = t[i];
-      cio[i].ra_cio = ra[i];
+      cio[i].jd_tdb = cache->t[i];
+      cio[i].ra_cio = cache->ra[i];
    }
 
 /*
    Set values of 'last_index_rec' and 'last_n_pts'.
 */
 
-   last_index_rec = index_rec;
-   last_n_pts = n_pts;
+   cache->last_index_rec = index_rec;
+   cache->last_n_pts = n_pts;
 
    return (error);
 }
@@ -8208,6 +8488,9 @@ double ira_equinox (double jd_tdb, short int equinox,
    VER./DATE/
    PROGRAMMER:
       V1.0/07-06/JAB (USNO/AA)
+      V1.1/10-26 (planetaria)  Saved values kept in the bound
+                               'novas_context' instead of static
+                               variables.
 
    NOTES:
       1. This function is the C version of NOVAS Fortran routine
@@ -8216,10 +8499,8 @@ double ira_equinox (double jd_tdb, short int equinox,
 ------------------------------------------------------------------------
 */
 {
-   static short int acc_last = 99;
+   novas_ira_equinox_state *cache = &current_context ()->ira_equinox;
 
-   static double t_last = 0.0;
-   static double eq_eq = 0.0;
    double t, u, v, w, x, prec_ra, ra_eq;
 
 /*
@@ -8235,16 +8516,17 @@ double ira_equinox (double jd_tdb, short int equinox,
 
    if (equinox == 1)
    {
-      if (((fabs (jd_tdb - t_last)) > 1.0e-8) || (accuracy != acc_last))
+      if (((fabs (jd_tdb - cache->t_last)) > 1.0e-8)
+         || (accuracy != cache->acc_last))
       {
-         e_tilt (jd_tdb,accuracy, &u, &v, &eq_eq, &w, &x);
-         t_last = jd_tdb;
-         acc_last = accuracy;
+         e_tilt (jd_tdb,accuracy, &u, &v, &cache->eq_eq, &w, &x);
+         cache->t_last = jd_tdb;
+         cache->acc_last = accuracy;
       }
    }
     else
    {
-      eq_eq = 0.0;
+      cache->eq_eq = 0.0;
    }
 
 /*
@@ -8258,7 +8540,7 @@ double ira_equinox (double jd_tdb, short int equinox,
            +    1.3915817    ) * t
            + 4612.156534     ) * t;
 
-   ra_eq = - (prec_ra / 15.0 + eq_eq) / 3600.0;
+   ra_eq = - (prec_ra / 15.0 + cache->eq_eq) / 3600.0;
 
    return (ra_eq);
 }
@@ -9004,6 +9286,8 @@ void limb_angle (double pos_obj[3], double pos_obs[3],
    VER./DATE/
    PROGRAMMER:
       V1.0/09-04/JAB (USNO/AA)
+      V1.1/10-26 (planetaria)  Constants computed on each call instead
+                               of kept in static variables.
 
    NOTES:
       1.This function is the C version of NOVAS Fortran routine
@@ -9012,19 +9296,12 @@ void limb_angle (double pos_obj[3], double pos_obs[3],
 ------------------------------------------------------------------------
 */
 {
-   static short int first_entry = 1;
+   const double pi = TWOPI / 2.0;
+   const double halfpi = pi / 2.0;
+   const double rade = ERAD / AU;
 
-   static double pi, halfpi, rade;
    double disobj, disobs, aprad, zdlim, coszd, zdobj;
 
-   if (first_entry)
-   {
-      pi = TWOPI / 2.0;
-      halfpi = pi / 2.0;
-      rade = ERAD / AU;
-      first_entry = 0;
-   }
-
 /*
    Compute the distance to the object and the distance to the observer.
 */
@@ -10147,3 +10424,275 @@ void make_in_space (double sc_pos[3], double sc_vel[3],
    obs_space->sc_vel[1] = sc_vel[1];
    obs_space->sc_vel[2] = sc_vel[2];
 }
+
+/********novas_context_init */
+
+void novas_context_init (novas_context *context)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Prepares a context to hold the values NOVAS functions keep between
+      calls, as if none of them had been called yet.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      *context (struct novas_context)
+         Context to prepare (defined in novas.h).
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      memset             string.h
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The initial values are those the static variables of the
+      functions had before this context was introduced.
+      2. A context that has been used must be released with
+      'novas_context_free', not prepared again.
+
+------------------------------------------------------------------------
+*/
+{
+   memset (context, 0, sizeof (novas_context));
+
+   context->place.first_time = 1;
+   context->sidereal_time.jd_last = -99.0;
+   context->spin.ang_last = -999.0;
+   context->frame_tie.compute_matrix = 1;
+   context->geo_posvel.first_time = 1;
+   context->grav_def.first_time = 1;
+   context->precession.first_time = 1;
+   context->cio_location.first_call = 1;
+   context->cio_array.first_call = 1;
+   context->cio_array.last_index_rec = -50L;
+   context->ira_equinox.acc_last = 99;
+
+   context->initialized = 1;
+
+   return;
+}
+
+/********novas_context_bind */
+
+novas_context *novas_context_bind (novas_context *context)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Makes 'context' the one in which NOVAS functions called on the
+      calling thread keep their values between calls.  Other threads
+      are not affected.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *context (struct novas_context)
+         Context to bind, prepared with 'novas_context_init', or NULL
+         to return to the default context.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      (struct novas_context *)
+         The context previously bound on this thread (NULL for the
+         default context), so that callers can restore it.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. Binding an ephemeris reader with 'ephem_reader_bind' as well
+      makes every NOVAS call on the thread independent of other
+      threads.
+
+------------------------------------------------------------------------
+*/
+{
+   novas_context *previous = BOUND_CONTEXT;
+
+   BOUND_CONTEXT = context;
+   return previous;
+}
+
+/********novas_context_free */
+
+void novas_context_free (novas_context *context)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Releases the memory and file a context holds (those of
+      'cio_array'), and prepares it again as 'novas_context_init'
+      does.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      *context (struct novas_context)
+         Context to release; it must not be bound on any thread.
+
+   OUTPUT
+   ARGUMENTS:
+      None.
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      free               stdlib.h
+      fclose             stdio.h
+      novas_context_init novas.c
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      None.
+
+------------------------------------------------------------------------
+*/
+{
+   if (context->initialized && !context->cio_array.first_call)
+   {
+      free (context->cio_array.t);
+      free (context->cio_array.ra);
+   }
+
+   if (context->cio_array.cio_file != NULL)
+      fclose (context->cio_array.cio_file);
+
+   novas_context_init (context);
+
+   return;
+}
+
+/********novas_context_reset */
+
+void novas_context_reset (novas_context *context)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Forgets the values a context saved for the date of the last call
+      of each NOVAS function, so that the next call computes them for
+      its own date, as the first call in the context would.  Values
+      that do not depend on the date (the frame-tie matrix, the objects
+      'place' and 'grav_def' make, the obliquity of J2000.0, the open
+      CIO file and the records read from it) are kept.
+
+   REFERENCES:
+      None.
+
+   INPUT
+   ARGUMENTS:
+      None.
+
+   OUTPUT
+   ARGUMENTS:
+      *context (struct novas_context)
+         Context to reset, prepared with 'novas_context_init'; it may
+         be bound on the calling thread.
+
+   RETURNED
+   VALUE:
+      None.
+
+   GLOBALS
+   USED:
+      None.
+
+   FUNCTIONS
+   CALLED:
+      None.
+
+   VER./DATE/
+   PROGRAMMER:
+      V1.0/10-26 (planetaria)
+
+   NOTES:
+      1. The values set are those 'novas_context_init' sets, none of
+      which matches a date a function is called for.
+
+------------------------------------------------------------------------
+*/
+{
+   context->place.tlast1 = 0.0;
+   context->place.tlast2 = 0.0;
+   context->equ2ecl.t_last = 0.0;
+   context->ecl2equ.t_last = 0.0;
+   context->sidereal_time.jd_last = -99.0;
+   context->spin.ang_last = -999.0;
+   context->e_tilt.jd_last = 0.0;
+   context->geo_posvel.t_last = 0.0;
+   context->precession.first_time = 1;
+   context->cio_location.t_last = 0.0;
+   context->cio_basis.t_last = 0.0;
+   context->ira_equinox.t_last = 0.0;
+   context->ira_equinox.acc_last = 99;
+
+   return;
+}
+
+/********current_context */
+
+static novas_context *current_context (void)
+/*
+------------------------------------------------------------------------
+
+   PURPOSE:
+      Returns the context bound on the calling thread, or the default
+      context, preparing the default context on first use.
+
+------------------------------------------------------------------------
+*/
+{
+   if (BOUND_CONTEXT)
+      return BOUND_CONTEXT;
+
+   if (!DEFAULT_CONTEXT.initialized)
+      novas_context_init (&DEFAULT_CONTEXT);
+
+   return &DEFAULT_CONTEXT;
+}
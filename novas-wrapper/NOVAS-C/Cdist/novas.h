@@ -218,6 +218,188 @@
       double ra_cio;
    } ra_of_cio;
 
+/*
+   struct place_epoch:  terms of 'place' common to every object observed
+                        at one time from one location
+
+   jd_tdb             = TDB Julian date of the terms
+   peb, veb           = barycentric position and velocity of the Earth
+   psb, vsb           = barycentric position and velocity of the Sun
+   pog, vog           = geocentric position and velocity of the observer
+   pob, vob           = barycentric position and velocity of the
+                        observer
+   loc                = 0 ... observer at the geocenter
+                      = 1 ... observer elsewhere
+*/
+
+   typedef struct
+   {
+      double jd_tdb;
+      double peb[3];
+      double veb[3];
+      double psb[3];
+      double vsb[3];
+      double pog[3];
+      double vog[3];
+      double pob[3];
+      double vob[3];
+      short int loc;
+   } place_epoch;
+
+/*
+   Values NOVAS functions keep from one call to the next, so that a
+   repeated date (or accuracy, or number of bodies) skips the work of
+   the last call.  Each structure below holds the saved values of the
+   function it is named after; 'novas_context' collects them all.
+*/
+
+   typedef struct
+   {
+      short int first_time;
+      double tlast1;
+      place_epoch epoch;
+      object earth;
+      object sun;
+      double tlast2;
+      double px[3];
+      double py[3];
+      double pz[3];
+   } novas_place_state;
+
+   typedef struct
+   {
+      double t_last;
+      double ob2000;
+      double oblm;
+      double oblt;
+   } novas_obliquity_state;
+
+   typedef struct
+   {
+      double ee;
+      double jd_last;
+   } novas_sidereal_time_state;
+
+   typedef struct
+   {
+      double ang_last;
+      double xx, yx, zx, xy, yy, zy, xz, yz, zz;
+   } novas_spin_state;
+
+   typedef struct
+   {
+      short int accuracy_last;
+      double jd_last;
+      double dp;
+      double de;
+      double c_terms;
+   } novas_e_tilt_state;
+
+   typedef struct
+   {
+      short int compute_matrix;
+      double xx, yx, zx, xy, yy, zy, xz, yz, zz;
+   } novas_frame_tie_state;
+
+   typedef struct
+   {
+      double t_last;
+      double gast;
+      double fac;
+      short int first_time;
+   } novas_geo_posvel_state;
+
+   typedef struct
+   {
+      short int first_time;
+      short int nbodies_last;
+      object body[7];
+      object earth;
+   } novas_grav_def_state;
+
+   typedef struct
+   {
+      short int first_time;
+      double t_last;
+      double xx, yx, zx, xy, yy, zy, xz, yz, zz;
+   } novas_precession_state;
+
+   typedef struct
+   {
+      short int first_call;
+      short int ref_sys_last;
+      short int use_file;
+      double t_last;
+      double ra_last;
+      ra_of_cio cio[6];
+   } novas_cio_location_state;
+
+   typedef struct
+   {
+      short int ref_sys_last;
+      double t_last;
+      double xx[3];
+      double yy[3];
+      double zz[3];
+   } novas_cio_basis_state;
+
+   typedef struct
+   {
+      short int first_call;
+      long int last_index_rec;
+      long int last_n_pts;
+      long int header_size;
+      long int record_size;
+      long int n_recs;
+      double jd_beg;
+      double jd_end;
+      double t_int;
+      double *t;
+      double *ra;
+      size_t double_size;
+      size_t long_size;
+      FILE *cio_file;
+   } novas_cio_array_state;
+
+   typedef struct
+   {
+      short int acc_last;
+      double t_last;
+      double eq_eq;
+   } novas_ira_equinox_state;
+
+/*
+   struct novas_context:  everything the NOVAS functions keep between
+                          calls
+
+   A thread that computes with NOVAS while another thread does too must
+   bind a context of its own with 'novas_context_bind'; threads that
+   bind none share one default context.  Members 'equ2ecl' and
+   'ecl2equ' hold the obliquities of 'equ2ecl_vec' and 'ecl2equ_vec'.
+
+   The celestial pole offsets set by 'cel_pole' are configuration, not
+   saved values, and stay common to every context.
+*/
+
+   typedef struct novas_context
+   {
+      short int initialized;
+      novas_place_state place;
+      novas_obliquity_state equ2ecl;
+      novas_obliquity_state ecl2equ;
+      novas_sidereal_time_state sidereal_time;
+      novas_spin_state spin;
+      novas_e_tilt_state e_tilt;
+      novas_frame_tie_state frame_tie;
+      novas_geo_posvel_state geo_posvel;
+      novas_grav_def_state grav_def;
+      novas_precession_state precession;
+      novas_cio_location_state cio_location;
+      novas_cio_basis_state cio_basis;
+      novas_cio_array_state cio_array;
+      novas_ira_equinox_state ira_equinox;
+   } novas_context;
+
 
 /*
    Define "origin" constants.
@@ -296,6 +478,13 @@
 
                     sky_pos *output);
 
+   short int place_bodies (double jd_tt, short int n,
+                           object *cel_objects, observer *location,
+                           double delta_t, short int coord_sys,
+                           short int accuracy,
+
+                           sky_pos *output);
+
    void equ2gal (double rai, double deci,
 
                  double *glon, double *glat);
@@ -547,5 +736,13 @@
 
                        in_space *obs_space);
 
+   void novas_context_init (novas_context *context);
+
+   novas_context *novas_context_bind (novas_context *context);
+
+   void novas_context_free (novas_context *context);
+
+   void novas_context_reset (novas_context *context);
+
 
 #endif
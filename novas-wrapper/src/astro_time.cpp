@@ -10,6 +10,8 @@
 #include <ctime>
 #include <cmath>
 #include <cerrno>
+#include <limits>
+#include <memory>
 
 #include "astro_time.h"
 
@@ -95,13 +97,39 @@ double leapsec_tai_utc (double jd_utc)
 	return 0;
 }
 
+static_assert (sizeof (astro_time) <= 64, "astro_time should fit in a cache line");
+
+// load_finals: keeps the UT1-UTC and polar motion of the finals data for 'jd' (UTC).
+void astro_time::load_finals (double jd)
+{
+	finals_data fd = finals_data_handler::instance ().finals_data_for_time (jd);
+	ut1_utc = fd.ut1_utc;
+	pm_x = fd.pm_x;
+	pm_y = fd.pm_y;
+	known |= has_finals;
+}
+
+double astro_time::finals_ut1_utc ()
+{
+	if (!(known & has_finals))
+	{
+		load_finals (julian_utc);
+	}
+	return ut1_utc;
+}
+
 finals_data astro_time::get_finals_data ()
 {
-	if (std::isnan (cached_finals_data.julian_utc))
+	return finals_data_handler::instance ().finals_data_for_time (julian_utc);
+}
+
+std::pair<double, double> astro_time::polar_motion ()
+{
+	if (!(known & has_finals))
 	{
-		cached_finals_data = finals_data_handler::instance ().finals_data_for_time (julian_utc);
+		load_finals (julian_utc);
 	}
-	return cached_finals_data;
+	return { pm_x, pm_y };
 }
 
 double astro_time::julian_date_from_values (int year, int month, int day, int hour, int min, double secs)
@@ -247,6 +275,77 @@ double julian_tt_to_utc (double julian_tt)
 	}
 }
 
+/*
+* TDB - TT in seconds at 'julian_tt', the series of tdb2tt (USNO Circular 179, eq. 2.6) with the three terms at
+* multiples of the Earth's mean anomaly (628.3076 t and 1256.6152 t) taken from one sine and cosine and their double
+* angle, so that a date costs six trigonometric calls (four of them independent of the others) instead of seven in a
+* chain of calls. Differs from tdb2tt by a few units of the last place.
+*/
+static double tdb_minus_tt_series (double julian_tt)
+{
+	const double t = (julian_tt - T0) / 36525.0;
+
+	const double a = 628.3076 * t;
+	const double sin_a = std::sin (a);
+	const double cos_a = std::cos (a);
+	const double sin_2a = 2.0 * sin_a * cos_a;
+	const double cos_2a = (cos_a - sin_a) * (cos_a + sin_a);
+
+	// sin (x + phase) = sin x cos phase + cos x sin phase
+	auto shifted = [](double sin_x, double cos_x, double phase) { return sin_x * std::cos (phase) + cos_x * std::sin (phase); };
+
+	return 0.001657 * shifted (sin_a, cos_a, 6.2401)
+		+ 0.000022 * std::sin (575.3385 * t + 4.2970)
+		+ 0.000014 * shifted (sin_2a, cos_2a, 6.1969)
+		+ 0.000005 * std::sin (606.9777 * t + 4.0212)
+		+ 0.000005 * std::sin (52.9691 * t + 0.4444)
+		+ 0.000002 * std::sin (21.3299 * t + 5.5431)
+		+ 0.000010 * t * shifted (sin_a, cos_a, 4.2490);
+}
+
+void astro_time::convert_utc_to_tt_tdb_ut1 (const double* jd_utc, std::size_t count, double* jd_tt, double* jd_tdb, double* jd_ut1)
+{
+	// The first leap second at or after the date, as leapsec_tai_utc finds it; moved forward while the dates ascend.
+	std::vector<leap_second_t>::const_iterator next_leap = leap_seconds.begin ();
+	double previous = -std::numeric_limits<double>::infinity ();
+
+	std::shared_ptr<const finals_table> finals = jd_ut1 ? finals_data_handler::instance ().snapshot () : nullptr;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const double utc = jd_utc[i];
+
+		if (utc >= previous)
+		{
+			while (next_leap != leap_seconds.end () && next_leap->jd < utc)
+			{
+				++next_leap;
+			}
+		}
+		else
+		{
+			next_leap = std::lower_bound (leap_seconds.begin (), leap_seconds.end (), utc, [](const leap_second_t& l, double jd) { return l.jd < jd; });
+		}
+		previous = utc;
+
+		const double tai_utc = next_leap == leap_seconds.begin () ? 0 : (next_leap == leap_seconds.end () ? leap_seconds.back ().tai_utc : (next_leap - 1)->tai_utc);
+		const double tt = utc + (tai_utc + 32.184) / secs_per_day;
+
+		if (jd_tt)
+		{
+			jd_tt[i] = tt;
+		}
+		if (jd_tdb)
+		{
+			jd_tdb[i] = tt + tdb_minus_tt_series (tt) / secs_per_day;
+		}
+		if (jd_ut1)
+		{
+			jd_ut1[i] = utc + (finals->finals_data_for_time (utc).ut1_utc / secs_per_day);
+		}
+	}
+}
+
 astro_time astro_time::from_now ()
 {
 	return from_utc (jd_utc_now (mtx, true));
@@ -257,18 +356,15 @@ astro_time astro_time::from_tt (double jd_tt)
 	astro_time st;
 	st.julian_tt = jd_tt;
 	st.julian_utc = julian_tt_to_utc (jd_tt);
-	st.julian_tdb = julian_tt_to_tdb (jd_tt);
-	st.julian_ut1 = finals::DNAN;
+	st.known = has_tt;
 	return st;
 }
 
 astro_time astro_time::from_utc (double jd_utc)
 {
 	astro_time st;
-	st.julian_tt = julian_utc_to_tt (jd_utc);
 	st.julian_utc = jd_utc;
-	st.julian_tdb = julian_tt_to_tdb (st.julian_tt);
-	st.julian_ut1 = finals::DNAN;
+	st.known = 0;
 	return st;
 }
 
@@ -276,12 +372,10 @@ astro_time astro_time::from_ut1 (double jd_ut1)
 {
 	astro_time st;
 
-	st.julian_utc = jd_ut1; // set this temporarily so we can get correct finals data
-	st.get_finals_data ();
-	st.julian_utc = jd_ut1 - st.cached_finals_data.ut1_utc;
+	st.load_finals (jd_ut1); // the finals data for the UT1 date, as near the UTC date as we can get
+	st.julian_utc = jd_ut1 - st.ut1_utc;
 	st.julian_ut1 = jd_ut1;
-	st.julian_tt = julian_utc_to_tt (st.julian_utc);
-	st.julian_tdb = julian_tt_to_tdb (st.julian_tt);
+	st.known |= has_ut1;
 	return st;
 }
 
@@ -291,7 +385,7 @@ astro_time astro_time::from_tdb (double jd_tdb)
 	st.julian_tt = julian_tdb_to_tt (jd_tdb);
 	st.julian_utc = julian_tt_to_utc (st.julian_tt);
 	st.julian_tdb = jd_tdb;
-	st.julian_ut1 = finals::DNAN;
+	st.known = has_tt | has_tdb;
 	return st;
 }
 
@@ -336,22 +430,22 @@ astro_time astro_time::from_iso8601 (std::string const& time_str)
 
 }
 
-astro_time::astro_time () : julian_tt (0), julian_utc (0), julian_ut1 (finals::DNAN), julian_tdb (0) {}
+astro_time::astro_time () : julian_utc (0), julian_tt (0), julian_tdb (0), julian_ut1 (finals::DNAN), ut1_utc (0), pm_x (0), pm_y (0), known (has_tt | has_tdb) {}
 
 astro_time::~astro_time () {}
 
 double astro_time::delta_t ()
 {
-	if (std::isnan (cached_finals_data.julian_utc))
-	{
-		get_finals_data ();
-		julian_ut1 = julian_utc + (cached_finals_data.ut1_utc / secs_per_day);
-	}
-	return 32.184 + leapsec_tai_utc (julian_utc) - cached_finals_data.ut1_utc;
+	return 32.184 + leapsec_tai_utc (julian_utc) - finals_ut1_utc ();
 }
 
 double astro_time::as_tt ()
 {
+	if (!(known & has_tt))
+	{
+		julian_tt = julian_utc_to_tt (julian_utc);
+		known |= has_tt;
+	}
 	return julian_tt;
 }
 
@@ -362,16 +456,21 @@ double astro_time::as_utc ()
 
 double astro_time::as_ut1 ()
 {
-	if (std::isnan (cached_finals_data.julian_utc))
+	if (!(known & has_ut1))
 	{
-		get_finals_data ();
-		julian_ut1 = julian_utc + (cached_finals_data.ut1_utc / secs_per_day);
+		julian_ut1 = julian_utc + (finals_ut1_utc () / secs_per_day);
+		known |= has_ut1;
 	}
 	return julian_ut1;
 }
 
 double astro_time::as_tdb ()
 {
+	if (!(known & has_tdb))
+	{
+		julian_tdb = julian_tt_to_tdb (as_tt ());
+		known |= has_tdb;
+	}
 	return julian_tdb;
 }
 
@@ -1,12 +1,17 @@
 #ifndef ASTRO_TIME_H
 #define ASTRO_TIME_H
 
+#include <cstddef>
 #include <iostream>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 #include "finals_data_handler.h"
 
+// astro_time: a moment, convertible between the UTC, TT, TDB and UT1 scales. Only the scale it was made from is computed
+// up front; the others, and the UT1-UTC and polar motion read from the finals data, are computed on first use and kept.
+// The whole object fits in a 64-byte cache line.
 class astro_time
 {
   public:
@@ -43,23 +48,42 @@ class astro_time
 	astro_time next_month_start();
 	astro_time month_after_next_month_start();
 	
+	// get_finals_data: the finals data interpolated for this time, looked up afresh; polar_motion: the polar motion
+	// (x, y) in seconds of arc, from the values kept by the object.
 	finals_data get_finals_data();
+	std::pair<double, double> polar_motion();
 
 	// Static
 
 	static double julian_date_from_values(int year, int month, int day, int hour, int min, double secs);
 
+	// convert_utc_to_tt_tdb_ut1: converts the 'count' UTC dates at 'jd_utc' to TT, TDB and UT1. TT and UT1 are those
+	// from_utc and then as_tt and as_ut1 would give. TDB takes TDB - TT from tdb2tt's series rearranged to need fewer
+	// trigonometric calls, which differs from tdb2tt's own in the last few places, so a TDB date can differ from
+	// as_tdb's by a unit of its last place. Any of the outputs may be null. Dates in ascending order are fastest: the
+	// leap second table is then walked rather than searched.
+	static void convert_utc_to_tt_tdb_ut1(const double *jd_utc, std::size_t count, double *jd_tt, double *jd_tdb, double *jd_ut1);
+
 	// Friend
 
 	friend std::ostream &operator<<(std::ostream &os, astro_time st);
 
   private:
+	// Bits of 'known': the members computed so far. julian_utc always is.
+	enum : unsigned char { has_tt = 1, has_tdb = 2, has_ut1 = 4, has_finals = 8 };
+
+	void load_finals(double jd);
+	double finals_ut1_utc();
+
 	static std::mutex mtx;
-	double julian_tt;
 	double julian_utc;
-	double julian_ut1;
+	double julian_tt;
 	double julian_tdb;
-	finals_data cached_finals_data;
+	double julian_ut1;
+	double ut1_utc;
+	double pm_x;
+	double pm_y;
+	unsigned char known;
 };
 
 #endif
\ No newline at end of file
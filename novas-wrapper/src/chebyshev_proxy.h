@@ -0,0 +1,365 @@
+#ifndef CHEBYSHEV_PROXY_H
+#define CHEBYSHEV_PROXY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "event_search.h"
+
+/*
+* chebyshev_proxy -- a Chebyshev series standing in for a smooth function
+*
+* Interpolates the values <fx> a function takes at the nodes (a, b, n)
+* of [<a>, <b>] with a series of degree n - 1, which is evaluated by
+* Clenshaw's recurrence. roots () returns the sign changes of the series
+* in [a, b], found by subdivision: an interval is dropped when the value
+* at its middle exceeds the bound on the series' slope times its half
+* width, and split otherwise. An interval still undecided at 1/(4 n^2) of
+* [a, b] (about the closest two roots of a degree n series come) holds a
+* root if the series changes sign across it, which bisection then finds;
+* a touch of zero without a change of sign is not a root.
+*
+* tail () is the sum of the magnitudes of the upper half of the
+* coefficients, an estimate of how far the series strays from the function
+* between the nodes. near_zero (margin) returns the intervals of [a, b],
+* found by the same subdivision, where the series comes within <margin> of
+* zero, with or without a root.
+*
+*/
+
+class chebyshev_proxy {
+public:
+    chebyshev_proxy (const double a, const double b, std::vector<double> const & fx) : a (a), b (b), c (fx.size ()) {
+        const double PI = std::acos (-1.0);
+        const std::size_t n = fx.size ();
+        for (std::size_t k = 0; k < n; k++) {
+            double sum = 0.0;
+            for (std::size_t j = 0; j < n; j++)
+                sum += fx[j] * std::cos (PI * (double)k * ((double)j + 0.5) / (double)n);
+            c[k] = 2.0 * sum / (double)n;
+        }
+        c[0] *= 0.5;
+
+        // The coefficients of the derivative, d[k-1] = d[k+1] + 2 k c[k]; the sum of their magnitudes bounds the slope.
+        std::vector<double> d (n + 1, 0.0);
+        for (std::size_t k = n - 1; k >= 1; k--)
+            d[k - 1] = d[k + 1] + 2.0 * (double)k * c[k];
+        d[0] *= 0.5;
+        double bound = 0.0;
+        for (double dk : d)
+            bound += std::abs (dk);
+        slope_bound = bound * 2.0 / (b - a);
+    }
+
+    static std::vector<double> nodes (const double a, const double b, const int n) {
+        const double PI = std::acos (-1.0);
+        std::vector<double> x (n);
+        for (int j = 0; j < n; j++)
+            x[j] = 0.5 * (a + b) + 0.5 * (b - a) * std::cos (PI * ((double)j + 0.5) / (double)n);
+        return x;
+    }
+
+    double operator() (const double x) const {
+        const double t = (2.0 * x - a - b) / (b - a);
+        double b1 = 0.0, b2 = 0.0;
+        for (std::size_t k = c.size () - 1; k >= 1; k--) {
+            const double bk = 2.0 * t * b1 - b2 + c[k];
+            b2 = b1;
+            b1 = bk;
+        }
+        return t * b1 - b2 + c[0];
+    }
+
+    std::vector<double> roots () const {
+        std::vector<double> found;
+        const double n = (double)c.size ();
+        subdivide (a, b, (*this) (a), (*this) (b), (b - a) / (4.0 * n * n), found);
+        return found;
+    }
+
+    double tail () const {
+        double sum = 0.0;
+        for (std::size_t k = c.size () / 2; k < c.size (); k++)
+            sum += std::abs (c[k]);
+        return sum;
+    }
+
+    std::vector<std::pair<double, double>> near_zero (const double margin) const {
+        std::vector<std::pair<double, double>> found;
+        const double n = (double)c.size ();
+        cover (a, b, (*this) (a), (*this) (b), margin, (b - a) / (4.0 * n * n), found);
+        return found;
+    }
+
+private:
+    void cover (const double lo, const double hi, const double flo, const double fhi, const double margin, const double resolution, std::vector<std::pair<double, double>> & found) const {
+        const double mid = 0.5 * (lo + hi), fmid = (*this) (mid);
+        if (std::abs (fmid) > margin + slope_bound * 0.5 * (hi - lo))
+            return;
+        if (hi - lo > resolution) {
+            cover (lo, mid, flo, fmid, margin, resolution, found);
+            cover (mid, hi, fmid, fhi, margin, resolution, found);
+            return;
+        }
+        if (std::min ({ std::abs (flo), std::abs (fmid), std::abs (fhi) }) > margin && (flo > 0.0) == (fhi > 0.0))
+            return;
+        if (!found.empty () && found.back ().second == lo)
+            found.back ().second = hi;
+        else
+            found.push_back ({ lo, hi });
+    }
+
+    void subdivide (const double lo, const double hi, const double flo, const double fhi, const double resolution, std::vector<double> & found) const {
+        const double mid = 0.5 * (lo + hi), fmid = (*this) (mid);
+        if (std::abs (fmid) > slope_bound * 0.5 * (hi - lo))
+            return;
+        if (hi - lo > resolution) {
+            subdivide (lo, mid, flo, fmid, resolution, found);
+            subdivide (mid, hi, fmid, fhi, resolution, found);
+            return;
+        }
+        if ((flo > 0.0 && fhi > 0.0) || (flo < 0.0 && fhi < 0.0))
+            return;
+        double x1 = lo, x2 = hi, f1 = flo;
+        for (int i = 0; i < 40 && x2 - x1 > 1.0e-9 * resolution; i++) {
+            const double xm = 0.5 * (x1 + x2), fm = (*this) (xm);
+            if ((fm > 0.0) == (f1 > 0.0)) {
+                x1 = xm;
+                f1 = fm;
+            } else {
+                x2 = xm;
+            }
+        }
+        found.push_back (0.5 * (x1 + x2));
+    }
+
+    double a, b;
+    std::vector<double> c;
+    double slope_bound;
+};
+
+/*
+* proxy_search -- event roots from Chebyshev proxies of the functions
+*
+* An alternative to event_search over the same lanes and batch function
+* <fxs> (see there). fit () cuts each lane into pieces of at most <piece>
+* and evaluates the function at the <nodes> Chebyshev nodes of every
+* piece, all pieces in one call of <fxs>; lanes over the same interval
+* have the same nodes, which a batch function evaluating each epoch once
+* serves together. The roots of each piece's chebyshev_proxy are the
+* candidates. A lane with rate.wrap set is fitted on sin (2 pi f / wrap),
+* which is smooth across the jump of the angle and zero both where f is
+* and where f jumps. Where a proxy comes within rate.jump and its tail ()
+* of zero without a candidate, the function may graze zero, or cross it
+* where the proxy does not; such a stretch, widened by the node spacing, is
+* searched by an event_search in polish ().
+*
+* polish () takes Newton steps on the function from all candidates
+* together, one call of <fxs> per round, and keeps the point a step of at
+* most event_search's tolerance for <tol> is taken from, if it lies in the
+* lane (as event_search does, the last point evaluated).
+* A candidate whose step leaves the node spacing around it, or that has
+* not converged after a few steps, is searched again by an event_search
+* over that window, with the stretches fit () found; <fallbacks> counts
+* the windows. Roots closer than a thousandth of the node spacing are the
+* same root, found twice.
+*
+*/
+
+class proxy_search {
+public:
+    proxy_search (std::vector<event_lane> lanes, const double piece, const int nodes) :
+        lanes (std::move (lanes)), lane_roots (this->lanes.size ()), piece (piece), nodes (nodes) {}
+
+    template <typename F>
+    void fit (F & fxs);
+
+    template <typename F>
+    void polish (F & fxs, const double tol);
+
+    std::size_t size () const {
+        return lanes.size ();
+    }
+
+    std::vector<double> const & roots (std::size_t lane) const {
+        return lane_roots[lane];
+    }
+
+    long evaluations = 0;
+    long rounds = 0;
+    long fallbacks = 0;
+
+private:
+    struct candidate {
+        std::size_t lane;
+        double x;
+        double lo, hi;
+    };
+
+    template <typename F>
+    void evaluate (F & fxs) {
+        f.resize (queries.size ());
+        df.resize (queries.size ());
+        if (!queries.empty ())
+            fxs (queries.data (), queries.size (), f.data (), df.data ());
+        evaluations += (long)queries.size ();
+        ++rounds;
+    }
+
+    std::vector<event_lane> lanes;
+    std::vector<candidate> candidates;
+    std::vector<candidate> suspects;
+    std::vector<std::vector<double>> lane_roots;
+    const double piece;
+    const int nodes;
+
+    std::vector<event_query> queries;
+    std::vector<double> f, df;
+};
+
+template <typename F>
+void proxy_search::fit (F & fxs) {
+    struct fitted_piece {
+        std::size_t lane;
+        double a, b;
+    };
+
+    const double PI = std::acos (-1.0);
+
+    std::vector<fitted_piece> pieces;
+    queries.clear ();
+    for (std::size_t l = 0; l < lanes.size (); l++) {
+        event_lane const & lane = lanes[l];
+        if (!(lane.x1 < lane.x2))
+            continue;
+        const int count = std::max (1, (int)std::ceil ((lane.x2 - lane.x1) / piece));
+        for (int p = 0; p < count; p++) {
+            const double a = lane.x1 + (lane.x2 - lane.x1) * p / count;
+            const double b = p + 1 < count ? lane.x1 + (lane.x2 - lane.x1) * (p + 1) / count : lane.x2;
+            pieces.push_back ({ l, a, b });
+            for (double x : chebyshev_proxy::nodes (a, b, nodes))
+                queries.push_back ({ lane.function, x });
+        }
+    }
+    evaluate (fxs);
+
+    candidates.clear ();
+    suspects.clear ();
+    std::vector<double> fx (nodes);
+    for (std::size_t p = 0; p < pieces.size (); p++) {
+        event_lane const & lane = lanes[pieces[p].lane];
+        const double wrap = lane.rate.wrap;
+        for (int j = 0; j < nodes; j++) {
+            const double v = f[p * nodes + j];
+            fx[j] = wrap > 0.0 ? std::sin (2.0 * PI * v / wrap) : v;
+        }
+        const double spacing = (pieces[p].b - pieces[p].a) / nodes;
+        const chebyshev_proxy proxy (pieces[p].a, pieces[p].b, fx);
+        const std::vector<double> roots = proxy.roots ();
+        for (double r : roots)
+            candidates.push_back ({ pieces[p].lane, r, r - spacing, r + spacing });
+
+        const double margin = (wrap > 0.0 ? 2.0 * PI * lane.rate.jump / wrap : lane.rate.jump) + proxy.tail ();
+        for (auto const & near : proxy.near_zero (margin)) {
+            if (std::any_of (roots.begin (), roots.end (), [&] (double r) { return r >= near.first && r <= near.second; }))
+                continue;
+            const double lo = std::max (lane.x1, near.first - spacing), hi = std::min (lane.x2, near.second + spacing);
+            suspects.push_back ({ pieces[p].lane, 0.5 * (lo + hi), lo, hi });
+        }
+    }
+}
+
+template <typename F>
+void proxy_search::polish (F & fxs, const double tol) {
+    const int NEWTON_STEPS = 6;
+    const double EPS = std::numeric_limits<double>::epsilon ();
+
+    struct polishing {
+        candidate c;
+        double shift;   // 0, or the period when polished on the shifted angle
+        int steps;
+    };
+
+    for (auto & roots : lane_roots)
+        roots.clear ();
+
+    auto keep = [&] (std::size_t l, double x) {
+        if (x >= lanes[l].x1 && x <= lanes[l].x2)
+            lane_roots[l].push_back (x);
+    };
+
+    std::vector<polishing> active;
+    for (auto const & c : candidates)
+        active.push_back ({ c, 0.0, 0 });
+
+    std::vector<event_lane> windows;
+    std::vector<std::size_t> window_lane;
+    for (auto const & c : suspects) {
+        windows.push_back ({ lanes[c.lane].function, c.lo, c.hi, lanes[c.lane].rate });
+        window_lane.push_back (c.lane);
+    }
+
+    while (!active.empty ()) {
+        queries.clear ();
+        for (auto const & p : active)
+            queries.push_back ({ lanes[p.c.lane].function, p.c.x });
+        evaluate (fxs);
+
+        std::vector<polishing> stepping;
+        for (std::size_t i = 0; i < active.size (); i++) {
+            polishing p = active[i];
+            event_lane const & lane = lanes[p.c.lane];
+            const double wrap = lane.rate.wrap;
+            if (p.steps == 0 && wrap > 0.0 && std::abs (f[i]) > 0.25 * wrap)
+                p.shift = wrap;
+            const double v = p.shift > 0.0 ? (f[i] > 0.0 ? f[i] - 0.5 * p.shift : f[i] + 0.5 * p.shift) : f[i];
+            if (v == 0.0) {
+                keep (p.c.lane, p.c.x);
+                continue;
+            }
+            if (df[i] != 0.0) {
+                const double dx = v / df[i], xn = p.c.x - dx;
+                if (std::abs (dx) <= 2.0 * EPS * std::abs (xn) + 0.5 * tol) {
+                    keep (p.c.lane, p.c.x);
+                    continue;
+                }
+                if (xn >= p.c.lo && xn <= p.c.hi && ++p.steps < NEWTON_STEPS) {
+                    p.c.x = xn;
+                    stepping.push_back (p);
+                    continue;
+                }
+            }
+            const double lo = std::max (lane.x1, p.c.lo), hi = std::min (lane.x2, p.c.hi);
+            if (lo < hi) {
+                windows.push_back ({ lane.function, lo, hi, lane.rate });
+                window_lane.push_back (p.c.lane);
+            }
+        }
+        active.swap (stepping);
+    }
+
+    if (!windows.empty ()) {
+        fallbacks += (long)windows.size ();
+        event_search search (windows);
+        search.bracket (fxs);
+        search.refine (fxs, tol);
+        evaluations += search.evaluations;
+        rounds += search.rounds;
+        for (std::size_t w = 0; w < windows.size (); w++) {
+            for (double r : search.roots (w))
+                lane_roots[window_lane[w]].push_back (r);
+        }
+    }
+
+    const double same = 1.0e-3 * piece / nodes;
+    for (auto & roots : lane_roots) {
+        std::sort (roots.begin (), roots.end ());
+        roots.erase (std::unique (roots.begin (), roots.end (), [&] (double x, double y) { return y - x < same; }), roots.end ());
+    }
+}
+
+#endif
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <stdexcept>
 #include <tuple>
 
@@ -13,7 +14,9 @@ extern "C"
 ephemeris::ephemeris () :
 	ephemeris_version (-1),
 	ephemeris_begin (0),
-	ephemeris_end (0)
+	ephemeris_end (0),
+	access_mode (ephemeris_access::buffered),
+	closed_reader_stats ()
 {
 }
 
@@ -23,12 +26,9 @@ ephemeris::~ephemeris()
         ephem_close();
 }
 
-std::tuple<double, double, short> w_ephem_open (std::string ephemeris_path) {
-	double ephemeris_begin;
-	double ephemeris_end;
-	short ephemeris_version;
+std::tuple<double, double, short> w_ephem_open_result (short error, std::string const & ephemeris_path, double ephemeris_begin, double ephemeris_end, short ephemeris_version) {
 
-	switch (ephem_open (ephemeris_path.data (), &ephemeris_begin, &ephemeris_end, &ephemeris_version)) {
+	switch (error) {
 	case 0:
 		return { ephemeris_begin, ephemeris_end, ephemeris_version };
 	case 1:
@@ -53,18 +53,151 @@ std::tuple<double, double, short> w_ephem_open (std::string ephemeris_path) {
 		throw std::runtime_error ("error reading from file header at 'LPT'");
 	case 11:
 		throw std::runtime_error ("unable to set record length; ephemeris (DE number) not in look - up table.");
+	case 12:
+		throw std::runtime_error ("unable to allocate memory for, or map, JPL ephemeris file at '" + ephemeris_path + "'");
+	default:
+		throw std::runtime_error ("unknown error");
+	}
+
+}
+
+std::tuple<double, double, short> w_ephem_open (std::string ephemeris_path, ephemeris_access access) {
+	double ephemeris_begin;
+	double ephemeris_end;
+	short ephemeris_version;
+
+	short error = (access == ephemeris_access::mapped)
+		? ephem_open_mapped (ephemeris_path.data (), &ephemeris_begin, &ephemeris_end, &ephemeris_version)
+		: ephem_open (ephemeris_path.data (), &ephemeris_begin, &ephemeris_end, &ephemeris_version);
+
+	return w_ephem_open_result (error, ephemeris_path, ephemeris_begin, ephemeris_end, ephemeris_version);
+}
+
+std::tuple<double, double, short> w_ephem_reader_open (ephem_reader * reader, std::string ephemeris_path, ephemeris_access access) {
+	double ephemeris_begin;
+	double ephemeris_end;
+	short ephemeris_version;
+
+	short error = ephem_reader_open (reader, ephemeris_path.data (), (access == ephemeris_access::mapped) ? EPH_ACCESS_MAPPED : EPH_ACCESS_BUFFERED,
+		&ephemeris_begin, &ephemeris_end, &ephemeris_version);
+
+	return w_ephem_open_result (error, ephemeris_path, ephemeris_begin, ephemeris_end, ephemeris_version);
+}
+
+void w_ephem_reader_set_cache_size (ephem_reader * reader, long records) {
+	switch (ephem_reader_set_cache_size (reader, records)) {
+	case 0:
+		return;
+	case 1:
+		throw std::runtime_error ("invalid ephemeris cache size: " + std::to_string (records));
+	case 2:
+		throw std::runtime_error ("unable to allocate ephemeris cache of " + std::to_string (records) + " records; ephemeris closed");
+	default:
+		throw std::runtime_error ("unknown error");
+	}
+}
+
+static_assert (std::tuple_size<decltype (ephemeris_stats::interpolations)>::value == EPH_STATE_TARGETS, "one interpolation counter per ephemeris target");
+
+ephemeris_stats w_ephem_reader_stats (ephem_reader const * reader) {
+	ephemeris_stats stats;
+	stats.record_switches = reader->record_switches;
+	stats.reads = reader->reads;
+	stats.records_read = reader->records_read;
+	stats.bytes_read = reader->bytes_read;
+	stats.cache_hits = reader->cache_hits;
+	stats.cache_misses = reader->cache_misses;
+	std::copy (reader->interpolations, reader->interpolations + EPH_STATE_TARGETS, stats.interpolations.begin ());
+	return stats;
+}
+
+void add_stats (ephemeris_stats & total, ephemeris_stats const & stats) {
+	total.record_switches += stats.record_switches;
+	total.reads += stats.reads;
+	total.records_read += stats.records_read;
+	total.bytes_read += stats.bytes_read;
+	total.cache_hits += stats.cache_hits;
+	total.cache_misses += stats.cache_misses;
+	for (std::size_t i = 0; i < total.interpolations.size (); ++i)
+		total.interpolations[i] += stats.interpolations[i];
+}
+
+void w_ephem_reader_preload (ephem_reader * reader, double jd_begin, double jd_end) {
+	switch (ephem_reader_preload (reader, jd_begin, jd_end)) {
+	case 0:
+		return;
+	case 1:
+		throw std::runtime_error ("ephemeris not open, or preload range ends before it begins");
+	case 2:
+		throw std::runtime_error ("preload range outside of ephemeris file");
+	case 3:
+		throw std::runtime_error ("unable to allocate memory for preloaded ephemeris records");
+	case 4:
+		throw std::runtime_error ("error reading ephemeris file");
+	default:
+		throw std::runtime_error ("unknown error");
+	}
+}
+
+void w_ephem_reader_load_single (ephem_reader * reader, double jd_begin, double jd_end) {
+	switch (ephem_reader_load_single (reader, jd_begin, jd_end)) {
+	case 0:
+		return;
+	case 1:
+		throw std::runtime_error ("ephemeris not open, or single-precision range ends before it begins");
+	case 2:
+		throw std::runtime_error ("single-precision range outside of ephemeris file");
+	case 3:
+		throw std::runtime_error ("unable to allocate memory for single-precision ephemeris records");
+	case 4:
+		throw std::runtime_error ("error reading ephemeris file");
+	default:
+		throw std::runtime_error ("unknown error");
+	}
+}
+
+void w_ephem_reader_extract (ephem_reader * reader, std::string compact_path, double jd_begin, double jd_end, long series) {
+	switch (ephem_reader_extract (reader, compact_path.data (), jd_begin, jd_end, series)) {
+	case 0:
+		return;
+	case 1:
+		throw std::runtime_error ("ephemeris not open, or extract range ends before it begins");
+	case 2:
+		throw std::runtime_error ("extract range outside of ephemeris file");
+	case 3:
+		throw std::runtime_error ("unable to create compact ephemeris file at '" + compact_path + "'");
+	case 4:
+		throw std::runtime_error ("error reading ephemeris file");
+	case 5:
+		throw std::runtime_error ("error writing compact ephemeris file at '" + compact_path + "'");
 	default:
 		throw std::runtime_error ("unknown error");
 	}
+}
 
+void w_state_result (short error) {
+	switch (error) {
+	case 0:
+		return;
+	case 1:
+		throw std::runtime_error ("error reading ephemeris file");
+	case 2:
+		throw std::runtime_error ("epoch out of range of ephemeris file");
+	case 3:
+		throw std::runtime_error ("body number outside 0-10, or body not present in ephemeris file");
+	default:
+		throw std::runtime_error ("unknown error: " + std::to_string (error));
+	}
 }
 
-void ephemeris::open (std::string ephemeris_path) {
+void ephemeris::open (std::string ephemeris_path, ephemeris_access access) {
 
-	auto [eph_begin, eph_end, eph_version] = w_ephem_open (ephemeris_path);
+	auto [eph_begin, eph_end, eph_version] = w_ephem_open (ephemeris_path, access);
+	this->ephemeris_path = ephemeris_path;
 	ephemeris_begin = eph_begin;
 	ephemeris_end = eph_end;
 	ephemeris_version = eph_version;
+	access_mode = access;
 }
 
 short ephemeris::eph_version () const
@@ -80,4 +213,276 @@ double ephemeris::eph_begin () const
 double ephemeris::eph_end () const
 {
 	return ephemeris_end;
-}
\ No newline at end of file
+}
+
+ephemeris_access ephemeris::eph_access () const
+{
+	return access_mode;
+}
+
+void ephemeris::set_cache_size (long records)
+{
+	w_ephem_reader_set_cache_size (ephem_default_reader (), records);
+}
+
+long ephemeris::cache_size () const
+{
+	long records = ephem_default_reader ()->cache_size;
+	return (records > 0) ? records : EPH_CACHE_RECORDS;
+}
+
+unsigned long ephemeris::cache_hits () const
+{
+	return stats ().cache_hits;
+}
+
+unsigned long ephemeris::cache_misses () const
+{
+	return stats ().cache_misses;
+}
+
+void ephemeris::reset_cache_stats ()
+{
+	ephem_reader_reset_stats (ephem_default_reader ());
+
+	std::lock_guard<std::mutex> lck (stats_mtx);
+	closed_reader_stats = ephemeris_stats ();
+}
+
+ephemeris_stats ephemeris::stats () const
+{
+	ephemeris_stats rv = w_ephem_reader_stats (ephem_default_reader ());
+
+	std::lock_guard<std::mutex> lck (stats_mtx);
+	add_stats (rv, closed_reader_stats);
+	return rv;
+}
+
+void ephemeris::add_reader_stats (ephemeris_stats const& reader_stats)
+{
+	std::lock_guard<std::mutex> lck (stats_mtx);
+	add_stats (closed_reader_stats, reader_stats);
+}
+
+void ephemeris::preload (double jd_begin, double jd_end)
+{
+	w_ephem_reader_preload (ephem_default_reader (), jd_begin, jd_end);
+	access_mode = ephemeris_access::buffered;
+}
+
+long ephemeris::preloaded_records () const
+{
+	return ephem_default_reader ()->preload_count;
+}
+
+void ephemeris::load_single (double jd_begin, double jd_end)
+{
+	w_ephem_reader_load_single (ephem_default_reader (), jd_begin, jd_end);
+}
+
+long ephemeris::single_records () const
+{
+	return ephem_default_reader ()->single_count;
+}
+
+void ephemeris::state_batch (short target, const double* jd, std::size_t n, double* pos, double* vel)
+{
+	w_state_result (::state_batch (target, jd, n, pos, vel));
+}
+
+void ephemeris::geocentric_state_batch (short target, const double* jd, std::size_t n, double* pos, double* vel)
+{
+	const short earth_moon_barycenter = 2, moon = 9;
+
+	state_batch (target, jd, n, pos, vel);
+	if (target == moon)
+		return;
+
+	std::vector<double> emb_pos (3 * n), emb_vel (3 * n), moon_pos (3 * n), moon_vel (3 * n);
+	state_batch (earth_moon_barycenter, jd, n, emb_pos.data (), emb_vel.data ());
+	state_batch (moon, jd, n, moon_pos.data (), moon_vel.data ());
+
+	const double moon_share = 1.0 / (1.0 + ephem_current_reader ()->em_ratio);
+	for (std::size_t i = 0; i < 3 * n; ++i) {
+		pos[i] -= emb_pos[i] - moon_share * moon_pos[i];
+		if (vel != nullptr)
+			vel[i] -= emb_vel[i] - moon_share * moon_vel[i];
+	}
+}
+
+std::unique_ptr<ephemeris_reader> ephemeris::open_reader () const
+{
+	auto reader = std::make_unique<ephemeris_reader> (ephemeris_path, access_mode);
+
+	ephem_reader const * source = ephem_default_reader ();
+	if (source->cache_size > 0)
+		reader->set_cache_size (source->cache_size);
+
+	// Records are numbered from 3 (see eph_manager.c 'covering_records'); the midpoints of the first and last record
+	// copied select the same records in the new reader.
+	if (source->preload_count > 0) {
+		double first = source->ss[0] + ((double)(source->preload_first - 3) + 0.5) * source->ss[2];
+		double last = first + (double)(source->preload_count - 1) * source->ss[2];
+		reader->preload (first, last);
+	}
+	if (source->single_count > 0) {
+		double first = source->ss[0] + ((double)(source->single_first - 3) + 0.5) * source->ss[2];
+		double last = first + (double)(source->single_count - 1) * source->ss[2];
+		reader->load_single (first, last);
+	}
+
+	reader->stats_owner = const_cast<ephemeris *> (this);
+	return reader;
+}
+
+ephemeris_reader::ephemeris_reader (std::string const& ephemeris_path, ephemeris_access access) :
+	reader (new ephem_reader ()),
+	ephemeris_version (-1),
+	ephemeris_begin (0),
+	ephemeris_end (0),
+	stats_owner (nullptr)
+{
+	auto [eph_begin, eph_end, eph_version] = w_ephem_reader_open (reader.get (), ephemeris_path, access);
+	ephemeris_begin = eph_begin;
+	ephemeris_end = eph_end;
+	ephemeris_version = eph_version;
+}
+
+ephemeris_reader::~ephemeris_reader ()
+{
+	if (stats_owner != nullptr)
+		stats_owner->add_reader_stats (stats ());
+	ephem_reader_close (reader.get ());
+}
+
+short ephemeris_reader::eph_version () const
+{
+	return ephemeris_version;
+}
+
+double ephemeris_reader::eph_begin () const
+{
+	return ephemeris_begin;
+}
+
+double ephemeris_reader::eph_end () const
+{
+	return ephemeris_end;
+}
+
+void ephemeris_reader::state (double jed[2], short target, double target_pos[3], double target_vel[3])
+{
+	w_state_result (ephem_reader_state (reader.get (), jed, target, target_pos, target_vel));
+}
+
+void ephemeris_reader::state_batch (short target, const double* jd, std::size_t n, double* pos, double* vel)
+{
+	w_state_result (ephem_reader_state_batch (reader.get (), target, jd, n, pos, vel));
+}
+
+void ephemeris_reader::set_cache_size (long records)
+{
+	w_ephem_reader_set_cache_size (reader.get (), records);
+}
+
+long ephemeris_reader::cache_size () const
+{
+	return (reader->cache_size > 0) ? reader->cache_size : EPH_CACHE_RECORDS;
+}
+
+unsigned long ephemeris_reader::cache_hits () const
+{
+	return reader->cache_hits;
+}
+
+unsigned long ephemeris_reader::cache_misses () const
+{
+	return reader->cache_misses;
+}
+
+ephemeris_stats ephemeris_reader::stats () const
+{
+	return w_ephem_reader_stats (reader.get ());
+}
+
+void ephemeris_reader::reset_cache_stats ()
+{
+	ephem_reader_reset_stats (reader.get ());
+}
+
+void ephemeris_reader::preload (double jd_begin, double jd_end)
+{
+	w_ephem_reader_preload (reader.get (), jd_begin, jd_end);
+}
+
+long ephemeris_reader::preloaded_records () const
+{
+	return reader->preload_count;
+}
+
+void ephemeris_reader::load_single (double jd_begin, double jd_end)
+{
+	w_ephem_reader_load_single (reader.get (), jd_begin, jd_end);
+}
+
+long ephemeris_reader::single_records () const
+{
+	return reader->single_count;
+}
+
+void ephemeris_reader::extract (std::string const& compact_path, double jd_begin, double jd_end, std::vector<short> const& targets)
+{
+	long series = EPH_SERIES_PLANETARY;
+
+	if (!targets.empty ()) {
+		series = (1L << 2) | (1L << 9) | (1L << 10);
+		for (short target : targets) {
+			if (target < 0 || target > 10)
+				throw std::runtime_error ("invalid ephemeris target: " + std::to_string (target));
+			series |= 1L << target;
+		}
+	}
+
+	w_ephem_reader_extract (reader.get (), compact_path, jd_begin, jd_end, series);
+}
+
+ephem_reader * ephemeris_reader::handle ()
+{
+	return reader.get ();
+}
+
+void state (ephemeris_reader& reader, double jed[2], short target, double target_pos[3], double target_vel[3])
+{
+	reader.state (jed, target, target_pos, target_vel);
+}
+
+ephemeris_reader_binding::ephemeris_reader_binding (ephemeris_reader& reader) :
+	previous (ephem_reader_bind (reader.handle ()))
+{
+}
+
+ephemeris_reader_binding::~ephemeris_reader_binding ()
+{
+	ephem_reader_bind (previous);
+}
+
+ephemeris_precision_scope::ephemeris_precision_scope (ephemeris_precision precision) :
+	previous (ephem_set_precision ((precision == ephemeris_precision::single) ? EPH_PRECISION_SINGLE : EPH_PRECISION_DOUBLE)),
+	reduced_precision (precision == ephemeris_precision::single && ephem_current_reader ()->single_count > 0)
+{
+}
+
+ephemeris_precision_scope::~ephemeris_precision_scope ()
+{
+	ephem_set_precision (previous);
+}
+
+bool ephemeris_precision_scope::reduced () const
+{
+	return reduced_precision;
+}
+
+bool ephemeris_precision_scope::reduced_on_this_thread ()
+{
+	return ephem_precision () == EPH_PRECISION_SINGLE && ephem_current_reader ()->single_count > 0;
+}
@@ -1,6 +1,48 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+struct ephem_reader;
+
+class ephemeris_reader;
+
+// How record data is read from the ephemeris file:
+//   buffered: seek and read each Chebyshev record into a single buffer when the requested epoch changes record
+//   mapped:   map the whole file into memory and address records in place, with no copy
+enum class ephemeris_access {
+	buffered,
+	mapped
+};
+
+// Precision of the Chebyshev coefficients state() evaluates on a thread (see ephemeris_precision_scope):
+//   full:   the double-precision records of the file
+//   single: the float copy made by load_single, where it covers the epoch
+enum class ephemeris_precision {
+	full,
+	single
+};
+
+// Ephemeris access counters, since the file was opened or the counters were reset (see eph_manager.c
+// 'ephem_reader_reset_stats'):
+//   record_switches:  state() calls evaluating a different record than the previous call
+//   reads:            fread calls for record data (one per cache miss, one per preload)
+//   records_read:     records those reads returned, and their size in bytes_read
+//   cache_hits:       record lookups served from the record cache, and cache_misses, read into it
+//   interpolations:   epochs evaluated, by body number (see ephemeris_reader::state)
+struct ephemeris_stats {
+	unsigned long record_switches;
+	unsigned long reads;
+	unsigned long records_read;
+	unsigned long bytes_read;
+	unsigned long cache_hits;
+	unsigned long cache_misses;
+	std::array<unsigned long, 11> interpolations;
+};
 
 class ephemeris
 {
@@ -17,17 +59,76 @@ public:
 	// 
 	// INPUT:
 	//   ephemeris_path:                     path to binary JPL ephemeris file
+	//   access:                             how records are read from the file (see ephemeris_access)
 	// 
 	// OUTPUT:
 	//   std::tuple<double, double, short>:  beginning Julian date of ephemeris file, ending Julian date of ephemeris file, DE number of opened ephemeris file
 
-    void open(std::string ephemeris_path);
+    void open(std::string ephemeris_path, ephemeris_access access = ephemeris_access::buffered);
 
     ~ephemeris();
 
     short eph_version() const;
     double eph_begin() const;
     double eph_end() const;
+    ephemeris_access eph_access() const;
+
+	// set_cache_size: sets how many Chebyshev records are kept in memory when reading with ephemeris_access::buffered.
+	// Records are kept by record number and the least recently used one is replaced on a miss. May be called before or
+	// after open; resizing empties the cache.
+
+    void set_cache_size(long records);
+    long cache_size() const;
+
+	// cache_hits, cache_misses: record lookups served from, and read into, the record cache since open or reset_cache_stats.
+	// stats: all of the access counters (see ephemeris_stats) of the file opened by open, with those of the readers opened
+	// by open_reader added in as each is closed. reset_cache_stats sets every counter to zero.
+
+    unsigned long cache_hits() const;
+    unsigned long cache_misses() const;
+    ephemeris_stats stats() const;
+    void reset_cache_stats();
+
+	// preload: reads the Chebyshev records covering jd_begin to jd_end (TDB, clipped to the file's span) into one
+	// contiguous aligned block in memory, from which state() then serves every epoch in the range. Epochs outside the
+	// range are still read from the file. A mapped file is unmapped, and falls back to buffered access, so that only the
+	// preloaded records stay resident. Replaces any previous preload.
+
+    void preload(double jd_begin, double jd_end);
+    long preloaded_records() const;
+
+	// load_single: keeps a single-precision (float) copy of the Chebyshev records covering jd_begin to jd_end (TDB), for
+	// coarse screening passes run under an ephemeris_precision_scope. Positions from the copy differ from the full
+	// precision ones by less than about 6e-8 of the body's distance from the barycenter (under 0.02 arcsecond seen from
+	// the Earth; see eph_manager.c 'ephem_reader_load_single'). Replaces any previous copy.
+
+    void load_single(double jd_begin, double jd_end);
+    long single_records() const;
+
+	// state_batch: reads and interpolates the ephemeris for one body at many epochs, through the reader NOVAS uses on
+	// the calling thread. Epochs are grouped by record, so each record is located once per group and its epochs are
+	// interpolated together. Each result is identical to a state() call at that epoch.
+	//
+	// INPUT:
+	//   target:                             body number, as for ephemeris_reader::state
+	//   jd[n]:                              TDB Julian dates, in any order
+	//
+	// OUTPUT:
+	//   pos[3 * n], vel[3 * n]:             barycentric position (AU) and velocity (AU/day) at each epoch; vel may be null
+
+    void state_batch(short target, const double * jd, std::size_t n, double * pos, double * vel);
+
+	// geocentric_state_batch: as state_batch, for the position and velocity of 'target' relative to the Earth, which is
+	// the Earth-Moon barycenter less the Moon's share of the geocentric Moon (as NOVAS 'solarsystem' computes it). The
+	// Moon (9) is geocentric already.
+
+    void geocentric_state_batch(short target, const double * jd, std::size_t n, double * pos, double * vel);
+
+	// open_reader: opens an ephemeris_reader on the file opened by open, for a worker thread, with the same access, cache
+	// size, preload and single-precision copy (see load_single), so that positions evaluated through it are identical to
+	// those NOVAS evaluates on threads bound to no reader. Its counters are added to stats() when it is closed.
+
+    std::unique_ptr<ephemeris_reader> open_reader() const;
 
     ephemeris(ephemeris const &) = delete;
     ephemeris(ephemeris &&) = delete;
@@ -37,7 +138,132 @@ public:
 private:
     ephemeris();
 
+    friend class ephemeris_reader;
+    void add_reader_stats(ephemeris_stats const & reader_stats);
+
+    std::string ephemeris_path;
     short ephemeris_version;
     double ephemeris_begin;
     double ephemeris_end;
-};
\ No newline at end of file
+    ephemeris_access access_mode;
+    mutable std::mutex stats_mtx;
+    ephemeris_stats closed_reader_stats;
+};
+
+// ephemeris_reader: an independently opened ephemeris file. Unlike the ephemeris singleton, which wraps the process-wide
+// state used by NOVAS, a reader owns its own file handle or mapping, header data and record buffer. Worker threads
+// should each hold their own reader; a single reader must not be used by two threads at once.
+
+class ephemeris_reader
+{
+
+public:
+	// INPUT:
+	//   ephemeris_path:                     path to binary JPL ephemeris file
+	//   access:                             how records are read from the file (see ephemeris_access)
+
+	explicit ephemeris_reader(std::string const & ephemeris_path, ephemeris_access access = ephemeris_access::mapped);
+
+	~ephemeris_reader();
+
+	short eph_version() const;
+	double eph_begin() const;
+	double eph_end() const;
+
+	// state: reads and interpolates the ephemeris for one body.
+	//
+	// INPUT:
+	//   jed[2]:                             TDB Julian date, split any way between the two elements (see eph_manager.c 'state')
+	//   target:                             body number: 0 = Mercury, ..., 2 = Earth-Moon barycenter, ..., 8 = Pluto, 9 = Moon (geocentric), 10 = Sun
+	//
+	// OUTPUT:
+	//   target_pos[3], target_vel[3]:       barycentric position (AU) and velocity (AU/day) of 'target'
+
+	void state(double jed[2], short target, double target_pos[3], double target_vel[3]);
+
+	// See the ephemeris class members of the same names.
+
+	void state_batch(short target, const double * jd, std::size_t n, double * pos, double * vel);
+
+	void set_cache_size(long records);
+	long cache_size() const;
+	unsigned long cache_hits() const;
+	unsigned long cache_misses() const;
+	ephemeris_stats stats() const;
+	void reset_cache_stats();
+	void preload(double jd_begin, double jd_end);
+	long preloaded_records() const;
+	void load_single(double jd_begin, double jd_end);
+	long single_records() const;
+
+	// extract: writes a compact ephemeris file with only the records covering jd_begin to jd_end (TDB) and, within
+	// them, only the series of 'targets' (state numbering). An empty 'targets' keeps the Sun, Moon, Earth-Moon
+	// barycenter and planets, dropping nutations and librations. The compact file opens like any DE file, with
+	// ephemeris::open or ephemeris_reader; state() for a dropped target throws. Positions of any body need the Earth-Moon
+	// barycenter (2), Moon (9) and Sun (10) series, which are always kept.
+
+	void extract(std::string const & compact_path, double jd_begin, double jd_end, std::vector<short> const & targets = {});
+
+	ephem_reader * handle();
+
+	ephemeris_reader(ephemeris_reader const &) = delete;
+	ephemeris_reader(ephemeris_reader &&) = delete;
+	ephemeris_reader &operator=(ephemeris_reader const &) = delete;
+	ephemeris_reader &operator=(ephemeris_reader &&) = delete;
+
+private:
+	friend class ephemeris;
+
+	std::unique_ptr<ephem_reader> reader;
+	short ephemeris_version;
+	double ephemeris_begin;
+	double ephemeris_end;
+	class ephemeris * stats_owner;
+};
+
+void state(ephemeris_reader & reader, double jed[2], short target, double target_pos[3], double target_vel[3]);
+
+// ephemeris_reader_binding: while in scope, NOVAS functions called on this thread (place, solarsystem, ...) read the
+// ephemeris through 'reader' instead of the file opened by ephemeris::open.
+
+class ephemeris_reader_binding
+{
+
+public:
+	explicit ephemeris_reader_binding(ephemeris_reader & reader);
+	~ephemeris_reader_binding();
+
+	ephemeris_reader_binding(ephemeris_reader_binding const &) = delete;
+	ephemeris_reader_binding &operator=(ephemeris_reader_binding const &) = delete;
+
+private:
+	ephem_reader * previous;
+};
+
+// ephemeris_precision_scope: while in scope, state() on this thread - and so NOVAS - evaluates the coefficients at
+// 'precision'. Root finders bracket under ephemeris_precision::single and refine outside the scope, at full precision.
+
+class ephemeris_precision_scope
+{
+
+public:
+	explicit ephemeris_precision_scope(ephemeris_precision precision);
+	~ephemeris_precision_scope();
+
+	// reduced: true if single precision was requested and the reader in use on this thread holds a single-precision
+	// copy (see ephemeris::load_single); otherwise every evaluation in the scope is at full precision.
+
+	bool reduced() const;
+
+	// reduced_on_this_thread: true while state() on this thread evaluates a single-precision copy, under whatever
+	// scope; for callers that keep values computed in a search and must not keep screening ones.
+
+	static bool reduced_on_this_thread();
+
+	ephemeris_precision_scope(ephemeris_precision_scope const &) = delete;
+	ephemeris_precision_scope &operator=(ephemeris_precision_scope const &) = delete;
+
+private:
+	short previous;
+	bool reduced_precision;
+};
@@ -0,0 +1,365 @@
+#ifndef EVENT_SEARCH_H
+#define EVENT_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/*
+* bracket_rate -- what an event_search knows of a function
+*
+* <max_rate> bounds |f'| (units of f per unit of x). Steps are kept between
+* <min_step> and <max_step>. <wrap>, when not 0, is the period of an angle
+* reported in [-wrap/2, wrap/2]: its jump at +/- wrap/2 changes sign, and
+* is bracketed as a root is. <jump>, when not 0, bounds the jumps f makes
+* elsewhere (refraction switching on below the horizon); bracketing leaves
+* them to the spare in <max_rate>, but a proxy_search cannot fit them (see
+* chebyshev_proxy.h).
+*
+*/
+
+struct bracket_rate {
+    double max_rate;
+    double min_step;
+    double max_step;
+    double wrap;
+    double jump = 0.0;
+};
+
+/*
+* bracket_grid -- evenly spaced points to search
+*
+* fixed_bracket_grid (<x1>, <x2>, <n>) holds the n + 1 points from x1 to
+* x2, each the one before plus the step (x2 - x1) / n, as a search stepping
+* from x1 by that step reaches them, and the step.
+*
+*/
+
+struct bracket_grid {
+    double dx;
+    std::vector<double> x;
+};
+
+inline bracket_grid fixed_bracket_grid (const double x1, const double x2, const int n) {
+    bracket_grid grid { (x2 - x1) / n, std::vector<double> (n + 1) };
+    double x = x1;
+    grid.x[0] = x1;
+    for (int i = 0; i < n; i++) {
+        x += grid.dx;
+        grid.x[i + 1] = x;
+    }
+    return grid;
+}
+
+/*
+* recent_values -- what a function returned at its last few abscissas
+*
+* Keeps the last <N> values given to store (), with their abscissas.
+* find () returns the value kept for <x>, or nullptr. clear () forgets
+* every value.
+*
+*/
+
+template <typename V, int N = 16>
+class recent_values {
+public:
+    V const * find (const double x) const {
+        for (int i = 0; i < count; i++) {
+            if (xs[i] == x)
+                return &values[i];
+        }
+        return nullptr;
+    }
+
+    void store (const double x, V const & v) {
+        xs[next] = x;
+        values[next] = v;
+        next = (next + 1) % N;
+        count = std::min (count + 1, N);
+    }
+
+    void clear () {
+        count = 0;
+        next = 0;
+    }
+
+private:
+    std::array<double, N> xs;
+    std::array<V, N> values;
+    int count = 0;
+    int next = 0;
+};
+
+/*
+* event_query -- one evaluation an event_search asks for
+*
+* The value and derivative at <x> of function number <function> of the
+* batch function (see event_search).
+*
+*/
+
+struct event_query {
+    int function;
+    double x;
+};
+
+/*
+* event_lane -- one interval an event_search brackets
+*
+* Roots of function number <function> between <x1> and <x2>, stepped
+* through as <rate> allows (see event_search).
+*
+*/
+
+struct event_lane {
+    int function;
+    double x1;
+    double x2;
+    bracket_rate rate;
+};
+
+/*
+* event_search -- lock-step bracketing and refinement over many lanes
+*
+* The batch function <fxs> is called as fxs (queries, n, f, df), and fills
+* f[i] and df[i] (df/dx) for each of the n queries. It is given every point
+* of a round at once, so it can share work between queries at the same x
+* and read the ephemeris for all of them in one pass.
+*
+* bracket () steps every lane from x1 to x2, the lanes advancing together,
+* one call of <fxs> per round. From a point where f is v from its nearest
+* sign change (0, or the jump of a wrapped angle), f cannot reach it within
+* v / max_rate, so the lane's next point is that far on, kept between
+* min_step and max_step; a step over which f changes sign is a bracket.
+* While |f'| stays below max_rate, the only roots missed are pairs closer
+* together than min_step. confirm () evaluates the ends of the brackets
+* again and drops those whose ends no longer differ in sign (for
+* bracketing done at reduced precision). refine () takes Newton steps on
+* all brackets together, one call per round, starting from the end where
+* |f| is smaller and narrowing each bracket with every evaluation. Where a
+* step leaves the bracket or does not halve |f|, the next point bisects
+* the bracket. A bracket is done when the step, or half its width, is
+* within 2 eps |x| + tol / 2. A bracket across the jump of a wrapped angle
+* is refined on the angle shifted by half a period, which is continuous
+* there. roots (lane) then holds the roots found in that lane, in
+* increasing order. A root is reported at the last point evaluated
+* (within the tolerance of where the next step would land), so a batch
+* function that keeps what it computed has the root's values at hand.
+*
+* The roots of a lane do not depend on which other lanes share its rounds,
+* provided each value <fxs> returns depends only on its query.
+*
+*/
+
+class event_search {
+public:
+    explicit event_search (std::vector<event_lane> lanes) : lanes (std::move (lanes)), lane_roots (this->lanes.size ()) {}
+
+    template <typename F>
+    void bracket (F & fxs);
+
+    template <typename F>
+    void confirm (F & fxs);
+
+    template <typename F>
+    void refine (F & fxs, const double tol);
+
+    std::size_t size () const {
+        return lanes.size ();
+    }
+
+    std::vector<double> const & roots (std::size_t lane) const {
+        return lane_roots[lane];
+    }
+
+    long evaluations = 0;
+    long rounds = 0;
+
+private:
+    struct found_bracket {
+        std::size_t lane;
+        double x1, x2;
+        double f1, f2;
+        double df1, df2;
+    };
+
+    template <typename F>
+    void evaluate (F & fxs) {
+        f.resize (queries.size ());
+        df.resize (queries.size ());
+        if (!queries.empty ())
+            fxs (queries.data (), queries.size (), f.data (), df.data ());
+        evaluations += (long)queries.size ();
+        ++rounds;
+    }
+
+    std::vector<event_lane> lanes;
+    std::vector<found_bracket> brackets;
+    std::vector<std::vector<double>> lane_roots;
+
+    std::vector<event_query> queries;
+    std::vector<double> f, df;
+};
+
+template <typename F>
+void event_search::bracket (F & fxs) {
+    struct stepper {
+        std::size_t lane;
+        double x, f, df;
+    };
+
+    brackets.clear ();
+    queries.clear ();
+    for (auto const & lane : lanes)
+        queries.push_back ({ lane.function, lane.x1 });
+    evaluate (fxs);
+
+    std::vector<stepper> active;
+    for (std::size_t l = 0; l < lanes.size (); ++l) {
+        if (lanes[l].x1 < lanes[l].x2)
+            active.push_back ({ l, lanes[l].x1, f[l], df[l] });
+    }
+
+    while (!active.empty ()) {
+        queries.clear ();
+        for (auto const & s : active) {
+            event_lane const & lane = lanes[s.lane];
+            double gap = std::abs (s.f);
+            if (lane.rate.wrap > 0.0)
+                gap = std::min (gap, 0.5 * lane.rate.wrap - gap);
+            double step = std::clamp (gap / lane.rate.max_rate, lane.rate.min_step, lane.rate.max_step);
+            queries.push_back ({ lane.function, lane.x2 - s.x > step ? s.x + step : lane.x2 });
+        }
+        evaluate (fxs);
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < active.size (); ++i) {
+            stepper s = active[i];
+            if (f[i]*s.f <= 0.0)
+                brackets.push_back ({ s.lane, s.x, queries[i].x, s.f, f[i], s.df, df[i] });
+            s.x = queries[i].x;
+            s.f = f[i];
+            s.df = df[i];
+            if (s.x < lanes[s.lane].x2)
+                active[kept++] = s;
+        }
+        active.resize (kept);
+    }
+}
+
+template <typename F>
+void event_search::confirm (F & fxs) {
+    queries.clear ();
+    for (auto const & b : brackets) {
+        queries.push_back ({ lanes[b.lane].function, b.x1 });
+        queries.push_back ({ lanes[b.lane].function, b.x2 });
+    }
+    evaluate (fxs);
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < brackets.size (); ++i) {
+        found_bracket b = brackets[i];
+        b.f1 = f[2 * i];
+        b.df1 = df[2 * i];
+        b.f2 = f[2 * i + 1];
+        b.df2 = df[2 * i + 1];
+        if (b.f1*b.f2 <= 0.0)
+            brackets[kept++] = b;
+    }
+    brackets.resize (kept);
+}
+
+template <typename F>
+void event_search::refine (F & fxs, const double tol) {
+    const int ITMAX = 100;
+    const double EPS = std::numeric_limits<double>::epsilon ();
+
+    struct refinement {
+        std::size_t lane;
+        double wrap;    // 0, or the period when refined on the shifted angle
+        double xneg, xpos;
+        double x, f, df;
+        bool bisect;
+    };
+
+    auto value = [] (double wrap, double fx) {
+        return wrap > 0.0 ? (fx > 0.0 ? fx - 0.5*wrap : fx + 0.5*wrap) : fx;
+    };
+
+    for (auto & roots : lane_roots)
+        roots.clear ();
+
+    std::vector<refinement> active;
+    for (auto const & b : brackets) {
+        const double wrap = lanes[b.lane].rate.wrap;
+        const double shift = wrap > 0.0 && std::abs (b.f1) > 0.25*wrap && std::abs (b.f2) > 0.25*wrap ? wrap : 0.0;
+        const double v1 = value (shift, b.f1), v2 = value (shift, b.f2);
+        if ((v1 > 0.0 && v2 > 0.0) || (v1 < 0.0 && v2 < 0.0))
+            continue;
+        if (v1 == 0.0 || v2 == 0.0) {
+            lane_roots[b.lane].push_back (v1 == 0.0 ? b.x1 : b.x2);
+            continue;
+        }
+        const bool from_x1 = std::abs (v1) <= std::abs (v2);
+        active.push_back ({ b.lane, shift, v1 < 0.0 ? b.x1 : b.x2, v1 < 0.0 ? b.x2 : b.x1,
+                            from_x1 ? b.x1 : b.x2, from_x1 ? v1 : v2, from_x1 ? b.df1 : b.df2, false });
+    }
+
+    for (int iter = 0; !active.empty (); iter++) {
+        if (iter == ITMAX)
+            throw("Maximum number of iterations exceeded in event_search");
+
+        // Each bracket either converges here or asks for one more point.
+        std::vector<refinement> stepping;
+        queries.clear ();
+        for (auto r : active) {
+            double xn = 0.5*(r.xneg + r.xpos);
+            bool newton = false;
+            if (!r.bisect && r.df != 0.0) {
+                const double dx = r.f / r.df;
+                if ((r.x - dx - r.xneg)*(r.x - dx - r.xpos) <= 0.0) {
+                    xn = r.x - dx;
+                    newton = true;
+                    if (std::abs (dx) <= 2.0*EPS*std::abs (xn) + 0.5*tol) {
+                        lane_roots[r.lane].push_back (r.x);
+                        continue;
+                    }
+                }
+            }
+            if (!newton && 0.5*std::abs (r.xpos - r.xneg) <= 2.0*EPS*std::abs (xn) + 0.5*tol) {
+                lane_roots[r.lane].push_back (r.x);
+                continue;
+            }
+            stepping.push_back (r);
+            queries.push_back ({ lanes[r.lane].function, xn });
+        }
+        evaluate (fxs);
+
+        active.clear ();
+        for (std::size_t i = 0; i < stepping.size (); ++i) {
+            refinement r = stepping[i];
+            const double xn = queries[i].x, fn = value (r.wrap, f[i]);
+            if (fn == 0.0) {
+                lane_roots[r.lane].push_back (xn);
+                continue;
+            }
+            if (fn < 0.0)
+                r.xneg = xn;
+            else
+                r.xpos = xn;
+            r.bisect = std::abs (fn) > 0.5*std::abs (r.f);
+            r.x = xn;
+            r.f = fn;
+            r.df = df[i];
+            active.push_back (r);
+        }
+    }
+
+    for (auto & roots : lane_roots)
+        std::sort (roots.begin (), roots.end ());
+}
+
+#endif
@@ -1,17 +1,40 @@
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include "slurp_file.h"
 
 #include "finals_data_handler.h"
 
 using finals::DNAN;
 
-finals_data_handler::finals_data_handler () {}
+finals_data_handler::finals_data_handler () :
+	table (std::make_shared<const finals_table> (std::vector<finals_data> ())), generation (1) {}
 
 finals_data_handler::~finals_data_handler () {}
 
+std::shared_ptr<const finals_table> finals_data_handler::snapshot () const {
+	return std::atomic_load (&table);
+}
+
+// publish: replaces the table. The store comes before the generation is bumped, so a thread that sees the new
+// generation also sees the new table (or a later one).
+
+void finals_data_handler::publish (std::shared_ptr<const finals_table> next) {
+	std::atomic_store (&table, std::move (next));
+	generation.fetch_add (1, std::memory_order_release);
+}
+
 /*
 The format of the finals.data, finals.daily, and finals.all files is:
 
@@ -54,98 +77,362 @@ Col.#    Format  Quantity
 */
 
 
-double fd_extract_double (std::string& number_holder, std::string const& filestr, size_t offset, int length) {
-	number_holder.replace (0, length, filestr, offset, length);
-	number_holder.resize (length);
-	return std::stod (number_holder);
+// fd_extract_double: reads the fixed-width field of 'length' characters at 'offset' as std::stod would read a copy of it
+// (leading white space and a '+' skipped, then the longest number), without copying it. Returns false, leaving 'value'
+// unchanged, where stod would throw: no number, a number out of range, or an offset past the end.
+
+static bool fd_extract_double (std::string_view filestr, size_t offset, int length, double& value) {
+	if (offset > filestr.size ()) {
+		return false;
+	}
+
+	std::string_view field = filestr.substr (offset, length);
+	const char* first = field.data ();
+	const char* last = first + field.size ();
+
+	while (first != last && std::isspace ((unsigned char)*first)) {
+		++first;
+	}
+	if (first != last && *first == '+' && (first + 1 == last || first[1] != '-')) {
+		++first;
+	}
+
+	return std::from_chars (first, last, value).ec == std::errc ();
 }
 
-bool fd_extract_prediction_flag (std::string const& filestr, size_t offset) {
-	char prediction_flag = filestr[offset];
+static bool fd_extract_prediction_flag (std::string_view filestr, size_t offset, bool& is_prediction) {
+	char prediction_flag = offset < filestr.size () ? filestr[offset] : '\0';
 	if (prediction_flag == 'I') {
-		return false;
+		is_prediction = false;
+		return true;
 	}
 	else if (prediction_flag == 'P') {
+		is_prediction = true;
 		return true;
 	}
-	throw std::runtime_error (std::string ("error while parsing prediction flag: got '") + prediction_flag + "'");
+	return false;
 }
 
 void finals_data_handler::parse_finals_data (std::string const& finals_data_str) {
+	publish (parse_finals_table (finals_data_str));
+}
 
-	std::string number_holder;
+// parse_finals_table: the table of the rows of 'finals_data_str'; throws if the first lines do not parse.
+
+std::shared_ptr<const finals_table> finals_data_handler::parse_finals_table (std::string const& finals_data_str) {
+
+	std::string_view data (finals_data_str);
 
 	long linenum = 0;
 
-	finals_data_values.clear ();
+	std::vector<finals_data> finals_data_values;
+	finals_data_values.reserve (std::count (data.begin (), data.end (), '\n'));
+
+	size_t offset = 0;
+	size_t oldoffset = 0;
+
+	while (offset != std::string::npos) {
+		offset = data.find ('\n', oldoffset);
+		if (offset == std::string::npos) break;
+
+		++linenum;
+
+		finals_data fd;
+		double mjd = 0;
+
+		// Columns are 1-based in the table above; offsets are 0-based.
+		const char* failed = nullptr;
+
+		// 8-15     F8.2    fractional Modified Julian Date (MJD UTC)
+		if (!fd_extract_double (data, oldoffset + 7, 8, mjd)) failed = "MJD (columns 8-15)";
+		// 17       A1      IERS (I) or Prediction (P) flag for Bull. A polar motion values
+		else if (!fd_extract_prediction_flag (data, oldoffset + 16, fd.pm_is_prediction)) failed = "polar motion prediction flag (column 17)";
+		// 19-27    F9.6    Bull. A PM-x (sec. of arc)
+		else if (!fd_extract_double (data, oldoffset + 18, 9, fd.pm_x)) failed = "PM-x (columns 19-27)";
+		// 28-36    F9.6    error in PM-x (sec. of arc)
+		else if (!fd_extract_double (data, oldoffset + 27, 9, fd.pm_x_err)) failed = "PM-x error (columns 28-36)";
+		// 38-46    F9.6    Bull. A PM-y (sec. of arc)
+		else if (!fd_extract_double (data, oldoffset + 37, 9, fd.pm_y)) failed = "PM-y (columns 38-46)";
+		// 47-55    F9.6    error in PM-y (sec. of arc)
+		else if (!fd_extract_double (data, oldoffset + 46, 9, fd.pm_y_err)) failed = "PM-y error (columns 47-55)";
+		// 58       A1      IERS (I) or Prediction (P) flag for Bull. A UT1-UTC values
+		else if (!fd_extract_prediction_flag (data, oldoffset + 57, fd.ut1_utc_is_prediction)) failed = "UT1-UTC prediction flag (column 58)";
+		// 59-68    F10.7   Bull. A UT1-UTC (sec. of time)
+		else if (!fd_extract_double (data, oldoffset + 58, 10, fd.ut1_utc)) failed = "UT1-UTC (columns 59-68)";
+		// 69-78    F10.7   error in UT1-UTC (sec. of time)
+		else if (!fd_extract_double (data, oldoffset + 68, 10, fd.ut1_utc_err)) failed = "UT1-UTC error (columns 69-78)";
+
+		if (failed) {
+			// No UT1-UTC, time to stop parsing.
+			// If we're in the first few lines of the file, something is very wrong...
+			if (linenum < 10) {
+				throw std::runtime_error (std::string ("Error: could not parse ") + failed + " (line " + std::to_string (linenum) + ")");
+			}
+			break;
+		}
+
+		// MJD = JD - 2400000.5; see http://tycho.usno.navy.mil/mjd.html
+		// The half day is subtracted so that the day starts at midnight in conformance with civil time reckoning.
+		fd.julian_utc = 2400000.50 + mjd;
 
-	try {
+		// We don't care about not getting an epsilon value.
+		// 117 - 125  F9.3    Bull.A dEPSILON(msec.of arc)
+		// 126 - 134  F9.3    error in dEPSILON(msec.of arc)
+		if (fd_extract_double (data, oldoffset + 116, 9, fd.epsilon)) {
+			fd_extract_double (data, oldoffset + 125, 9, fd.epsilon_err);
+		}
 
-		number_holder.reserve (64);
+		oldoffset = offset + 1;
 
-		size_t offset = 0;
-		size_t oldoffset = 0;
+		finals_data_values.push_back (fd);
+	}
 
-		while (offset != std::string::npos) {
-			offset = finals_data_str.find ('\n', oldoffset);
-			if (offset == std::string::npos) break;
+	return std::make_shared<const finals_table> (std::move (finals_data_values));
+}
 
-			++linenum;
+// finals_table: indexes the days from the earliest row to the latest, so that finals_data_for_time finds the row for a
+// date by subtraction. A day may have no row (day_rows holds -1); where a day has several, the first is used, as a
+// search from the start of the table would find it.
 
-			finals_data fd;
+finals_table::finals_table (std::vector<finals_data> rows) : finals_data_values (std::move (rows)), day_origin (0) {
 
-			// 8-15     F8.2    fractional Modified Julian Date (MJD UTC)
-			// MJD = JD - 2400000.5; see http://tycho.usno.navy.mil/mjd.html
-			// The half day is subtracted so that the day starts at midnight in conformance with civil time reckoning.
-			fd.julian_utc = 2400000.50 + fd_extract_double (number_holder, finals_data_str, oldoffset + 7, 8);
+	auto by_date = [](finals_data const& a, finals_data const& b) { return a.julian_utc < b.julian_utc; };
 
-			// 17       A1      IERS (I) or Prediction (P) flag for Bull. A polar motion values
-			fd.pm_is_prediction = fd_extract_prediction_flag (finals_data_str, oldoffset + 16);
-			// 19-27    F9.6    Bull. A PM-x (sec. of arc)
-			fd.pm_x = fd_extract_double (number_holder, finals_data_str, oldoffset + 18, 9);
-			// 28-36    F9.6    error in PM-x (sec. of arc)
-			fd.pm_x_err = fd_extract_double (number_holder, finals_data_str, oldoffset + 27, 9);
-			// 38-46    F9.6    Bull. A PM-y (sec. of arc)
-			fd.pm_y = fd_extract_double (number_holder, finals_data_str, oldoffset + 37, 9);
-			// 47-55    F9.6    error in PM-y (sec. of arc)
-			fd.pm_y_err = fd_extract_double (number_holder, finals_data_str, oldoffset + 46, 9);
+	if (!std::is_sorted (finals_data_values.begin (), finals_data_values.end (), by_date)) {
+		std::stable_sort (finals_data_values.begin (), finals_data_values.end (), by_date);
+	}
 
-			// 58       A1      IERS (I) or Prediction (P) flag for Bull. A UT1-UTC values
-			fd.ut1_utc_is_prediction = fd_extract_prediction_flag (finals_data_str, oldoffset + 57);
-			// 59-68    F10.7   Bull. A UT1-UTC (sec. of time)
-			fd.ut1_utc = fd_extract_double (number_holder, finals_data_str, oldoffset + 58, 10);
-			// 69-78    F10.7   error in UT1-UTC (sec. of time)
-			fd.ut1_utc_err = fd_extract_double (number_holder, finals_data_str, oldoffset + 68, 10);
+	if (finals_data_values.empty ()) {
+		return;
+	}
 
-			try {
-				// 117 - 125  F9.3    Bull.A dEPSILON(msec.of arc)
-				fd.epsilon = fd_extract_double (number_holder, finals_data_str, oldoffset + 116, 9);
-				// 126 - 134  F9.3    error in dEPSILON(msec.of arc)
-				fd.epsilon_err = fd_extract_double (number_holder, finals_data_str, oldoffset + 125, 9);
+	auto [earliest, latest] = std::minmax_element (finals_data_values.begin (), finals_data_values.end (), by_date);
 
-			}
-			catch (std::exception& e) {
-				(void)e;
-				// We don't care about not getting an epsilon value.
-			}
+	// Days start at 0h UTC, JD n + 0.5.
+	day_origin = std::round (earliest->julian_utc - 0.5) + 0.5;
+	day_rows.assign ((std::size_t)std::llround (latest->julian_utc - day_origin) + 1, -1);
 
-			oldoffset = offset + 1;
+	for (std::size_t i = 0; i < finals_data_values.size (); ++i) {
+		const double jd = finals_data_values[i].julian_utc;
+		const long long day = std::llround (jd - day_origin);
+		if (std::abs (jd - (day_origin + (double)day)) < 0.001 && day_rows[(std::size_t)day] < 0) {
+			day_rows[(std::size_t)day] = (long)i;
+		}
+	}
+}
 
-			finals_data_values.push_back (fd);
+/*
+The finals cache file holds a finals_cache_header and then one finals_cache_row per row, in the byte order of the
+machine that wrote it (a cache is read where it was written). The header records the text file it was parsed from and
+a checksum of the rows.
+*/
 
+namespace {
+
+	const char finals_cache_magic[8] = { 'F', 'I', 'N', 'A', 'L', 'S', 'C', '\0' };
+	const std::uint32_t finals_cache_version = 1;
+
+	struct finals_cache_header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t row_size;
+		std::uint64_t source_size;
+		std::int64_t source_mtime;
+		std::uint64_t rows;
+		std::uint64_t checksum;
+	};
+
+	struct finals_cache_row {
+		double julian_utc;
+		double pm_x;
+		double pm_x_err;
+		double pm_y;
+		double pm_y_err;
+		double ut1_utc;
+		double ut1_utc_err;
+		double epsilon;
+		double epsilon_err;
+		std::uint8_t pm_is_prediction;
+		std::uint8_t ut1_utc_is_prediction;
+		std::uint8_t unused[6];
+	};
+
+	struct file_stamp {
+		std::uint64_t size;
+		std::int64_t mtime;
+	};
+
+	bool stamp_of (std::string const& filepath, file_stamp& stamp) {
+		struct stat st;
+		if (stat (filepath.c_str (), &st) != 0) {
+			return false;
 		}
+		stamp.size = (std::uint64_t)st.st_size;
+		stamp.mtime = (std::int64_t)st.st_mtime;
+		return true;
 	}
-	catch (std::exception& e) {
-		// No UT1-UTC, time to stop parsing.
-		// If we're in the first few lines of the file, something is very wrong...
-		if (linenum < 10) {
-			throw std::runtime_error (std::string ("Error: ") + e.what () + " (line " + std::to_string (linenum) + ")");
+
+	// FNV-1a taken a 64-bit word at a time; rows are a whole number of words.
+	std::uint64_t fnv1a (const char* data, std::size_t size) {
+		static_assert (sizeof (finals_cache_row) % sizeof (std::uint64_t) == 0, "rows must be whole words");
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i + sizeof (std::uint64_t) <= size; i += sizeof (std::uint64_t)) {
+			std::uint64_t word;
+			std::memcpy (&word, data + i, sizeof (word));
+			hash ^= word;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::string cache_path_for (std::string const& filepath) {
+		return filepath + ".cache";
+	}
+
+}
+
+finals_view finals_table::view () const {
+	const finals_data* first = finals_data_values.data ();
+	return finals_view (shared_from_this (), first, first + finals_data_values.size ());
+}
+
+finals_view finals_view::between (double jd_begin, double jd_end) const {
+	const finals_data* lo = std::lower_bound (first, last, jd_begin, [](finals_data const& fd, double jd) { return fd.julian_utc < jd; });
+	const finals_data* hi = std::lower_bound (lo, last, jd_end, [](finals_data const& fd, double jd) { return fd.julian_utc < jd; });
+	return finals_view (table, lo, std::max (lo, hi));
+}
+
+// load_finals_cache: reads the table from the cache of 'filepath' if it was written from the file as it is now; returns
+// null otherwise.
+
+std::shared_ptr<const finals_table> finals_data_handler::load_finals_cache (std::string const& filepath) {
+
+	file_stamp source;
+	if (!stamp_of (filepath, source)) {
+		return nullptr;
+	}
+
+	mapped_file cache (cache_path_for (filepath));
+	if (!cache.data () || cache.size () < sizeof (finals_cache_header)) {
+		return nullptr;
+	}
+
+	finals_cache_header header;
+	std::memcpy (&header, cache.data (), sizeof (header));
+
+	if (std::memcmp (header.magic, finals_cache_magic, sizeof (header.magic)) != 0 ||
+		header.version != finals_cache_version || header.row_size != sizeof (finals_cache_row) ||
+		header.source_size != source.size || header.source_mtime != source.mtime ||
+		header.rows != (cache.size () - sizeof (header)) / sizeof (finals_cache_row) ||
+		cache.size () != sizeof (header) + header.rows * sizeof (finals_cache_row)) {
+		return nullptr;
+	}
+
+	const char* rows = cache.data () + sizeof (header);
+	if (fnv1a (rows, (std::size_t)header.rows * sizeof (finals_cache_row)) != header.checksum) {
+		return nullptr;
+	}
+
+	std::vector<finals_data> finals_data_values;
+	finals_data_values.reserve ((std::size_t)header.rows);
+
+	for (std::uint64_t i = 0; i < header.rows; ++i) {
+		finals_cache_row row;
+		std::memcpy (&row, rows + i * sizeof (finals_cache_row), sizeof (row));
+
+		finals_data fd;
+		fd.julian_utc = row.julian_utc;
+		fd.pm_is_prediction = row.pm_is_prediction != 0;
+		fd.pm_x = row.pm_x;
+		fd.pm_x_err = row.pm_x_err;
+		fd.pm_y = row.pm_y;
+		fd.pm_y_err = row.pm_y_err;
+		fd.ut1_utc_is_prediction = row.ut1_utc_is_prediction != 0;
+		fd.ut1_utc = row.ut1_utc;
+		fd.ut1_utc_err = row.ut1_utc_err;
+		fd.epsilon = row.epsilon;
+		fd.epsilon_err = row.epsilon_err;
+		finals_data_values.push_back (fd);
+	}
+
+	return std::make_shared<const finals_table> (std::move (finals_data_values));
+}
+
+// write_finals_cache: saves the rows of 'table' as the cache of 'filepath'. The cache is written to a temporary file and renamed
+// over the old one, so that a reader never maps a partial cache; any failure leaves no cache behind.
+
+void finals_data_handler::write_finals_cache (std::string const& filepath, finals_table const& table) const {
+
+	file_stamp source;
+	if (!stamp_of (filepath, source)) {
+		return;
+	}
+
+	std::vector<finals_data> const& finals_data_values = table.values ();
+	std::vector<finals_cache_row> rows (finals_data_values.size ());
+	for (std::size_t i = 0; i < rows.size (); ++i) {
+		finals_data const& fd = finals_data_values[i];
+		finals_cache_row& row = rows[i];
+		std::memset (&row, 0, sizeof (row));
+		row.julian_utc = fd.julian_utc;
+		row.pm_x = fd.pm_x;
+		row.pm_x_err = fd.pm_x_err;
+		row.pm_y = fd.pm_y;
+		row.pm_y_err = fd.pm_y_err;
+		row.ut1_utc = fd.ut1_utc;
+		row.ut1_utc_err = fd.ut1_utc_err;
+		row.epsilon = fd.epsilon;
+		row.epsilon_err = fd.epsilon_err;
+		row.pm_is_prediction = fd.pm_is_prediction ? 1 : 0;
+		row.ut1_utc_is_prediction = fd.ut1_utc_is_prediction ? 1 : 0;
+	}
+
+	finals_cache_header header;
+	std::memset (&header, 0, sizeof (header));
+	std::memcpy (header.magic, finals_cache_magic, sizeof (header.magic));
+	header.version = finals_cache_version;
+	header.row_size = sizeof (finals_cache_row);
+	header.source_size = source.size;
+	header.source_mtime = source.mtime;
+	header.rows = rows.size ();
+	header.checksum = fnv1a ((const char*)rows.data (), rows.size () * sizeof (finals_cache_row));
+
+	const std::string cache_path = cache_path_for (filepath);
+	const std::string temp_path = cache_path + ".tmp";
+
+	{
+		std::ofstream ofs (temp_path.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!ofs.is_open ()) {
+			return;
+		}
+		ofs.write ((const char*)&header, sizeof (header));
+		ofs.write ((const char*)rows.data (), (std::streamsize)(rows.size () * sizeof (finals_cache_row)));
+		if (!ofs.good ()) {
+			ofs.close ();
+			std::remove (temp_path.c_str ());
+			return;
+		}
+	}
+
+	if (std::rename (temp_path.c_str (), cache_path.c_str ()) != 0) {
+		// Windows does not rename over an existing file.
+		std::remove (cache_path.c_str ());
+		if (std::rename (temp_path.c_str (), cache_path.c_str ()) != 0) {
+			std::remove (temp_path.c_str ());
 		}
 	}
 }
 
 void finals_data_handler::load_finals_data_from_file (std::string const& filepath) {
-	parse_finals_data (slurpfile (filepath));
+
+	if (std::shared_ptr<const finals_table> cached = load_finals_cache (filepath)) {
+		publish (std::move (cached));
+		return;
+	}
+
+	std::shared_ptr<const finals_table> parsed = parse_finals_table (slurpfile (filepath));
+	publish (parsed);
+	write_finals_cache (filepath, *parsed);
 }
 
 inline double mix (const double interp_factor, const double start, const double end) {
@@ -154,6 +441,21 @@ inline double mix (const double interp_factor, const double start, const double
 
 finals_data finals_data_handler::finals_data_for_time (double jd_utc) {
 
+	// The table this thread last read, and the generation it was read at.
+	thread_local std::shared_ptr<const finals_table> local_table;
+	thread_local std::uint64_t local_generation = 0;
+
+	const std::uint64_t current = generation.load (std::memory_order_acquire);
+	if (current != local_generation) {
+		local_table = snapshot ();
+		local_generation = current;
+	}
+
+	return local_table->finals_data_for_time (jd_utc);
+}
+
+finals_data finals_table::finals_data_for_time (double jd_utc) const {
+
 	finals_data rv;
 
 	rv.julian_utc = jd_utc;
@@ -172,15 +474,21 @@ finals_data finals_data_handler::finals_data_for_time (double jd_utc) {
 		//key1 = base_val + 1.0;
 	}
 	
-	std::vector<finals_data>::iterator it = std::find_if (finals_data_values.begin (), finals_data_values.end (), [key0](finals_data fd)->bool {
-		return std::abs (fd.julian_utc - key0) < 0.001;
-		}
-	);
+	// key0 is 0h UTC of the day, as are the rows, so the offset from day_origin is a whole number of days.
+	const double day = key0 - day_origin;
 
-	if (it == finals_data_values.end ()) {
+	if (!(day >= 0.0 && day < (double)day_rows.size ())) {
 		return rv;
 	}
 
+	const long row = day_rows[(std::size_t)day];
+
+	if (row < 0) {
+		return rv;
+	}
+
+	std::vector<finals_data>::const_iterator it = finals_data_values.begin () + row;
+
 	if((it+1) == finals_data_values.end ()) {
 		return rv;
 	}
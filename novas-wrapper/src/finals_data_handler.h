@@ -1,4 +1,10 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
 #include <vector>
 #include <cmath>
 
@@ -32,6 +38,108 @@ struct finals_data {
 
 };
 
+class finals_table;
+
+// finals_is_prediction: true for a row whose polar motion or UT1-UTC is a prediction rather than an IERS value.
+struct finals_is_prediction {
+    bool operator() (finals_data const & fd) const { return fd.pm_is_prediction || fd.ut1_utc_is_prediction; }
+};
+
+// finals_filter: the rows of a range that satisfy 'Predicate', visited in place.
+template <typename Predicate>
+class finals_filter {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = finals_data;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const finals_data*;
+        using reference = const finals_data&;
+
+        iterator (const finals_data* pos, const finals_data* last, Predicate const* pred) : pos (pos), last (last), pred (pred) { skip (); }
+
+        reference operator* () const { return *pos; }
+        pointer operator-> () const { return pos; }
+        iterator& operator++ () { ++pos; skip (); return *this; }
+        iterator operator++ (int) { iterator rv = *this; ++*this; return rv; }
+        bool operator== (iterator const & other) const { return pos == other.pos; }
+        bool operator!= (iterator const & other) const { return pos != other.pos; }
+
+    private:
+        void skip () { while (pos != last && !(*pred) (*pos)) ++pos; }
+
+        const finals_data* pos;
+        const finals_data* last;
+        Predicate const* pred;
+    };
+
+    finals_filter (const finals_data* first, const finals_data* last, Predicate pred) : first (first), last (last), pred (std::move (pred)) {}
+
+    iterator begin () const { return iterator (first, last, &pred); }
+    iterator end () const { return iterator (last, last, &pred); }
+
+private:
+    const finals_data* first;
+    const finals_data* last;
+    Predicate pred;
+};
+
+// finals_view: a contiguous run of the rows of a table, in date order, read in place. The view shares ownership of the
+// table, so its rows stay valid (and unchanged) while it lives, whatever the finals_data_handler loads meanwhile.
+class finals_view {
+public:
+    using const_iterator = const finals_data*;
+
+    finals_view () : first (nullptr), last (nullptr) {}
+    finals_view (std::shared_ptr<const finals_table> table, const finals_data* first, const finals_data* last) :
+        table (std::move (table)), first (first), last (last) {}
+
+    const_iterator begin () const { return first; }
+    const_iterator end () const { return last; }
+    std::size_t size () const { return (std::size_t)(last - first); }
+    bool empty () const { return first == last; }
+    finals_data const & operator[] (std::size_t i) const { return first[i]; }
+    finals_data const & front () const { return *first; }
+    finals_data const & back () const { return *(last - 1); }
+
+    // between: the rows dated from 'jd_begin' up to, but not including, 'jd_end' (UTC), found by bisection.
+    finals_view between (double jd_begin, double jd_end) const;
+
+    // where: the rows for which 'pred' is true, without copying them; predictions: where (finals_is_prediction ()).
+    template <typename Predicate>
+    finals_filter<Predicate> where (Predicate pred) const { return finals_filter<Predicate> (first, last, std::move (pred)); }
+    finals_filter<finals_is_prediction> predictions () const { return where (finals_is_prediction ()); }
+
+private:
+    std::shared_ptr<const finals_table> table;
+    const finals_data* first;
+    const finals_data* last;
+};
+
+// finals_table: the rows of one finals file and the index of their days. A table is never changed once published by
+// the finals_data_handler, so a reader holding one can use it from any thread for as long as it likes. The rows are
+// kept in date order (finals files are written in that order; a file that is not is sorted, stably).
+class finals_table : public std::enable_shared_from_this<finals_table> {
+public:
+    explicit finals_table (std::vector<finals_data> rows);
+
+    finals_data finals_data_for_time (double jd_utc) const;
+
+    std::vector<finals_data> const& values () const { return finals_data_values; }
+
+    // view: all the rows, as a view that keeps this table alive.
+    finals_view view () const;
+
+private:
+    std::vector<finals_data> finals_data_values;
+
+    // Rows are daily, at 0h UTC. day_rows[d] is the index of the row for day_origin + d, or -1 where the file has no
+    // row for that day.
+    double day_origin;
+    std::vector<long> day_rows;
+};
+
 class finals_data_handler {
 public:
     static finals_data_handler& instance () {
@@ -44,15 +152,37 @@ public:
     finals_data_handler& operator=(finals_data_handler const&) = delete;
     finals_data_handler& operator=(finals_data_handler &&) = delete;
 
+    // load_finals_data_from_file: loads the finals file at 'filepath'. The rows parsed are saved beside it, in
+    // 'filepath' + ".cache", with the size and modification time of the text file and a checksum; later loads map the
+    // cache instead of parsing the text, unless the text file has changed or the cache does not check out. A cache that
+    // cannot be written is skipped.
+    //
+    // Loading (or parsing) builds a new table and then publishes it in place of the current one, so a process can load
+    // the weekly update while other threads look up dates: a lookup sees either the old table or the new one, never a
+    // mix. If the file does not parse, the current table is kept.
     void load_finals_data_from_file (std::string const & filepath);
     void parse_finals_data (std::string const & finals_data_str);
 
     finals_data finals_data_for_time (double jd_utc);
 
-	inline std::vector<finals_data> values () { return finals_data_values;  }
+    // snapshot: the current table. It stays valid, and unchanged, while the pointer is held, whatever is loaded since.
+    // Never null; empty before the first load.
+    std::shared_ptr<const finals_table> snapshot () const;
+
+    // values: the rows of the current table, without copying them.
+    inline finals_view values () const { return snapshot ()->view (); }
 
 private:
-    std::vector<finals_data> finals_data_values;
+    static std::shared_ptr<const finals_table> parse_finals_table (std::string const & finals_data_str);
+    void publish (std::shared_ptr<const finals_table> next);
+    std::shared_ptr<const finals_table> load_finals_cache (std::string const & filepath);
+    void write_finals_cache (std::string const & filepath, finals_table const & table) const;
+
+    // The published table, read and replaced with the atomic shared_ptr functions. generation counts the tables
+    // published; each thread keeps the table it last read and reloads it only when generation has moved on, so a
+    // lookup between reloads touches no shared reference count.
+    std::shared_ptr<const finals_table> table;
+    std::atomic<std::uint64_t> generation;
     finals_data_handler ();
     ~finals_data_handler ();
 };
@@ -2,8 +2,15 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
-
-#include "zbrent.h"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "event_search.h"
+#include "chebyshev_proxy.h"
+#include "ephemeris.h"
 #include "novas_wrapper.h"
 #include "astro_calc.h"
 #include "vec3.h"
@@ -12,6 +19,706 @@
 
 const double finder_tolerance = std::numeric_limits<double>::epsilon() * 100;
 
+const double sidereal_rate = 360.98564736629; // the Earth's rotation, degrees per day
+
+const double polish_window = 30.0 / 86400.0; // largest correction, in days, the many-observer search makes on place()
+
+// The Chebyshev proxies of the event_root_finder::chebyshev_proxy searches: the elevation and azimuth of a day on
+// 'planetary_proxy_nodes' nodes, the Moon's phase longitude in pieces of 'moon_phase_proxy_piece' days on
+// 'moon_phase_proxy_nodes' nodes.
+const int planetary_proxy_nodes = 24;
+const double moon_phase_proxy_piece = 30.0;
+const int moon_phase_proxy_nodes = 12;
+
+// Runs 'search': brackets with the batch function 'screen_fxs' at single precision where ephemeris::load_single has
+// copied the ephemeris, then refines with 'fxs' at full precision. A bracket that does not hold at full precision (an
+// end within the coefficient error of a root) would not have been found by a full-precision pass, and is dropped; with
+// 'always_confirm', the brackets are confirmed on 'fxs' however they were found, for a 'screen_fxs' that approximates it.
+template <typename B, typename F>
+static void run_event_search(event_search &search, B &screen_fxs, F &fxs, bool always_confirm)
+{
+    bool reduced = false;
+
+    {
+        ephemeris_precision_scope screening(ephemeris_precision::single);
+        search.bracket(screen_fxs);
+        reduced = screening.reduced();
+    }
+
+    if (reduced || always_confirm)
+        search.confirm(fxs);
+
+    search.refine(fxs, finder_tolerance);
+}
+
+template <typename F>
+static void run_event_search(event_search &search, F &fxs)
+{
+    run_event_search(search, fxs, fxs, false);
+}
+
+// Runs 'search' with the batch function 'fxs' as run_event_search does: fits the proxies at single precision where
+// ephemeris::load_single has copied the ephemeris (a proxy is no better than its fit anyway), then polishes their roots
+// at full precision.
+template <typename F>
+static void run_proxy_search(proxy_search &search, F &fxs)
+{
+    {
+        ephemeris_precision_scope screening(ephemeris_precision::single);
+        search.fit(fxs);
+    }
+
+    search.polish(fxs, finder_tolerance);
+}
+
+// The bounds of the days of [julian_utc_begin, julian_utc_end], the last one shorter. The rise/set searches bracket
+// each day on its own, serial and threaded alike, so that both find the same brackets.
+static std::vector<double> search_days(const double julian_utc_begin, const double julian_utc_end)
+{
+    std::vector<double> bounds{julian_utc_begin};
+    for (int d = 1; julian_utc_begin + d < julian_utc_end; ++d)
+        bounds.push_back(julian_utc_begin + d);
+    bounds.push_back(julian_utc_end);
+    return bounds;
+}
+
+// The largest motion of 'planet' against the stars, in degrees per day, with some to spare; for the Moon, also the
+// daily swing of its parallax (up to a degree) seen from the Earth's surface.
+static double max_apparent_motion(novas_planet const &planet)
+{
+    switch (planet.id)
+    {
+    case novas_planet_id::MOON:
+        return 16.0 + 7.0;
+    case novas_planet_id::MERCURY:
+        return 2.5;
+    case novas_planet_id::VENUS:
+        return 1.5;
+    case novas_planet_id::SUN:
+        return 1.1;
+    case novas_planet_id::MARS:
+        return 1.0;
+    case novas_planet_id::JUPITER:
+        return 0.3;
+    case novas_planet_id::SATURN:
+        return 0.2;
+    default:
+        return 0.1;
+    }
+}
+
+bracket_rate novas_utils::elevation_bracket_rate(novas_planet planet, on_surface geo_loc)
+{
+    // The diurnal part of the elevation rate is at most the Earth's rotation times cos(latitude); refraction near the
+    // horizon steepens it by up to a fifth; a quarter leaves some to spare. Refraction stops at an observed zenith
+    // distance of 91 degrees, where the elevation jumps by the refraction there.
+    const double diurnal = sidereal_rate * std::cos(to_radians(geo_loc.latitude));
+    const double jump = novas_constants::refraction != 0 ? refract(&geo_loc, novas_constants::refraction, 91.0) : 0.0;
+    return {1.25 * (diurnal + max_apparent_motion(planet)), 1.0 / 96.0, 1.0 / 8.0, 0.0, jump};
+}
+
+bracket_rate novas_utils::azimuth_bracket_rate(novas_planet planet)
+{
+    // The azimuth turns at the Earth's rotation times sin(latitude) near the horizon, faster as the body climbs, and
+    // without bound at the zenith; there it crosses the meridian only once, which a long step still brackets.
+    return {2.0 * sidereal_rate + max_apparent_motion(planet), 1.0 / 96.0, 1.0 / 8.0, 360.0};
+}
+
+bracket_rate novas_utils::moon_phase_bracket_rate()
+{
+    // The Moon gains on the Sun by 12.2 degrees a day on average, 15.4 at most.
+    return {16.5, 0.25, 4.0, 360.0};
+}
+
+// Runs task(i, ctx) for every i below 'tasks' on up to 'threads' threads, the calling thread included. Each thread
+// reads the ephemeris through its own reader (see ephemeris::open_reader) and keeps NOVAS values in its own context
+// 'ctx', bound while it runs. The first exception thrown by a task is rethrown once every thread has stopped.
+template <typename F>
+static void run_on_workers(unsigned threads, std::size_t tasks, F &&task)
+{
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failure_mtx;
+
+    auto worker = [&]()
+    {
+        try
+        {
+            auto reader = ephemeris::instance().open_reader();
+            ephemeris_reader_binding reader_binding(*reader);
+            novas_wrapper::context ctx;
+            novas_wrapper::context_binding context_binding(ctx);
+
+            for (std::size_t i = next++; i < tasks; i = next++)
+                task(i, ctx);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lck(failure_mtx);
+            if (!failure)
+                failure = std::current_exception();
+            next = tasks;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min<std::size_t>(threads, tasks); ++t)
+        pool.emplace_back(worker);
+
+    worker();
+
+    for (auto &t : pool)
+        t.join();
+
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+// The elevation of the upper limb of 'planet', whose center is at 'hc' and 't_place'; it rises and sets at zero.
+static double upper_limb_el(novas_planet const &planet, novas_wrapper::horizon_coords const &hc, sky_pos const &t_place)
+{
+    double distance_to_obj = au_to_km(t_place.dis);
+    double actual_diameter_km = planet.diameter_km;
+    double planet_diameter = to_degrees(2 * std::atan(actual_diameter_km / (2 * distance_to_obj)));
+
+    // Moonrise occurs when EL is 90 degrees + Moon's apparent angular radius moon_app_radius, which varies between 0.245 and 0.279.
+    // "More" EL means "lower". But we've already subtracted from 90.
+    // hc.zd = 90 - hc.zd;
+
+    return hc.zd + planet_diameter / 2.0;
+}
+
+novas_utils::planetary_event_functions::planetary_event_functions(novas_planet planet, on_surface geo_loc) : planet(planet), geo_loc(geo_loc), planet_obj(build_planet_object(planet))
+{
+    // Need to get *topocentric* values for equ2hor to work correctly.
+    make_observer_on_surface(geo_loc.latitude, geo_loc.longitude, geo_loc.height, geo_loc.temperature, geo_loc.pressure, &surface_loc);
+}
+
+novas_utils::planetary_event_functions::state novas_utils::planetary_event_functions::state_at_time(double jd_utc_time)
+{
+    state s;
+    s.at = astro_time::from_utc(jd_utc_time);
+    s.t_place = novas_wrapper::w_place(s.at, planet_obj, surface_loc, novas_constants::coord_equ, novas_constants::accuracy);
+    auto [pm_x, pm_y] = s.at.polar_motion();
+    s.hc = novas_wrapper::w_equ2hor(s.at, s.t_place, novas_constants::accuracy, pm_x, pm_y, geo_loc, novas_constants::refraction);
+    return s;
+}
+
+// The rates, in degrees per day, of the elevation and azimuth of state 's'. The topocentric direction moves in right
+// ascension and declination with the body's geocentric velocity 'geo_vel' less the observer's, and the hour angle with
+// the sidereal time; equ2hor's projection (as in observer_event_functions::hc_from_sample) carries both to the horizon,
+// and the elevation rate is divided by 1 + dR/dz, R the refraction at the observed zenith distance.
+std::pair<double, double> novas_utils::planetary_event_functions::horizon_rates(state s, const double geo_vel[3])
+{
+    astro_time &at = s.at;
+    novas_wrapper::horizon_coords const &hc = s.hc;
+    sky_pos const &t_place = s.t_place;
+    double obs_pos[3], obs_vel[3];
+
+    const double gast = get_local_apparent_sidereal_time(at, 0.0);
+    terra(&geo_loc, gast, obs_pos, obs_vel);
+
+    double pos[3], vel[3];
+    for (int j = 0; j < 3; ++j)
+    {
+        pos[j] = t_place.r_hat[j] * t_place.dis;
+        vel[j] = geo_vel[j] - obs_vel[j];
+    }
+
+    const double rxy2 = pos[0] * pos[0] + pos[1] * pos[1];
+    const double r2 = rxy2 + pos[2] * pos[2];
+    const double ra_rate = (pos[0] * vel[1] - pos[1] * vel[0]) / rxy2;
+    const double dec_rate = (vel[2] * rxy2 - pos[2] * (pos[0] * vel[0] + pos[1] * vel[1])) / (r2 * std::sqrt(rxy2));
+    const double lha_rate = to_radians(sidereal_rate) - ra_rate;
+
+    const double lat = to_radians(geo_loc.latitude);
+    const double dec = to_radians(t_place.dec);
+    const double lha = to_radians((gast - t_place.ra) * 15.0 + geo_loc.longitude);
+
+    const double pz_rate = (std::sin(lat) * std::cos(dec) - std::cos(lat) * std::sin(dec) * std::cos(lha)) * dec_rate - std::cos(lat) * std::cos(dec) * std::sin(lha) * lha_rate;
+    const double pn = std::cos(lat) * std::sin(dec) - std::sin(lat) * std::cos(dec) * std::cos(lha);
+    const double pn_rate = (std::cos(lat) * std::cos(dec) + std::sin(lat) * std::sin(dec) * std::cos(lha)) * dec_rate + std::sin(lat) * std::cos(dec) * std::sin(lha) * lha_rate;
+    const double pw = std::cos(dec) * std::sin(lha);
+    const double pw_rate = -std::sin(dec) * std::sin(lha) * dec_rate + std::cos(dec) * std::cos(lha) * lha_rate;
+
+    double el_rate = to_degrees(pz_rate / std::sqrt(pn * pn + pw * pw));
+    const double az_rate = -to_degrees((pn * pw_rate - pw * pn_rate) / (pn * pn + pw * pw));
+
+    if (novas_constants::refraction != 0)
+    {
+        const double zd = 90.0 - hc.zd, h = 0.01;
+        const double slope = (refract(&geo_loc, novas_constants::refraction, zd + h) - refract(&geo_loc, novas_constants::refraction, zd - h)) / (2 * h);
+        el_rate /= 1.0 + slope;
+    }
+
+    return {el_rate, az_rate};
+}
+
+double novas_utils::planetary_event_functions::el_of(state const &s)
+{
+    return upper_limb_el(planet, s.hc, s.t_place);
+}
+
+double novas_utils::planetary_event_functions::az_of(state const &s)
+{
+    return s.hc.az - 180; // give us sign change at azimuth (180.0 or 0/360)
+}
+
+planetary_event novas_utils::planetary_event_functions::event_of(state const &s)
+{
+    astro_time at = s.at;
+    planet_event_type et = determine_planetary_event_type(s.hc, at, geo_loc);
+
+    return {at.as_utc(), s.hc, s.t_place, et};
+}
+
+double novas_utils::planetary_event_functions::el_at_time(double jd_utc_time)
+{
+    return el_of(state_at_time(jd_utc_time));
+}
+
+double novas_utils::planetary_event_functions::az_at_time(double jd_utc_time)
+{
+    return az_of(state_at_time(jd_utc_time));
+}
+
+planetary_event novas_utils::planetary_event_functions::event_at_time(double jd_utc_time)
+{
+    return event_of(state_at_time(jd_utc_time));
+}
+
+// The rate of the Moon's phase longitude, degrees per day, from the geocentric positions (AU) and velocities (AU/day) of
+// the Sun and the Moon: that of the ecliptic longitude of the Sun, less that of the Earth, seen from the Moon. Geometric
+// positions on the ecliptic of J2000 are close enough for a rate.
+static double moon_phase_lon_rate(const double sun_pos[3], const double sun_vel[3], const double moon_pos[3], const double moon_vel[3])
+{
+    const double obliquity = to_radians(23.4392911);
+    auto longitude_rate = [&](const double to[3], const double to_vel[3]) -> double
+    {
+        const double x = to[0] - moon_pos[0];
+        const double y = (to[1] - moon_pos[1]) * std::cos(obliquity) + (to[2] - moon_pos[2]) * std::sin(obliquity);
+        const double vx = to_vel[0] - moon_vel[0];
+        const double vy = (to_vel[1] - moon_vel[1]) * std::cos(obliquity) + (to_vel[2] - moon_vel[2]) * std::sin(obliquity);
+        return (x * vy - y * vx) / (x * x + y * y);
+    };
+
+    const double geocenter[3] = {0.0, 0.0, 0.0};
+
+    return to_degrees(longitude_rate(sun_pos, sun_vel) - longitude_rate(geocenter, geocenter));
+}
+
+// The body number ephemeris::state uses for 'planet' (0 = Mercury, ..., 8 = Pluto, 9 = Moon, 10 = Sun).
+static short state_target(novas_planet const &planet)
+{
+    switch (planet.id)
+    {
+    case novas_planet_id::MOON:
+        return 9;
+    case novas_planet_id::SUN:
+        return 10;
+    default:
+        return static_cast<short>(to_underlying(planet.id) - 1);
+    }
+}
+
+// Distinct epochs of a batch of event_search queries, in increasing order: epoch[i] is the index in 'x' of query i.
+struct batch_epochs
+{
+    std::vector<double> x;
+    std::vector<std::size_t> epoch;
+
+    batch_epochs(const event_query *queries, std::size_t n) : epoch(n)
+    {
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return queries[a].x < queries[b].x; });
+
+        for (std::size_t i : order)
+        {
+            if (x.empty() || queries[i].x != x.back())
+                x.push_back(queries[i].x);
+            epoch[i] = x.size() - 1;
+        }
+    }
+};
+
+novas_utils::planetary_event_batch::planetary_event_batch(novas_planet planet, planetary_event_functions &fns, novas_wrapper::context &ctx) : target(state_target(planet)), fns(fns), ctx(ctx)
+{
+}
+
+void novas_utils::planetary_event_batch::operator()(const event_query *queries, std::size_t n, double *f, double *df)
+{
+    batch_epochs epochs(queries, n);
+    const std::size_t m = epochs.x.size();
+
+    // Values computed while screening at single precision are neither taken from nor given to 'recent'.
+    const bool screening = ephemeris_precision_scope::reduced_on_this_thread();
+
+    std::vector<evaluation> evaluations(m);
+    std::vector<std::size_t> missing;
+    std::vector<double> tdb;
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        evaluation const *kept = screening ? nullptr : recent.find(epochs.x[k]);
+        if (kept)
+        {
+            evaluations[k] = *kept;
+            continue;
+        }
+        missing.push_back(k);
+        tdb.push_back(astro_time::from_utc(epochs.x[k]).as_tdb());
+    }
+
+    std::vector<double> pos(3 * missing.size()), vel(3 * missing.size());
+    if (!missing.empty())
+        ephemeris::instance().geocentric_state_batch(target, tdb.data(), missing.size(), pos.data(), vel.data());
+
+    // NOVAS reuses the values it saved for epochs within 1e-8 day of each other; the context is reset at each epoch.
+    // The rates of an epoch follow its place(), whose nutation the sidereal time in horizon_rates then reuses.
+    for (std::size_t i = 0; i < missing.size(); ++i)
+    {
+        evaluation &e = evaluations[missing[i]];
+        ctx.reset();
+        e.s = fns.state_at_time(epochs.x[missing[i]]);
+        e.rates = fns.horizon_rates(e.s, &vel[3 * i]);
+        if (!screening)
+            recent.store(epochs.x[missing[i]], e);
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        evaluation const &e = evaluations[epochs.epoch[i]];
+        if (queries[i].function == elevation)
+        {
+            f[i] = fns.el_of(e.s);
+            df[i] = e.rates.first;
+        }
+        else
+        {
+            f[i] = fns.az_of(e.s);
+            df[i] = e.rates.second;
+        }
+    }
+}
+
+planetary_event novas_utils::planetary_event_batch::event_at(double jd_utc_time)
+{
+    if (evaluation const *kept = recent.find(jd_utc_time))
+        return fns.event_of(kept->s);
+
+    ctx.reset();
+    return fns.event_at_time(jd_utc_time);
+}
+
+novas_utils::moon_phase_batch::moon_phase_batch(novas_wrapper::context &ctx) : ctx(ctx)
+{
+}
+
+void novas_utils::moon_phase_batch::operator()(const event_query *queries, std::size_t n, double *f, double *df)
+{
+    batch_epochs epochs(queries, n);
+    const std::size_t m = epochs.x.size();
+
+    std::vector<double> phase_lon, tdb;
+    for (double x : epochs.x)
+    {
+        ctx.reset();
+        auto at = astro_time::from_utc(x);
+        phase_lon.push_back(get_moon_phase(at).sun_earth_angle_long);
+        tdb.push_back(at.as_tdb());
+    }
+
+    std::vector<double> sun_pos(3 * m), sun_vel(3 * m), moon_pos(3 * m), moon_vel(3 * m);
+    ephemeris::instance().geocentric_state_batch(state_target(novas_constants::SUN), tdb.data(), m, sun_pos.data(), sun_vel.data());
+    ephemeris::instance().geocentric_state_batch(state_target(novas_constants::MOON), tdb.data(), m, moon_pos.data(), moon_vel.data());
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const std::size_t k = epochs.epoch[i];
+        f[i] = phase_lon[k];
+        df[i] = moon_phase_lon_rate(&sun_pos[3 * k], &sun_vel[3 * k], &moon_pos[3 * k], &moon_vel[3 * k]);
+    }
+}
+
+// The events at the roots 'search' (an event_search or a proxy_search) found over 'fxs'. Each root is the last point
+// the search evaluated, whose state 'fxs' still holds.
+template <typename S>
+static void append_planetary_events(std::vector<planetary_event> &events, S const &search, novas_utils::planetary_event_batch &fxs)
+{
+    for (std::size_t l = 0; l < search.size(); ++l)
+    {
+        for (double root : search.roots(l))
+            events.push_back(fxs.event_at(root));
+    }
+}
+
+// The events of the days [first, last) of 'days', searched one day at a time: an event_search (or a proxy_search) over
+// the elevation and azimuth lanes of the day. A search over many days evaluates epochs days apart in turn, and place()
+// then costs about a third more than for epochs minutes apart (the sines and cosines of its nutation series change from
+// one call to the next), more than lock-step rounds save.
+static std::vector<planetary_event> search_planetary_days(novas_planet planet, on_surface geo_loc, std::vector<double> const &days, std::size_t first, std::size_t last, novas_utils::event_root_finder finder, novas_utils::planetary_event_functions &fns, novas_wrapper::context &ctx)
+{
+    const bracket_rate el_rate = novas_utils::elevation_bracket_rate(planet, geo_loc);
+    const bracket_rate az_rate = novas_utils::azimuth_bracket_rate(planet);
+
+    novas_utils::planetary_event_batch fxs(planet, fns, ctx);
+
+    std::vector<planetary_event> events;
+    for (std::size_t d = first; d < last; ++d)
+    {
+        const std::vector<event_lane> lanes{{novas_utils::planetary_event_batch::elevation, days[d], days[d + 1], el_rate},
+                                            {novas_utils::planetary_event_batch::azimuth, days[d], days[d + 1], az_rate}};
+
+        if (finder == novas_utils::event_root_finder::chebyshev_proxy)
+        {
+            proxy_search search(lanes, 1.0, planetary_proxy_nodes);
+            run_proxy_search(search, fxs);
+            append_planetary_events(events, search, fxs);
+        }
+        else
+        {
+            event_search search(lanes);
+            run_event_search(search, fxs);
+            append_planetary_events(events, search, fxs);
+        }
+    }
+    return events;
+}
+
+// A body's apparent place seen from the geocenter at one epoch, as a position vector in the true equator and equinox of
+// date (AU), with the Greenwich apparent sidereal time (hours).
+struct geocentric_sample
+{
+    double pos[3];
+    double gast;
+};
+
+// The functions the many-observer find_planetary_events brackets and refines. The geocentric place is computed once per
+// epoch and shifted to each observer by the observer's position (terra at the sidereal time), then turned to the horizon
+// as equ2hor does, without polar motion; the diurnal aberration and the light time from the observer are left out too.
+// place() differs from the result by arcseconds at most, which find_planetary_events removes with a last step on it.
+class observer_event_functions
+{
+public:
+    explicit observer_event_functions(novas_planet planet) : planet(planet), planet_obj(novas_utils::build_planet_object(planet))
+    {
+        make_observer_at_geocenter(&geocenter);
+    }
+
+    geocentric_sample sample_at_time(double jd_utc_time)
+    {
+        auto at = astro_time::from_utc(jd_utc_time);
+        sky_pos place = novas_wrapper::w_place(at, planet_obj, geocenter, novas_constants::coord_equ, novas_constants::accuracy);
+
+        geocentric_sample s;
+        for (int j = 0; j < 3; ++j)
+        {
+            s.pos[j] = place.r_hat[j] * place.dis;
+        }
+
+        const short gst_type = 1; // Greenwich apparent sidereal time
+        const short method = 1;   // equinox-based method
+        short error = sidereal_time(at.as_ut1(), 0.0, at.delta_t(), gst_type, method, novas_constants::accuracy, &s.gast);
+        if (error != 0)
+        {
+            throw std::runtime_error("error from function 'sidereal_time': " + std::to_string(error));
+        }
+
+        return s;
+    }
+
+    std::tuple<novas_wrapper::horizon_coords, sky_pos> hc_from_sample(geocentric_sample const &s, on_surface &geo_loc)
+    {
+        double obs_pos[3], obs_vel[3], pos[3];
+        terra(&geo_loc, s.gast, obs_pos, obs_vel);
+
+        sky_pos t_place;
+        for (int j = 0; j < 3; ++j)
+        {
+            pos[j] = s.pos[j] - obs_pos[j];
+        }
+        t_place.dis = std::sqrt(pos[0] * pos[0] + pos[1] * pos[1] + pos[2] * pos[2]);
+        for (int j = 0; j < 3; ++j)
+        {
+            t_place.r_hat[j] = pos[j] / t_place.dis;
+        }
+        vector2radec(pos, &t_place.ra, &t_place.dec);
+        t_place.rv = 0.0;
+
+        // equ2hor's projection onto the local zenith, north and west, with the hour angle from 's.gast'.
+        const double lat = to_radians(geo_loc.latitude);
+        const double dec = to_radians(t_place.dec);
+        const double lha = to_radians((s.gast - t_place.ra) * 15.0 + geo_loc.longitude);
+
+        const double pz = std::sin(lat) * std::sin(dec) + std::cos(lat) * std::cos(dec) * std::cos(lha);
+        const double pn = std::cos(lat) * std::sin(dec) - std::sin(lat) * std::cos(dec) * std::cos(lha);
+        const double pw = std::cos(dec) * std::sin(lha);
+
+        novas_wrapper::horizon_coords hc{0.0, 0.0, t_place.ra, t_place.dec};
+
+        hc.az = normalize(-to_degrees(std::atan2(pw, pn)), 360.0);
+
+        double zd = to_degrees(std::atan2(std::sqrt(pn * pn + pw * pw), pz));
+
+        if (novas_constants::refraction != 0)
+        {
+            const double zd0 = zd;
+            double zd1;
+            do
+            {
+                zd1 = zd;
+                zd = zd0 - refract(&geo_loc, novas_constants::refraction, zd);
+            } while (std::fabs(zd - zd1) > 3.0e-5);
+        }
+
+        hc.zd = 90 - zd;
+
+        return std::tuple<novas_wrapper::horizon_coords, sky_pos>{hc, t_place};
+    }
+
+    double el_from_sample(geocentric_sample const &s, on_surface &geo_loc)
+    {
+        auto [hc, t_place] = hc_from_sample(s, geo_loc);
+        return upper_limb_el(planet, hc, t_place);
+    }
+
+    double az_from_sample(geocentric_sample const &s, on_surface &geo_loc)
+    {
+        auto [hc, t_place] = hc_from_sample(s, geo_loc);
+        return hc.az - 180;
+    }
+
+private:
+    novas_planet planet;
+    object planet_obj;
+    observer geocenter;
+};
+
+// The geocentric samples at the points of a bracketing grid, computed at full precision when first needed and then kept
+// for every observer. Between the points, at_time interpolates with the cubic through the four nearest; at the eight
+// points a day of the elevation grid, that is within a milliarcsecond of place() even for the Moon, except where place()
+// has features narrower than the grid (light deflection of Mars during a transit of Mercury, for one).
+class geocentric_track
+{
+public:
+    geocentric_track(observer_event_functions &fns, bracket_grid const &grid) : fns(fns), grid(grid), nodes(grid.x.size())
+    {
+    }
+
+    geocentric_sample const &node(std::size_t i)
+    {
+        if (!nodes[i])
+            nodes[i] = fns.sample_at_time(grid.x[i]);
+        return *nodes[i];
+    }
+
+    geocentric_sample at_time(double jd_utc_time)
+    {
+        const int n = (int)grid.x.size();
+        if (n < 4)
+            return fns.sample_at_time(jd_utc_time);
+
+        const int i = std::clamp((int)std::floor((jd_utc_time - grid.x[0]) / grid.dx), 1, n - 3);
+
+        // The sidereal time of each node is unwrapped to follow the first, which it leads by about 1.0027 turns a day.
+        const double sidereal_rate = 24.0 * 1.00273781191135448;
+        const double gast0 = node(i - 1).gast;
+
+        geocentric_sample s{{0.0, 0.0, 0.0}, 0.0};
+        for (int k = i - 1; k <= i + 2; ++k)
+        {
+            double w = 1.0;
+            for (int m = i - 1; m <= i + 2; ++m)
+            {
+                if (m != k)
+                    w *= (jd_utc_time - grid.x[m]) / (grid.x[k] - grid.x[m]);
+            }
+
+            geocentric_sample const &p = node(k);
+            for (int j = 0; j < 3; ++j)
+            {
+                s.pos[j] += w * p.pos[j];
+            }
+            const double predicted = gast0 + sidereal_rate * (grid.x[k] - grid.x[i - 1]);
+            s.gast += w * (p.gast + 24.0 * std::round((predicted - p.gast) / 24.0));
+        }
+        s.gast = normalize(s.gast, 24.0);
+
+        return s;
+    }
+
+private:
+    observer_event_functions &fns;
+    bracket_grid const &grid;
+    std::vector<std::optional<geocentric_sample>> nodes;
+};
+
+// The batch functions of the many-observer find_planetary_events, over function 2 * o + planetary_event_batch::elevation
+// (or azimuth) for the observer 'geo_locs[o]': sample() on the place at each epoch, computed once for every observer
+// (at single precision under ephemeris::load_single), and operator() on the geocentric_track through the grid, at full
+// precision, with the rate of the interpolation. Neither computes a place() between the grid epochs.
+class observer_event_batch
+{
+public:
+    observer_event_batch(observer_event_functions &fns, geocentric_track &track, std::vector<on_surface> const &geo_locs, novas_wrapper::context &ctx) : fns(fns), track(track), geo_locs(geo_locs), ctx(ctx)
+    {
+    }
+
+    void sample(const event_query *queries, std::size_t n, double *f, double *df)
+    {
+        batch_epochs epochs(queries, n);
+
+        // As in planetary_event_batch, the context is reset at each epoch.
+        std::vector<geocentric_sample> samples;
+        for (double x : epochs.x)
+        {
+            ctx.reset();
+            samples.push_back(fns.sample_at_time(x));
+        }
+
+        // The rates are left out: the brackets are confirmed on the track, which gives them.
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            f[i] = value(queries[i].function, samples[epochs.epoch[i]]);
+            df[i] = 0.0;
+        }
+    }
+
+    void operator()(const event_query *queries, std::size_t n, double *f, double *df)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const double x = queries[i].x;
+            f[i] = value(queries[i].function, track.at_time(x));
+            df[i] = rate(queries[i].function, x);
+        }
+    }
+
+    // The rate of function 'function' on the track at 'jd_utc_time', from a central difference; an azimuth difference
+    // across its jump from 180 to -180 is taken the short way round.
+    double rate(int function, double jd_utc_time)
+    {
+        const double h = 1.0e-6;
+        double d = value(function, track.at_time(jd_utc_time + h)) - value(function, track.at_time(jd_utc_time - h));
+        if (function % 2 == novas_utils::planetary_event_batch::azimuth)
+            d = std::remainder(d, 360.0);
+        return d / (2 * h);
+    }
+
+    double value(int function, geocentric_sample const &s)
+    {
+        on_surface &geo_loc = geo_locs[function / 2];
+        return function % 2 == novas_utils::planetary_event_batch::elevation ? fns.el_from_sample(s, geo_loc) : fns.az_from_sample(s, geo_loc);
+    }
+
+private:
+    observer_event_functions &fns;
+    geocentric_track &track;
+    std::vector<on_surface> geo_locs;
+    novas_wrapper::context &ctx;
+};
+
 object novas_utils::build_planet_object(novas_planet planet)
 {
 
@@ -69,6 +776,23 @@ sky_pos novas_utils::load_planet_geocentric_equatorial(astro_time &lookup_time,
     return novas_wrapper::w_place(lookup_time, planet_obj, at_geocenter, novas_constants::coord_equ, novas_constants::accuracy);
 }
 
+std::vector<sky_pos> novas_utils::load_planets_geocentric_equatorial(astro_time &lookup_time, std::vector<novas_planet> const &planets)
+{
+
+    // Makes a structure of type 'observer' specifying an observer at the geocenter.
+    observer at_geocenter;
+    make_observer_at_geocenter(&at_geocenter);
+
+    std::vector<object> planet_objs;
+
+    for (auto const &planet : planets)
+    {
+        planet_objs.push_back(build_planet_object(planet));
+    }
+
+    return novas_wrapper::w_place_bodies(lookup_time, planet_objs, at_geocenter, novas_constants::coord_equ, novas_constants::accuracy);
+}
+
 // Calculate the equatorial spherical coordinates of the solar transit point with
 // respect to the center of the Earth-facing surface of the Moon.
 
@@ -255,111 +979,174 @@ planet_event_type novas_utils::determine_planetary_event_type(novas_wrapper::hor
     }
 }
 
-std::vector<planetary_event> novas_utils::find_planetary_events(const double julian_utc_begin, const double julian_utc_end, novas_planet planet, on_surface geo_loc)
+// The refined events, sorted by time.
+static bool event_before(planetary_event const &a, planetary_event const &b)
 {
+    return a.event_time < b.event_time;
+}
 
-    observer surface_loc; // Need to get *topocentric* values for equ2hor to work correctly.
-    make_observer_on_surface(geo_loc.latitude, geo_loc.longitude, geo_loc.height, geo_loc.temperature, geo_loc.pressure, &surface_loc);
+std::vector<planetary_event> novas_utils::find_planetary_events(const double julian_utc_begin, const double julian_utc_end, novas_planet planet, on_surface geo_loc, event_root_finder finder)
+{
 
-    object planet_obj = build_planet_object(planet);
+    planetary_event_functions fns(planet, geo_loc);
 
-    auto hc_at_time_fn = [&](double jd_utc_time) -> auto
-    {
-        auto at = astro_time::from_utc(jd_utc_time);
-        sky_pos t_place = novas_wrapper::w_place(at, planet_obj, surface_loc, novas_constants::coord_equ, novas_constants::accuracy);
-        finals_data fd = at.get_finals_data();
-        auto hc = novas_wrapper::w_equ2hor(at, t_place, novas_constants::accuracy, fd.pm_x, fd.pm_y, geo_loc, novas_constants::refraction);
-        return std::tuple<novas_wrapper::horizon_coords, sky_pos>{hc, t_place};
-    };
+    novas_wrapper::context ctx;
+    novas_wrapper::context_binding binding(ctx);
 
-    auto el_at_time_fn = [&](double jd_utc_time) -> auto
-    {
+    const std::vector<double> days = search_days(julian_utc_begin, julian_utc_end);
+    std::vector<planetary_event> events = search_planetary_days(planet, geo_loc, days, 0, days.size() - 1, finder, fns, ctx);
 
-        auto [hc, t_place] = hc_at_time_fn(jd_utc_time);
-        double distance_to_obj = au_to_km(t_place.dis);
-        double actual_diameter_km = planet.diameter_km;
-        double planet_diameter = to_degrees(2 * std::atan(actual_diameter_km / (2 * distance_to_obj)));
+    std::sort(events.begin(), events.end(), event_before);
 
-        // Moonrise occurs when EL is 90 degrees + Moon's apparent angular radius moon_app_radius, which varies between 0.245 and 0.279.
-        // "More" EL means "lower". But we've already subtracted from 90.
-        // hc.zd = 90 - hc.zd;
+    return events;
+}
 
-        return hc.zd + planet_diameter / 2.0;
-    };
+std::vector<planetary_event> novas_utils::find_planetary_events(const double julian_utc_begin, const double julian_utc_end, novas_planet planet, on_surface geo_loc, unsigned threads, event_root_finder finder)
+{
 
-    auto az_at_time_fn = [&](double jd_utc_time) -> auto
-    {
-        auto [hc, t_place] = hc_at_time_fn(jd_utc_time);
-        return hc.az - 180; // give us sign change at azimuth (180.0 or 0/360)
-    };
+    const unsigned processors = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == 0 || threads > processors)
+        threads = processors;
 
-    std::vector<double> event_times;
+    planetary_event_functions shared_fns(planet, geo_loc);
 
-    std::vector<double> xb1, xb2;
-    int nroot = 0;
+    // The days of the serial search, in runs of consecutive days, a few runs per thread; each task searches the days
+    // of one run. Every value the batch function returns, and every event, depends on its epoch alone, so the events
+    // are identical to those of the serial search.
 
-    const int slices = (int)floor(8 * (julian_utc_end - julian_utc_begin));
+    const std::vector<double> days = search_days(julian_utc_begin, julian_utc_end);
+    const std::size_t day_count = days.size() - 1;
+    const std::size_t runs = std::max<std::size_t>(1, std::min<std::size_t>(day_count, 4 * std::size_t(threads)));
 
-    zbrak(el_at_time_fn, julian_utc_begin, julian_utc_end, slices, xb1, xb2, nroot);
+    std::vector<std::vector<planetary_event>> run_events(runs);
 
-    for (int i = 0; i < nroot; ++i)
+    run_on_workers(threads, runs, [&](std::size_t r, novas_wrapper::context &ctx)
     {
+        planetary_event_functions fns = shared_fns;
+        run_events[r] = search_planetary_days(planet, geo_loc, days, day_count * r / runs, day_count * (r + 1) / runs, finder, fns, ctx);
+    });
 
-        auto jd_utc_of_event = zbrent(el_at_time_fn, xb1[i], xb2[i], finder_tolerance);
+    std::vector<planetary_event> events;
+    for (auto const &found : run_events)
+        events.insert(events.end(), found.begin(), found.end());
 
-        event_times.push_back(jd_utc_of_event);
-    }
+    std::sort(events.begin(), events.end(), event_before);
+
+    return events;
+}
 
-    xb1.clear();
-    xb2.clear();
-    nroot = 0;
+std::vector<std::vector<planetary_event>> novas_utils::find_planetary_events(const double julian_utc_begin, const double julian_utc_end, novas_planet planet, std::vector<on_surface> const &geo_locs)
+{
 
-    zbrak(az_at_time_fn, julian_utc_begin, julian_utc_end, 31 * 4, xb1, xb2, nroot);
+    novas_wrapper::context ctx;
+    novas_wrapper::context_binding binding(ctx);
 
-    for (int i = 0; i < nroot; ++i)
-    {
+    // Every lane steps through the range on one grid, at the longest step of the single-observer search (a bracket rate
+    // whose shortest and longest steps are equal): the steps that search sizes by the distance from a root would differ
+    // between observers, while the place at a grid epoch is computed once for all of them.
 
-        auto jd_utc_of_event = zbrent(az_at_time_fn, xb1[i], xb2[i], finder_tolerance);
+    const double max_step = std::min(elevation_bracket_rate(planet, on_surface{}).max_step, azimuth_bracket_rate(planet).max_step);
+    const int slices = std::max(1, (int)std::ceil((julian_utc_end - julian_utc_begin) / max_step));
+    const bracket_grid grid = fixed_bracket_grid(julian_utc_begin, julian_utc_end, slices);
 
-        event_times.push_back(jd_utc_of_event);
+    std::vector<event_lane> lanes;
+    for (std::size_t o = 0; o < geo_locs.size(); ++o)
+    {
+        bracket_rate el_rate = elevation_bracket_rate(planet, geo_locs[o]);
+        bracket_rate az_rate = azimuth_bracket_rate(planet);
+        el_rate.min_step = el_rate.max_step = grid.dx;
+        az_rate.min_step = az_rate.max_step = grid.dx;
+
+        const int function = 2 * (int)o;
+        lanes.push_back({function + planetary_event_batch::elevation, julian_utc_begin, julian_utc_end, el_rate});
+        lanes.push_back({function + planetary_event_batch::azimuth, julian_utc_begin, julian_utc_end, az_rate});
     }
 
-    std::sort(event_times.begin(), event_times.end());
+    // The brackets found on the samples are confirmed, and refined, on the track: the full-precision samples at their
+    // ends, shared by the observers, and the interpolation between them, which stands in for place().
 
-    std::vector<planetary_event> events;
+    observer_event_functions fns(planet);
+    geocentric_track track(fns, grid);
+    observer_event_batch fxs(fns, track, geo_locs, ctx);
+
+    auto sample = [&](const event_query *queries, std::size_t n, double *f, double *df)
+    {
+        fxs.sample(queries, n, f, df);
+    };
+
+    event_search search(lanes);
+    run_event_search(search, sample, fxs, true);
 
-    for (auto utc_time : event_times)
+    std::vector<std::vector<planetary_event>> events(geo_locs.size());
+
+    for (std::size_t o = 0; o < geo_locs.size(); ++o)
     {
-        auto [hc, t_place] = hc_at_time_fn(utc_time);
+        planetary_event_functions exact_fns(planet, geo_locs[o]);
 
-        planet_event_type et = determine_planetary_event_type(hc, astro_time::from_utc(utc_time), geo_loc);
+        std::vector<double> event_times;
+        for (int function : {planetary_event_batch::elevation, planetary_event_batch::azimuth})
+        {
+            const int lane_function = 2 * (int)o + function;
+            for (double t : search.roots(2 * o + function))
+            {
+                // One Newton step on place(), with the slope of the track, takes the root to where the single-observer
+                // search puts it. A root due north, where the azimuth function jumps from 180 to -180, is followed on
+                // the function rewrapped to jump due south.
+                const bool at_jump = std::fabs(fxs.value(lane_function, track.at_time(t))) > 90.0;
+                auto rewrap = [&](double f) -> double
+                {
+                    return at_jump ? normalize(f, 360.0) - 180.0 : f;
+                };
+
+                ctx.reset();
+                const double exact = function == planetary_event_batch::elevation ? exact_fns.el_at_time(t) : exact_fns.az_at_time(t);
+                const double step = rewrap(exact) / fxs.rate(lane_function, t);
+                if (std::fabs(step) < polish_window)
+                    t -= step;
+
+                event_times.push_back(t);
+            }
+        }
 
-        events.push_back({utc_time, hc, t_place, et});
+        std::sort(event_times.begin(), event_times.end());
+
+        for (auto utc_time : event_times)
+        {
+            ctx.reset();
+            events[o].push_back(exact_fns.event_at_time(utc_time));
+        }
     }
 
     return events;
 }
 
-std::vector<astro_time> novas_utils::find_new_and_full_moons(double jd_utc_beg, double jd_utc_end)
+std::vector<astro_time> novas_utils::find_new_and_full_moons(double jd_utc_beg, double jd_utc_end, event_root_finder finder)
 {
 
     std::vector<astro_time> rv;
 
-    std::vector<double> xb1, xb2;
-    int nroot = 0;
+    novas_wrapper::context ctx;
+    novas_wrapper::context_binding binding(ctx);
+    moon_phase_batch fxs(ctx);
 
-    auto pl_at_time_fn = [&](double jd_utc_time) -> auto
-    {
-        auto at = astro_time::from_utc(jd_utc_time);
-        auto [phase_angle, phase_lon, phase_lat, pct_illum, phase] = get_moon_phase(at);
-        return phase_lon;
-    };
+    const std::vector<event_lane> lanes{{moon_phase_batch::phase_lon, jd_utc_beg, jd_utc_end, moon_phase_bracket_rate()}};
+    std::vector<double> roots;
 
-    zbrak(pl_at_time_fn, jd_utc_beg, jd_utc_end, 120, xb1, xb2, nroot);
+    if (finder == event_root_finder::chebyshev_proxy)
+    {
+        proxy_search search(lanes, moon_phase_proxy_piece, moon_phase_proxy_nodes);
+        run_proxy_search(search, fxs);
+        roots = search.roots(0);
+    }
+    else
+    {
+        event_search search(lanes);
+        run_event_search(search, fxs);
+        roots = search.roots(0);
+    }
 
-    for (int i = 0; i < nroot; ++i)
+    for (double jd_utc_of_event : roots)
     {
-        auto jd_utc_of_event = zbrent(pl_at_time_fn, xb1[i], xb2[i], finder_tolerance);
         astro_time t_event = astro_time::from_utc(jd_utc_of_event);
         rv.push_back(t_event);
     }
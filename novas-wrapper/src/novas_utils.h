@@ -4,9 +4,12 @@
 #include <tuple>
 #include <string>
 #include <limits>
+#include <utility>
 
 #include "astro_time.h"
 #include "novas_wrapper.h"
+#include "event_search.h"
+#include "chebyshev_proxy.h"
 
 template <typename E>
 constexpr auto to_underlying (E e) noexcept {
@@ -84,6 +87,12 @@ namespace novas_utils {
     */
     sky_pos load_planet_geocentric_equatorial (astro_time & lookup_time, novas_planet planet);
 
+    /*
+    * Load several planets' equatorial coordinates at one time, as load_planet_geocentric_equatorial
+    * does for each; the Earth and Sun are computed once for all of them.
+    */
+    std::vector<sky_pos> load_planets_geocentric_equatorial (astro_time & lookup_time, std::vector<novas_planet> const & planets);
+
     /*
     * Load planet's astrometric coordinates (no light deflection, no abberation)
     */
@@ -147,14 +156,152 @@ namespace novas_utils {
     planet_event_type determine_planetary_event_type (novas_wrapper::horizon_coords hc, astro_time event_time, on_surface geo_loc);
 
     /*
-    * Find planet events (rise, set, transit, etc.)
+    * The bracket_rates the searches below step by: the largest rate of change, in degrees per day, of the elevation of
+    * 'planet' seen from 'geo_loc', of its azimuth, and of the Moon's phase longitude, with the shortest and longest
+    * steps to take between evaluations.
+    */
+    bracket_rate elevation_bracket_rate (novas_planet planet, on_surface geo_loc);
+    bracket_rate azimuth_bracket_rate (novas_planet planet);
+    bracket_rate moon_phase_bracket_rate ();
+
+    /*
+    * The functions find_planetary_events brackets and refines, for one body seen from one place, in degrees: the
+    * elevation of the upper limb, zero at rise and set, and the azimuth less 180, zero (or jumping from 180 to -180) at
+    * a culmination. horizon_rates gives their derivatives in degrees per day, for Newton steps: the diurnal rotation
+    * and the body's motion, from its geocentric velocity, turned through equ2hor's projection and the slope of the
+    * refraction. It is good to about 1e-4 of the rate (precession and aberration are left out), which costs Newton's
+    * method nothing near a root.
+    */
+    class planetary_event_functions
+    {
+    public:
+        /*
+        * What the functions are derived from at one time: the place() and equ2hor() of the body. planetary_event_batch
+        * keeps the states of recent times, so that the event at a root comes from the state its search computed.
+        */
+        struct state
+        {
+            astro_time at;
+            novas_wrapper::horizon_coords hc;
+            sky_pos t_place;
+        };
+
+        planetary_event_functions(novas_planet planet, on_surface geo_loc);
+
+        state state_at_time(double jd_utc_time);
+
+        double el_of(state const &s);
+        double az_of(state const &s);
+        planetary_event event_of(state const &s);
+
+        /*
+        * The rates of the elevation and azimuth of 's', given the body's geocentric velocity (AU/day), for callers that
+        * read the velocities of many states at once (see ephemeris::geocentric_state_batch).
+        */
+        std::pair<double, double> horizon_rates(state s, const double geo_vel[3]);
+
+        double el_at_time(double jd_utc_time);
+        double az_at_time(double jd_utc_time);
+        planetary_event event_at_time(double jd_utc_time);
+
+    private:
+        novas_planet planet;
+        on_surface geo_loc;
+        object planet_obj;
+        observer surface_loc;
+    };
+
+    /*
+    * The batch functions the searches below give event_search: the elevation and azimuth of planetary_event_functions,
+    * and the Moon's phase longitude (get_moon_phase's sun_earth_angle_long, zero at full moon and jumping from 180 to
+    * -180 at new moon), with their rates. Queries at one epoch share one evaluation, made in 'ctx' (bound on the calling
+    * thread) after a reset, so that a value depends on its epoch alone and not on the batch it came in; the geocentric
+    * velocities of a batch come from one ephemeris::geocentric_state_batch call per body.
+    *
+    * planetary_event_batch keeps the states (and rates) of the last epochs it evaluated at full precision, and answers
+    * queries at those epochs from them: the end of one day's search is the start of the next, and the searches report
+    * a root at the last point they evaluated, whose event event_at() then builds without another place().
+    */
+    class planetary_event_batch
+    {
+    public:
+        static const int elevation = 0;
+        static const int azimuth = 1;
+
+        planetary_event_batch(novas_planet planet, planetary_event_functions &fns, novas_wrapper::context &ctx);
+
+        void operator()(const event_query *queries, std::size_t n, double *f, double *df);
+
+        planetary_event event_at(double jd_utc_time);
+
+    private:
+        struct evaluation
+        {
+            planetary_event_functions::state s;
+            std::pair<double, double> rates;
+        };
+
+        short target;
+        planetary_event_functions &fns;
+        novas_wrapper::context &ctx;
+        recent_values<evaluation, 32> recent;
+    };
+
+    class moon_phase_batch
+    {
+    public:
+        static const int phase_lon = 0;
+
+        explicit moon_phase_batch(novas_wrapper::context &ctx);
+
+        void operator()(const event_query *queries, std::size_t n, double *f, double *df);
+
+    private:
+        novas_wrapper::context &ctx;
+    };
+
+    /*
+    * How the searches below find the roots of their event functions: by bracketing, each day (or the range of a
+    * moon phase search) stepped through as far as the bracket rates allow and the brackets refined with Newton steps
+    * (event_search); or from Chebyshev proxies fitted to each day (to pieces of thirty days for the Moon's phase),
+    * whose roots are polished with Newton steps on the function (proxy_search).
+    */
+    enum class event_root_finder
+    {
+        bracketing,
+        chebyshev_proxy
+    };
+
+    /*
+    * Find planet events (rise, set, transit, etc.). An event_search with planetary_event_batch steps through the
+    * elevation and the azimuth of each day of the range together, in steps sized by their distance from a root and the
+    * bracket rates above, and refines every root with Newton steps on the rates; with event_root_finder::chebyshev_proxy,
+    * a proxy_search fits both on 24 nodes of the day instead.
+    */
+    std::vector<planetary_event> find_planetary_events (const double julian_utc_begin, const double julian_utc_end, novas_planet planet, on_surface geo_loc, event_root_finder finder = event_root_finder::bracketing);
+
+    /*
+    * Find planet events as above, on 'threads' threads, at most one per processor (0 for one per processor). Runs of
+    * days of the range are searched by workers, each with its own ephemeris reader and NOVAS context; the events are
+    * identical to those of the serial search.
+    */
+    std::vector<planetary_event> find_planetary_events (const double julian_utc_begin, const double julian_utc_end, novas_planet planet, on_surface geo_loc, unsigned threads, event_root_finder finder = event_root_finder::bracketing);
+
+    /*
+    * Find planet events as above for each of several observers; element i of the result holds the events seen from
+    * geo_locs[i]. One event_search steps the elevation and azimuth of every observer through the range together, on a
+    * grid at the longest step of the single-observer search: the body's geocentric place is computed once per grid
+    * epoch and shifted to every observer, the roots are refined on an interpolation of those places and take a last
+    * Newton step on place(), so an observer costs about two place() calls per event. Event times agree with those of
+    * the single-observer search to a millisecond or so, but a rise and a set closer together than a grid step (a body
+    * grazing the horizon, as the Sun near the polar circles) fall in one step and are not found.
     */
-    std::vector<planetary_event> find_planetary_events (const double julian_utc_begin, const double julian_utc_end, novas_planet planet, on_surface geo_loc);
+    std::vector<std::vector<planetary_event>> find_planetary_events (const double julian_utc_begin, const double julian_utc_end, novas_planet planet, std::vector<on_surface> const & geo_locs);
 
     /*
-    * Find new and full moons
+    * Find new and full moons, with an event_search (or a proxy_search, as 'finder' says) over moon_phase_batch.
     */
-    std::vector<astro_time> find_new_and_full_moons (double jd_utc_beg, double jd_utc_end);
+    std::vector<astro_time> find_new_and_full_moons (double jd_utc_beg, double jd_utc_end, event_root_finder finder = event_root_finder::bracketing);
 
 };
 
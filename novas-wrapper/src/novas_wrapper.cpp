@@ -3,6 +3,30 @@
 
 namespace novas_wrapper {
 
+	context::context() {
+		novas_context_init(&state);
+	}
+
+	context::~context() {
+		novas_context_free(&state);
+	}
+
+	void context::reset() {
+		novas_context_reset(&state);
+	}
+
+	novas_context * context::handle() {
+		return &state;
+	}
+
+	context_binding::context_binding(context & ctx) :
+		previous(novas_context_bind(ctx.handle())) {
+	}
+
+	context_binding::~context_binding() {
+		novas_context_bind(previous);
+	}
+
 	std::tuple<double, double, double> w_cel2ter(astro_time & lookup_time, short method, short accuracy, short option, double xp, double yp, double vec1[3]) {
 
 		double vec2[3];	// vec2[3] (double) Position vector, geocentric equatorial rectangular coordinates, referred to ITRS axes(terrestrial system).
@@ -60,14 +84,10 @@ namespace novas_wrapper {
 		return hc;
 	}
 
-	sky_pos w_place(astro_time & lookup_time, object & cel_object, observer & location, short coord_sys, short accuracy) {
-
-		sky_pos t_place;
-
-		short error = place(lookup_time.as_tt(), &cel_object, &location, lookup_time.delta_t(), coord_sys, accuracy, &t_place);
+	static void w_place_result(short error) {
 
 		if (error == 0) {
-			return t_place;
+			return;
 		}
 		else if (error == 1) {
 			throw std::runtime_error("invalid value of 'coord_sys'");
@@ -107,6 +127,53 @@ namespace novas_wrapper {
 		}
 	}
 
+	sky_pos w_place(astro_time & lookup_time, object & cel_object, observer & location, short coord_sys, short accuracy) {
+
+		sky_pos t_place;
+
+		short error = place(lookup_time.as_tt(), &cel_object, &location, lookup_time.delta_t(), coord_sys, accuracy, &t_place);
+
+		w_place_result(error);
+
+		return t_place;
+	}
+
+	std::vector<sky_pos> w_place_bodies(astro_time & lookup_time, std::vector<object> & cel_objects, observer & location, short coord_sys, short accuracy) {
+
+		std::vector<sky_pos> places(cel_objects.size());
+
+		short error = place_bodies(lookup_time.as_tt(), (short)cel_objects.size(), cel_objects.data(), &location, lookup_time.delta_t(), coord_sys, accuracy, places.data());
+
+		w_place_result(error);
+
+		return places;
+	}
+
+	std::tuple<double, double, double> w_cel2ter(context & ctx, astro_time & lookup_time, short method, short accuracy, short option, double xp, double yp, double vec1[3]) {
+		context_binding binding(ctx);
+		return w_cel2ter(lookup_time, method, accuracy, option, xp, yp, vec1);
+	}
+
+	std::tuple<double, double> w_equ2ecl(context & ctx, astro_time & lookup_time, short coord_sys, short accuracy, double ra, double dec) {
+		context_binding binding(ctx);
+		return w_equ2ecl(lookup_time, coord_sys, accuracy, ra, dec);
+	}
+
+	horizon_coords w_equ2hor(context & ctx, astro_time & lookup_time, sky_pos t_place, short accuracy, double x_pole, double y_pole, on_surface & geo_loc, short ref_option) {
+		context_binding binding(ctx);
+		return w_equ2hor(lookup_time, t_place, accuracy, x_pole, y_pole, geo_loc, ref_option);
+	}
+
+	sky_pos w_place(context & ctx, astro_time & lookup_time, object & cel_object, observer & location, short coord_sys, short accuracy) {
+		context_binding binding(ctx);
+		return w_place(lookup_time, cel_object, location, coord_sys, accuracy);
+	}
+
+	std::vector<sky_pos> w_place_bodies(context & ctx, astro_time & lookup_time, std::vector<object> & cel_objects, observer & location, short coord_sys, short accuracy) {
+		context_binding binding(ctx);
+		return w_place_bodies(lookup_time, cel_objects, location, coord_sys, accuracy);
+	}
+
 	object w_make_object(short int type, novas_planet_id number, std::string const & name, cat_entry & star_data) {
 
 		object cel_obj;
@@ -9,6 +9,7 @@ extern "C"
 }
 
 #include <tuple>
+#include <vector>
 
 #include "astro_time.h"
 
@@ -73,6 +74,49 @@ namespace novas_constants {
 
 namespace novas_wrapper {
 
+	// context: the values NOVAS functions keep from one call to the next (the last date of place, precession,
+	// sidereal_time, ...; see novas.h 'novas_context'). Calls on threads that bind no context share one default context,
+	// so a thread computing alongside others must bind a context of its own, with a context_binding or by passing it to
+	// the w_* overloads below. A context must not be bound on two threads at once.
+
+	class context
+	{
+
+	public:
+		context ();
+		~context ();
+
+		// reset: forgets the values saved for the last date of each function (see novas.c 'novas_context_reset'), so that
+		// the next calls compute them for their own date; values that do not depend on the date, such as the frame-tie
+		// matrix, are kept. The context may be bound on the calling thread.
+
+		void reset ();
+
+		novas_context * handle ();
+
+		context (context const &) = delete;
+		context &operator= (context const &) = delete;
+
+	private:
+		novas_context state;
+	};
+
+	// context_binding: while in scope, NOVAS functions called on this thread keep their values in 'ctx'.
+
+	class context_binding
+	{
+
+	public:
+		explicit context_binding (context & ctx);
+		~context_binding ();
+
+		context_binding (context_binding const &) = delete;
+		context_binding &operator= (context_binding const &) = delete;
+
+	private:
+		novas_context * previous;
+	};
+
 	// w_cel2ter: rotates a vector from the celestial to the terrestrial system. Specifically, it transforms a vector 
 	// in the GCRS (a local space-fixed system) to the ITRS (a rotating earth-fixed system) by applying rotations for
 	// the GCRS-to-dynamical frame tie, precession, nutation, Earth rotation, and polar motion.
@@ -170,6 +214,29 @@ namespace novas_wrapper {
 
 	sky_pos w_place (astro_time& lookup_time, object& cel_object, observer& location, short coord_sys, short accuracy);
 
+	// w_place_bodies: computes the apparent directions of several objects at one time, as w_place does for each, with the
+	// terms they share (TDB, the Earth's and Sun's barycentric states, the observer's position) computed once.
+	//
+	// INPUT:
+	//   lookup_time (astro_time): time at which to perform lookup
+	//   cel_objects (object):     celestial objects of interest
+	//   location (observer):      location of observer
+	//   coord_sys (short):        coordinate system of the output positions, as for w_place
+	//   accuracy (short):         relative accuracy of the output positions, as for w_place
+	//
+	// OUTPUT:
+	//   std::vector<sky_pos>:      each object's place on the sky, in the order of 'cel_objects'
+
+	std::vector<sky_pos> w_place_bodies (astro_time& lookup_time, std::vector<object>& cel_objects, observer& location, short coord_sys, short accuracy);
+
+	// The w_* functions above, with NOVAS keeping its values in 'ctx' for the duration of the call.
+
+	std::tuple<double, double, double> w_cel2ter (context & ctx, astro_time& lookup_time, short method, short accuracy, short option, double xp, double yp, double vec1[3]);
+	std::tuple<double, double> w_equ2ecl (context & ctx, astro_time& lookup_time, short coord_sys, short accuracy, double ra, double dec);
+	horizon_coords w_equ2hor (context & ctx, astro_time& lookup_time, sky_pos t_place, short accuracy, double x_pole, double y_pole, on_surface& geo_loc, short ref_option);
+	sky_pos w_place (context & ctx, astro_time& lookup_time, object& cel_object, observer& location, short coord_sys, short accuracy);
+	std::vector<sky_pos> w_place_bodies (context & ctx, astro_time& lookup_time, std::vector<object>& cel_objects, observer& location, short coord_sys, short accuracy);
+
 	// w_make_object: Makes a structure of type 'object' - specifying a celestial object - based on the input parameters.
 	//
 	// INPUT:
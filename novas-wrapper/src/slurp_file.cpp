@@ -4,6 +4,17 @@
 #include <cstring>
 #include <vector>
 #include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 std::string slurpfile (const std::string& fileName) {
 
@@ -31,3 +42,67 @@ std::string slurpfile (const std::string& fileName) {
 
 	return std::string (bytes.data (), length);
 }
+
+#if defined(_WIN32)
+
+mapped_file::mapped_file (const std::string& fileName) : addr (nullptr), length (0), map_handle (nullptr) {
+
+	HANDLE file_handle = CreateFileA (fileName.c_str (), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file_handle == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx (file_handle, &size) && size.QuadPart > 0) {
+		HANDLE handle = CreateFileMapping (file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (handle != NULL) {
+			addr = (const char*)MapViewOfFile (handle, FILE_MAP_READ, 0, 0, 0);
+			if (addr) {
+				length = (std::size_t)size.QuadPart;
+				map_handle = handle;
+			}
+			else {
+				CloseHandle (handle);
+			}
+		}
+	}
+
+	CloseHandle (file_handle);
+}
+
+mapped_file::~mapped_file () {
+	if (addr) {
+		UnmapViewOfFile (addr);
+		CloseHandle ((HANDLE)map_handle);
+	}
+}
+
+#else
+
+mapped_file::mapped_file (const std::string& fileName) : addr (nullptr), length (0) {
+
+	int fd = open (fileName.c_str (), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat st;
+	if (fstat (fd, &st) == 0 && st.st_size > 0) {
+		void* map = mmap (NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (map != MAP_FAILED) {
+			addr = (const char*)map;
+			length = (std::size_t)st.st_size;
+		}
+	}
+
+	// The mapping stays valid once the descriptor is closed.
+	close (fd);
+}
+
+mapped_file::~mapped_file () {
+	if (addr) {
+		munmap ((void*)addr, length);
+	}
+}
+
+#endif
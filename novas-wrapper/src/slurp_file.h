@@ -1,6 +1,29 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 std::string slurpfile (const std::string& fileName);
 
+// mapped_file: a file mapped read-only into memory for the lifetime of the object. data () is null if the file could
+// not be opened or mapped (or is empty); callers fall back to reading it.
+
+class mapped_file {
+public:
+	explicit mapped_file (const std::string& fileName);
+	~mapped_file ();
+
+	const char* data () const { return addr; }
+	std::size_t size () const { return length; }
+
+	mapped_file (mapped_file const&) = delete;
+	mapped_file& operator= (mapped_file const&) = delete;
+
+private:
+	const char* addr;
+	std::size_t length;
+#if defined(_WIN32)
+	void* map_handle;
+#endif
+};
+
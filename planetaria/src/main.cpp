@@ -6,6 +6,9 @@
 #include <locale> 
 #include <algorithm>
 #include <set>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 
 #include <json.hpp>
 using n_json = nlohmann::json;
@@ -45,6 +48,35 @@ inline bool iequals (const std::string& l, const std::string& r)
 		});
 }
 
+// Ephemeris access counters of a command, for the "stats" block.
+n_json stats_json (ephemeris_stats const& stats)
+{
+	static const char* bodies[] = { "Mercury", "Venus", "Earth-Moon barycenter", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune", "Pluto", "Moon", "Sun" };
+
+	n_json rv;
+
+	rv["record_switches"] = stats.record_switches;
+	rv["reads"] = stats.reads;
+	rv["records_read"] = stats.records_read;
+	rv["bytes_read"] = stats.bytes_read;
+	rv["cache_hits"] = stats.cache_hits;
+	rv["cache_misses"] = stats.cache_misses;
+
+	n_json interpolations;
+	unsigned long total = 0;
+
+	for (std::size_t i = 0; i < stats.interpolations.size (); ++i)
+	{
+		interpolations[bodies[i]] = stats.interpolations[i];
+		total += stats.interpolations[i];
+	}
+
+	rv["interpolations"] = interpolations;
+	rv["interpolations_total"] = total;
+
+	return rv;
+}
+
 input_parser::input_parser (int& argc, char** argv)
 {
 	for (int i = 1; i < argc; ++i)
@@ -86,6 +118,10 @@ int main (int argc, char* argv[])
 			std::cout << (app_name + " [-h : print this message]") << std::endl;
 			std::cout << (app_name + " [-e ephemeris_location] : pass location of DE 430 Ephemeris. Defaults to '" + em_path + "'.") << std::endl;
 			std::cout << (app_name + " [-f finals-data-location] : pass location of finals data. Defaults to '" + finals_path + "'.") << std::endl;
+			std::cout << (app_name + " [-mmap] : map the ephemeris file into memory instead of reading records on demand.") << std::endl;
+			std::cout << (app_name + " [-stats] : add a 'stats' block of ephemeris access counters (records read, interpolations per body, ...) to the output.") << std::endl;
+			std::cout << (app_name + " [-single] : bracket moon_phases and rise_set events with single-precision ephemeris coefficients; events are still refined at full precision.") << std::endl;
+			std::cout << (app_name + " [-proxy] : find moon_phases and rise_set events as roots of Chebyshev proxies fitted to the event functions, polished on the functions, instead of by bracketing.") << std::endl;
 			std::cout << (app_name + " [-e ephemeris-location] [-f finals-data-location] -c command [parameters]") << std::endl;
 			std::cout << std::endl;
 			std::cout << "Commands: " << std::endl;
@@ -101,10 +137,11 @@ int main (int argc, char* argv[])
 			std::cout << "                                " << "-utcend defaults to thirty days after utcstart" << std::endl;
 			std::cout << std::endl;
 			std::cout << app_name << " -c rise_set -lat lat -lon lon" << std::endl;
-			std::cout << app_name << " -c rise_set -lat lat -lon lon [-utcstart datetime] [-utcend datetime] [-planet planet-name]" << std::endl;
+			std::cout << app_name << " -c rise_set -lat lat -lon lon [-utcstart datetime] [-utcend datetime] [-planet planet-name] [-threads n]" << std::endl;
 			std::cout << "                                " << "-utcstart defaults to now" << std::endl;
 			std::cout << "                                " << "-utcend defaults to one day after utcstart" << std::endl;
 			std::cout << "                                " << "-planet defaults to sun" << std::endl;
+			std::cout << "                                " << "-threads searches on n threads, at most one per processor (0: one per processor); defaults to 1" << std::endl;
 			std::cout << std::endl;
 			std::cout << "Notes: " << std::endl;
 			std::cout << std::endl;
@@ -125,10 +162,12 @@ int main (int argc, char* argv[])
 
 		std::string command = input.getCmdOption ("-c");
 
+		const auto finder = input.cmdOptionExists ("-proxy") ? novas_utils::event_root_finder::chebyshev_proxy : novas_utils::event_root_finder::bracketing;
+
 		n_json rv;
 
 		auto& em = ephemeris::instance ();
-		em.open (em_path);
+		em.open (em_path, input.cmdOptionExists ("-mmap") ? ephemeris_access::mapped : ephemeris_access::buffered);
 
 		n_json eph_obj;
 
@@ -213,7 +252,11 @@ int main (int argc, char* argv[])
 				throw std::runtime_error ("start time of " + start.as_iso8601_str () + " must be less than end time of " + end.as_iso8601_str ());
 			}
 
-			rv[command] = planet_utils::get_moon_phase_events (start, end);
+			if (input.cmdOptionExists ("-single")) {
+				em.load_single (start.as_tdb () - 1.0, end.as_tdb () + 1.0);
+			}
+
+			rv[command] = planet_utils::get_moon_phase_events (start, end, finder);
 
 			n_json args;
 
@@ -279,7 +322,24 @@ int main (int argc, char* argv[])
 				}
 			}
 
-			rv[command] = planet_utils::get_rise_and_set_times (start, end, n_planet, lat, lon);
+			if (input.cmdOptionExists ("-single")) {
+				em.load_single (start.as_tdb () - 1.0, end.as_tdb () + 1.0);
+			}
+
+			unsigned threads = 1;
+
+			if (input.cmdOptionExists ("-threads")) {
+				std::string _threads = input.getCmdOption ("-threads");
+				char * parsed_end = nullptr;
+				errno = 0;
+				long count = strtol (_threads.c_str (), &parsed_end, 10);
+				if (parsed_end == _threads.c_str () || *parsed_end != '\0' || errno == ERANGE || count < 0 || count > (long)UINT_MAX) {
+					throw std::runtime_error ("invalid thread count: " + _threads);
+				}
+				threads = (unsigned)count;
+			}
+
+			rv[command] = planet_utils::get_rise_and_set_times (start, end, n_planet, lat, lon, threads, finder);
 
 			n_json args;
 
@@ -296,6 +356,10 @@ int main (int argc, char* argv[])
 			throw std::runtime_error ("Unknown command: " + command);
 		}
 
+		if (input.cmdOptionExists ("-stats")) {
+			rv["stats"] = stats_json (em.stats ());
+		}
+
 		std::cout << rv.dump () << std::endl;
 
 	}
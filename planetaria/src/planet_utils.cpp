@@ -7,10 +7,13 @@ n_json planet_utils::get_current_planetary_positions(astro_time lookup_time, std
 
     n_json rv;
 
-    for (auto planet : planets)
+    std::vector<sky_pos> places = novas_utils::load_planets_geocentric_equatorial(lookup_time, planets);
+
+    for (size_t i = 0; i < planets.size(); ++i)
     {
 
-        sky_pos sp = novas_utils::load_planet_geocentric_equatorial(lookup_time, planet);
+        novas_planet const &planet = planets[i];
+        sky_pos const &sp = places[i];
         auto [elon, elat] = novas_wrapper::w_equ2ecl(lookup_time, novas_constants::coord_equ, novas_constants::accuracy, sp.ra, sp.dec);
 
         double ecliptic_long = normalize_degrees(elon);
@@ -38,13 +41,13 @@ n_json planet_utils::get_current_planetary_positions(astro_time lookup_time, std
     return rv;
 }
 
-n_json planet_utils::get_moon_phase_events(astro_time begin_time, astro_time end_time)
+n_json planet_utils::get_moon_phase_events(astro_time begin_time, astro_time end_time, novas_utils::event_root_finder finder)
 {
 
     n_json rv;
 
     // MOON EVENTS
-    std::vector<astro_time> moon_times = novas_utils::find_new_and_full_moons(begin_time.as_utc(), end_time.as_utc());
+    std::vector<astro_time> moon_times = novas_utils::find_new_and_full_moons(begin_time.as_utc(), end_time.as_utc(), finder);
 
     std::sort(moon_times.begin(), moon_times.end(), [](auto &a, auto &b) {
         return a.as_utc() < b.as_utc();
@@ -69,7 +72,7 @@ n_json planet_utils::get_moon_phase_events(astro_time begin_time, astro_time end
     return rv;
 }
 
-n_json planet_utils::get_rise_and_set_times(astro_time begin_time, astro_time end_time, novas_planet planet, double observer_lat, double observer_lon)
+n_json planet_utils::get_rise_and_set_times(astro_time begin_time, astro_time end_time, novas_planet planet, double observer_lat, double observer_lon, unsigned threads, novas_utils::event_root_finder finder)
 {
 
     n_json rv;
@@ -78,7 +81,9 @@ n_json planet_utils::get_rise_and_set_times(astro_time begin_time, astro_time en
 
     make_on_surface(observer_lat, observer_lon, 10, 14, 1200, &geo_loc);
 
-    std::vector<planetary_event> v_pe = novas_utils::find_planetary_events(begin_time.as_utc(), end_time.as_utc(), planet, geo_loc);
+    std::vector<planetary_event> v_pe = (threads == 1)
+        ? novas_utils::find_planetary_events(begin_time.as_utc(), end_time.as_utc(), planet, geo_loc, finder)
+        : novas_utils::find_planetary_events(begin_time.as_utc(), end_time.as_utc(), planet, geo_loc, threads, finder);
 
     for (auto const &evt : v_pe)
     {